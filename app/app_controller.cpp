@@ -5,40 +5,49 @@
 #include <psapi.h>
 
 #include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <optional>
 
-#include "catalog_loader.hpp"
 #include "windows_location_provider.hpp"
 
 namespace app {
 
+namespace {
+// How often the catalog file is checked for changes when watching it
+constexpr std::chrono::seconds kCatalogPollInterval{2};
+
+// Copies one tick of star results for other threads. Their names are views
+// into the engine's catalog snapshot, so the copy holds the snapshot and
+// stays valid after the catalog or the engine is replaced.
+std::shared_ptr<std::vector<engine::CelestialResult>> SnapshotResults(
+    const std::vector<engine::CelestialResult>& results,
+    std::shared_ptr<const void> catalog) {
+  return std::shared_ptr<std::vector<engine::CelestialResult>>(
+      new std::vector<engine::CelestialResult>(results),
+      [catalog = std::move(catalog)](
+          std::vector<engine::CelestialResult>* copy) { delete copy; });
+}
+}  // namespace
+
 AppController::AppController() : state_(std::make_shared<AppState>()) {}
 
 AppController::~AppController() { Stop(); }
 
 bool AppController::Initialize(const AppConfig& config) {
   config_ = config;
+  init_time_ = std::chrono::steady_clock::now();
   state_->logging_enabled = config_.enable_logging;
 
-  // 1. Load Star Catalog
-  if (config_.catalog_path.ends_with(".json")) {
-    catalog_ =
-        engine::CatalogLoader::LoadStarDataFromJSON(config_.catalog_path);
-  }
-
-  if (catalog_.empty()) {
+  // 1. Check the catalog up front; loading it is left to the pipeline
+  if (!std::filesystem::exists(config_.catalog_path)) {
     std::cerr << "Error: Could not load catalog from " << config_.catalog_path
               << std::endl;
     return false;
   }
 
-  // 2. Load Ephemeris
-  if (!config_.ephemeris_path.empty()) {
-    ephemeris_ =
-        engine::CatalogLoader::LoadFromEphemeris(config_.ephemeris_path);
-  }
-
-  // 3. Setup Location Provider
+  // 2. Setup Location Provider
   if (config_.use_gps) {
     location_provider_ = std::make_shared<WindowsLocationProvider>();
   } else {
@@ -50,21 +59,51 @@ bool AppController::Initialize(const AppConfig& config) {
     }
   }
 
-  // 4. Setup Logger
+  // 3. Setup Logger
   if (config_.enable_logging) {
     logger_ = std::make_shared<Logger>();
   }
 
-  // 5. Setup Engine
-  engine_.SetCatalog(catalog_);
-  if (ephemeris_) {
-    engine_.SetEphemeris(ephemeris_);
-  }
-  result_buffer_.reserve(catalog_.size(), 15);
+  // 4. Load the catalog (or its snapshot) and the ephemeris concurrently.
+  // Large catalogs publish an engine over the bright stars first.
+  startup_options_ = engine::StartupOptions{
+      .catalog_path = config_.catalog_path,
+      .ephemeris_path = config_.ephemeris_path,
+      .prefetch_ephemeris = config_.prefetch_ephemeris,
+      .solar_system = config_.analytic_planets
+                          ? engine::SolarSystemMode::ANALYTIC
+                          : engine::SolarSystemMode::EPHEMERIS,
+      .ephemeris_preload = std::chrono::days(config_.ephemeris_preload_days),
+      .snapshot_path = config_.snapshot_path,
+      .filter = config_.catalog_filter,
+      .storage = config_.catalog_storage,
+      .pool = std::make_shared<engine::ThreadPool>(engine::ThreadPoolOptions{
+          .threads = config_.engine_threads, .cpus = config_.engine_cpus}),
+      .grain = config_.engine_grain,
+      .planet_cache_window =
+          std::chrono::seconds(config_.planet_cache_window_s)};
+  startup_ = std::make_unique<engine::StartupPipeline>(
+      startup_options_,
+      [this](std::shared_ptr<const engine::AstrometryEngine> engine,
+             engine::StartupStage stage) {
+        PublishEngine(std::move(engine), stage);
+      });
 
   return true;
 }
 
+void AppController::PublishEngine(
+    std::shared_ptr<const engine::AstrometryEngine> engine,
+    engine::StartupStage stage) {
+  if (engine) {
+    state_->star_count = engine->GetStarCount();
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+    engine_ = std::move(engine);
+  }
+  state_->startup_stage = stage;
+  engine_changed_.notify_all();
+}
+
 void AppController::Start() {
   if (state_->running && !worker_thread_) {
     if (logger_) {
@@ -72,25 +111,100 @@ void AppController::Start() {
     }
     worker_thread_ =
         std::make_unique<std::thread>(&AppController::RunWorker, this);
+    if (config_.watch_catalog) {
+      watcher_thread_ =
+          std::make_unique<std::thread>(&AppController::WatchCatalog, this);
+    }
   }
 }
 
 void AppController::Stop() {
   state_->running = false;
+  {
+    // Orders the flag before the worker's predicate check
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+  }
+  engine_changed_.notify_all();
   if (worker_thread_ && worker_thread_->joinable()) {
     worker_thread_->join();
     worker_thread_.reset();
   }
+  if (watcher_thread_ && watcher_thread_->joinable()) {
+    watcher_thread_->join();
+    watcher_thread_.reset();
+  }
+  startup_.reset();
   if (logger_) {
     logger_->Stop();
   }
 }
 
+void AppController::WatchCatalog() {
+  std::error_code error;
+  auto loaded = std::filesystem::last_write_time(config_.catalog_path, error);
+  std::optional<std::filesystem::file_time_type> pending;
+
+  while (state_->running) {
+    {
+      std::unique_lock<std::mutex> lock(engine_mutex_);
+      engine_changed_.wait_for(lock, kCatalogPollInterval,
+                               [&] { return !state_->running; });
+    }
+    if (!state_->running) break;
+
+    // Let the first load finish; a failed one is retried on the next change
+    auto stage = startup_->stage();
+    if (stage != engine::StartupStage::COMPLETE &&
+        stage != engine::StartupStage::FAILED) {
+      continue;
+    }
+
+    auto modified =
+        std::filesystem::last_write_time(config_.catalog_path, error);
+    if (error || modified == loaded) {
+      pending.reset();
+      continue;
+    }
+    // A file still being written changes between polls; wait for it to
+    // settle before reading it
+    if (pending != modified) {
+      pending = modified;
+      continue;
+    }
+    loaded = modified;
+    pending.reset();
+
+    // Build the new engine in the background while the worker keeps
+    // calculating with the current one, which stays in place if the new
+    // catalog cannot be loaded. No bright stage: that would be a step back.
+    auto options = startup_options_;
+    options.progressive_stars = std::numeric_limits<size_t>::max();
+    engine::StartupPipeline reload(
+        std::move(options),
+        [this](std::shared_ptr<const engine::AstrometryEngine> engine,
+               engine::StartupStage stage) {
+          if (!engine) return;
+          PublishEngine(std::move(engine), stage);
+          ++state_->catalog_reloads;
+        });
+    reload.Wait();
+  }
+}
+
 void AppController::RunWorker() {
   // Initialize COM for this thread (Windows specific)
   HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
   while (state_->running) {
+    // Nothing to calculate with until the first engine is published
+    std::shared_ptr<const engine::AstrometryEngine> current;
+    {
+      std::unique_lock<std::mutex> lock(engine_mutex_);
+      engine_changed_.wait(lock, [&] { return engine_ || !state_->running; });
+      current = engine_;
+    }
+    if (!current) break;
+
     auto obs = location_provider_->GetLocation();
     state_->gps_active = config_.use_gps;
 
@@ -101,29 +215,28 @@ void AppController::RunWorker() {
 
     auto now = std::chrono::system_clock::now();
 
-    engine::FilterCriteria engine_filter;
-    engine::SortCriteria star_sort;
-    engine::SortCriteria solar_sort;
+    engine::SkyQuery query;
     {
       std::lock_guard<std::mutex> lock(state_->filter_mutex);
-      engine_filter = state_->filter;
+      query.filter = state_->filter;
     }
     {
       std::lock_guard<std::mutex> lock(state_->sort_mutex);
-      star_sort = state_->star_sort;
-      solar_sort = state_->solar_sort;
+      query.star_sort = state_->star_sort;
+      query.solar_sort = state_->solar_sort;
     }
 
     // Use persistent buffer to minimize heap churn
     auto start_time = std::chrono::high_resolution_clock::now();
-    engine_.CalculateZenithProximity(result_buffer_, obs, engine_filter,
-                                     star_sort, now);
-    engine_.CalculateSolarSystem(result_buffer_, obs, engine_filter, solar_sort,
-                                 now);
+    current->CalculateSky(result_buffer_, obs, query, now);
     auto end_time = std::chrono::high_resolution_clock::now();
 
     std::chrono::duration<double, std::milli> duration = end_time - start_time;
     state_->engine_latency_ms = duration.count();
+    // Zero on ticks that read nothing, e.g. served by the planet cache
+    auto reads = current->TakeEphemerisReadStats();
+    state_->ephemeris_read_us = reads.mean_us;
+    state_->ephemeris_read_max_us = reads.max_us;
 
     // Track memory usage (Windows specific)
     PROCESS_MEMORY_COUNTERS_EX pmc;
@@ -133,13 +246,13 @@ void AppController::RunWorker() {
     }
 
     // Snapshot results for the UI thread
-    auto star_results = std::make_shared<std::vector<engine::CelestialResult>>(
-        result_buffer_.star_results);
+    auto star_results =
+        SnapshotResults(result_buffer_.star_results, result_buffer_.catalog);
     auto solar_results = std::make_shared<std::vector<engine::SolarBody>>(
         result_buffer_.solar_results);
 
     if (logger_) {
-      logger_->Log(obs, *star_results);
+      logger_->Log(obs, star_results);
     }
 
     {
@@ -148,14 +261,27 @@ void AppController::RunWorker() {
       state_->latest_solar_results = solar_results;
       state_->last_calc_time = now;
     }
+    if (state_->first_result_ms < 0.0) {
+      std::chrono::duration<double, std::milli> startup =
+          std::chrono::steady_clock::now() - init_time_;
+      state_->first_result_ms = startup.count();
+    }
+    {
+      std::lock_guard<std::mutex> lock(state_->startup_mutex);
+      state_->startup_timings = startup_->timings();
+    }
 
     // Trigger UI refresh
     if (refresh_callback_) {
       refresh_callback_();
     }
 
-    std::this_thread::sleep_for(
-        std::chrono::milliseconds(config_.refresh_rate_ms));
+    // Sleep until the next tick, or until the pipeline publishes a more
+    // complete engine
+    std::unique_lock<std::mutex> lock(engine_mutex_);
+    engine_changed_.wait_for(
+        lock, std::chrono::milliseconds(config_.refresh_rate_ms),
+        [&] { return engine_ != current || !state_->running; });
   }
 
   if (SUCCEEDED(hr)) {
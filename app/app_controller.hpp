@@ -1,8 +1,11 @@
 #ifndef ZENITH_FINDER_APP_APP_CONTROLLER_HPP_
 #define ZENITH_FINDER_APP_APP_CONTROLLER_HPP_
 
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -11,6 +14,7 @@
 #include "engine.hpp"
 #include "location_provider.hpp"
 #include "logger.hpp"
+#include "startup_pipeline.hpp"
 
 namespace app {
 
@@ -19,8 +23,28 @@ struct AppConfig {
   bool use_gps = false;
   bool enable_logging = false;
   std::string catalog_path;
+  engine::CatalogFilter catalog_filter;  // Stars dropped at load time
+  std::string snapshot_path;  // Engine snapshot cache; empty disables it
+  bool watch_catalog = false;  // Reload the catalog when its file changes
   std::string ephemeris_path;
+  bool prefetch_ephemeris = false;  // Whole file in RAM; planets in parallel
+  int ephemeris_preload_days = 0;   // Span kept in RAM around now; 0 = off
+  bool analytic_planets = false;    // Analytic theory instead of the file
   int refresh_rate_ms = 1000;
+
+  // Engine thread pool: worker count (0 = every hardware thread), smallest
+  // number of stars per task, and CPUs to pin the workers to (empty = any).
+  size_t engine_threads = 0;
+  size_t engine_grain = engine::AstrometryEngine::kDefaultGrain;
+  std::vector<int> engine_cpus;
+
+  // In-memory star layout; COMPACT trades ~0.25 mas for a fifth of the
+  // coordinate memory, a little over half the catalog as a whole
+  engine::CatalogStorage catalog_storage = engine::CatalogStorage::FULL;
+
+  // Planet positions come from fits over windows of this many seconds
+  // (0 = evaluated exactly every tick)
+  int planet_cache_window_s = 0;
 };
 
 class AppController {
@@ -32,6 +56,9 @@ class AppController {
   AppController(const AppController&) = delete;
   AppController& operator=(const AppController&) = delete;
 
+  // Starts loading the catalog and ephemeris in the background and returns.
+  // Results appear in the state once the first engine is published; see
+  // AppState::startup_stage. Returns false if the catalog file is missing.
   bool Initialize(const AppConfig& config);
   void Start();
   void Stop();
@@ -45,6 +72,9 @@ class AppController {
 
  private:
   void RunWorker();
+  void WatchCatalog();
+  void PublishEngine(std::shared_ptr<const engine::AstrometryEngine> engine,
+                     engine::StartupStage stage);
 
   std::shared_ptr<AppState> state_;
   AppConfig config_;
@@ -52,15 +82,19 @@ class AppController {
   std::shared_ptr<LocationProvider> location_provider_;
   std::shared_ptr<Logger> logger_;
   std::unique_ptr<std::thread> worker_thread_;
+  std::unique_ptr<std::thread> watcher_thread_;
 
   std::function<void()> refresh_callback_;
 
-  // Cache for engine data
-  std::vector<engine::Star> catalog_;
-  std::shared_ptr<t_calcephbin> ephemeris_;
+  // Engines are published by the startup pipeline and replaced, never
+  // modified, so the worker takes its own reference for each tick.
+  std::unique_ptr<engine::StartupPipeline> startup_;
+  engine::StartupOptions startup_options_;  // Reused to reload the catalog
+  std::mutex engine_mutex_;
+  std::condition_variable engine_changed_;
+  std::shared_ptr<const engine::AstrometryEngine> engine_;
+  std::chrono::steady_clock::time_point init_time_;
 
-  // Optimized engine and buffers
-  engine::AstrometryEngine engine_;
   engine::ResultBuffer result_buffer_;
 };
 
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "engine.hpp"
+#include "startup_pipeline.hpp"
 
 namespace app {
 
@@ -35,9 +36,21 @@ struct AppState {
 
   // Performance Metrics
   std::atomic<double> engine_latency_ms{0.0};
+  std::atomic<double> ephemeris_read_us{0.0};      // Mean lookup, last tick
+  std::atomic<double> ephemeris_read_max_us{0.0};  // Slowest lookup
   std::atomic<double> ui_render_time_ms{0.0};
   std::atomic<long long> memory_usage_kb{0};
   std::atomic<bool> show_debug_overlay{false};
+
+  // Startup progress. Results are available from BRIGHT_READY on;
+  // star_count is the size of the catalog behind them.
+  std::atomic<engine::StartupStage> startup_stage{
+      engine::StartupStage::LOADING};
+  std::atomic<size_t> star_count{0};
+  std::atomic<double> first_result_ms{-1.0};  // From Initialize; -1 until then
+  std::atomic<int> catalog_reloads{0};
+  std::mutex startup_mutex;
+  engine::StartupTimings startup_timings;
 };
 
 }  // namespace app
@@ -1,17 +1,42 @@
 #include "config_manager.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <utility>
 
 namespace app {
 
+namespace {
+const char* StorageName(engine::CatalogStorage storage) {
+  switch (storage) {
+    case engine::CatalogStorage::COMPACT:
+      return "compact";
+    case engine::CatalogStorage::MAPPED:
+      return "mapped";
+    case engine::CatalogStorage::FULL:
+      break;
+  }
+  return "full";
+}
+}  // namespace
+
 Config ConfigManager::Load(const std::filesystem::path& path) {
   Config config;
   config.observer = {0.0, 0.0, 0.0};
   config.refresh_rate_ms = 1000;
   config.catalog_path = "stars.json";
+  config.watch_catalog = false;
+  config.prefetch_ephemeris = false;
+  config.ephemeris_preload_days = 0;
+  config.analytic_planets = false;
+  config.engine_threads = 0;
+  config.engine_grain = engine::AstrometryEngine::kDefaultGrain;
+  config.catalog_storage = engine::CatalogStorage::FULL;
+  config.planet_cache_window_s = 0;
 
   if (!std::filesystem::exists(path)) {
     return config;
@@ -25,8 +50,55 @@ Config ConfigManager::Load(const std::filesystem::path& path) {
       config.observer.altitude = (*obs)["altitude"].value_or(0.0);
     }
     config.catalog_path = data["catalog"]["path"].value_or("stars.json");
+    config.snapshot_path = data["catalog"]["snapshot"].value_or("");
+    config.watch_catalog = data["catalog"]["watch"].value_or(false);
+    if (auto cat = data["catalog"].as_table()) {
+      auto& filter = config.catalog_filter;
+      filter.max_magnitude = static_cast<float>(
+          (*cat)["max_magnitude"].value_or(
+              static_cast<double>(filter.max_magnitude)));
+      filter.min_dec = (*cat)["min_declination"].value_or(filter.min_dec);
+      filter.max_dec = (*cat)["max_declination"].value_or(filter.max_dec);
+      auto grade = [&](const char* key) -> char {
+        std::string value = (*cat)[key].value_or(std::string());
+        return value.empty() ? 0 : value[0];
+      };
+      filter.max_coo_qual = grade("max_coo_qual");
+      filter.max_pm_qual = grade("max_pm_qual");
+      filter.max_plx_qual = grade("max_plx_qual");
+    }
     config.ephemeris_path = data["ephemeris"]["path"].value_or("");
+    config.prefetch_ephemeris = data["ephemeris"]["prefetch"].value_or(false);
+    config.ephemeris_preload_days = static_cast<int>(std::max<int64_t>(
+        0, data["ephemeris"]["preload_days"].value_or(int64_t{0})));
+    config.analytic_planets = data["ephemeris"]["analytic"].value_or(false);
     config.refresh_rate_ms = data["app"]["refresh_rate_ms"].value_or(1000);
+
+    if (auto eng = data["engine"].as_table()) {
+      config.engine_threads = static_cast<size_t>(
+          std::max<int64_t>(0, (*eng)["threads"].value_or(int64_t{0})));
+      config.engine_grain = static_cast<size_t>(std::max<int64_t>(
+          1, (*eng)["grain"].value_or(static_cast<int64_t>(
+                 engine::AstrometryEngine::kDefaultGrain))));
+      if (auto cpus = (*eng)["cpus"].as_array()) {
+        for (const auto& cpu : *cpus) {
+          if (auto value = cpu.value<int64_t>()) {
+            config.engine_cpus.push_back(static_cast<int>(*value));
+          }
+        }
+      }
+      std::string storage = (*eng)["storage"].value_or(std::string("full"));
+      if (storage == "compact") {
+        config.catalog_storage = engine::CatalogStorage::COMPACT;
+      } else if (storage == "mapped") {
+        config.catalog_storage = engine::CatalogStorage::MAPPED;
+      } else if (storage != "full") {
+        std::cerr << "Warning: Unknown engine storage '" << storage
+                  << "', using full" << std::endl;
+      }
+      config.planet_cache_window_s = static_cast<int>(std::max<int64_t>(
+          0, (*eng)["planet_cache_window"].value_or(int64_t{0})));
+    }
   } catch (const toml::parse_error& e) {
     std::cerr << "TOML Parsing Error: " << e.what() << std::endl;
   }
@@ -36,13 +108,55 @@ Config ConfigManager::Load(const std::filesystem::path& path) {
 
 void ConfigManager::Save(const std::filesystem::path& path,
                          const Config& config) {
+  toml::array cpus;
+  for (int cpu : config.engine_cpus) {
+    cpus.push_back(cpu);
+  }
+
+  // Only filter settings that differ from keeping everything are written
+  const engine::CatalogFilter keep_all;
+  const auto& filter = config.catalog_filter;
+  toml::table catalog{{"path", config.catalog_path}};
+  if (!config.snapshot_path.empty()) {
+    catalog.insert("snapshot", config.snapshot_path);
+  }
+  if (config.watch_catalog) {
+    catalog.insert("watch", true);
+  }
+  if (filter.max_magnitude != keep_all.max_magnitude) {
+    catalog.insert("max_magnitude", static_cast<double>(filter.max_magnitude));
+  }
+  if (filter.min_dec != keep_all.min_dec) {
+    catalog.insert("min_declination", filter.min_dec);
+  }
+  if (filter.max_dec != keep_all.max_dec) {
+    catalog.insert("max_declination", filter.max_dec);
+  }
+  for (auto [key, grade] : {std::pair{"max_coo_qual", filter.max_coo_qual},
+                            std::pair{"max_pm_qual", filter.max_pm_qual},
+                            std::pair{"max_plx_qual", filter.max_plx_qual}}) {
+    if (grade != 0) catalog.insert(key, std::string(1, grade));
+  }
+
   auto data = toml::table{
       {"observer", toml::table{{"latitude", config.observer.latitude},
                                {"longitude", config.observer.longitude},
                                {"altitude", config.observer.altitude}}},
-      {"catalog", toml::table{{"path", config.catalog_path}}},
-      {"ephemeris", toml::table{{"path", config.ephemeris_path}}},
+      {"catalog", catalog},
+      {"ephemeris",
+       toml::table{{"path", config.ephemeris_path},
+                   {"prefetch", config.prefetch_ephemeris},
+                   {"preload_days", config.ephemeris_preload_days},
+                   {"analytic", config.analytic_planets}}},
       {"app", toml::table{{"refresh_rate_ms", config.refresh_rate_ms}}},
+      {"engine",
+       toml::table{
+           {"threads", static_cast<int64_t>(config.engine_threads)},
+           {"grain", static_cast<int64_t>(config.engine_grain)},
+           {"cpus", cpus},
+           {"storage", StorageName(config.catalog_storage)},
+           {"planet_cache_window", config.planet_cache_window_s},
+       }},
   };
 
   std::ofstream file(path);
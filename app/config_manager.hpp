@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <vector>
 
 // clang-format off
 namespace toml {
@@ -19,8 +20,19 @@ namespace app {
 struct Config {
   engine::Observer observer;
   std::string catalog_path;
+  engine::CatalogFilter catalog_filter;
+  std::string snapshot_path;
+  bool watch_catalog;
   std::string ephemeris_path;
+  bool prefetch_ephemeris;
+  int ephemeris_preload_days;
+  bool analytic_planets;
   int refresh_rate_ms;
+  size_t engine_threads;
+  size_t engine_grain;
+  std::vector<int> engine_cpus;
+  engine::CatalogStorage catalog_storage;
+  int planet_cache_window_s;
 };
 
 class ConfigManager {
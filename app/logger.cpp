@@ -30,14 +30,15 @@ void Logger::Stop() {
   }
 }
 
-void Logger::Log(const engine::Observer& obs,
-                 const std::vector<engine::CelestialResult>& results) {
+void Logger::Log(
+    const engine::Observer& obs,
+    std::shared_ptr<const std::vector<engine::CelestialResult>> results) {
   if (!running_) return;
 
   LogEntry entry;
   entry.time = std::chrono::system_clock::now();
   entry.obs = obs;
-  entry.results = results;
+  entry.results = std::move(results);
 
   {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -78,7 +79,7 @@ void Logger::WriteLoop() {
                       tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday,
                       tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec);
 
-      for (const auto& res : entry.results) {
+      for (const auto& res : *entry.results) {
         file_ << std::format(
             "{},{:.6f},{:.6f},{:.2f},{},{:.4f},{:.4f},{:.4f}\n", time_str,
             entry.obs.latitude, entry.obs.longitude, entry.obs.altitude,
@@ -4,6 +4,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
@@ -19,8 +20,11 @@ class Logger {
   Logger();
   ~Logger();
 
+  // Queues one tick of results. Result names are views into the engine's
+  // catalog, so the entry shares the caller's snapshot, which keeps that
+  // catalog alive, rather than copying it.
   void Log(const engine::Observer& obs,
-           const std::vector<engine::CelestialResult>& results);
+           std::shared_ptr<const std::vector<engine::CelestialResult>> results);
   void Start();
   void Stop();
 
@@ -28,7 +32,7 @@ class Logger {
   struct LogEntry {
     std::chrono::system_clock::time_point time;
     engine::Observer obs;
-    std::vector<engine::CelestialResult> results;
+    std::shared_ptr<const std::vector<engine::CelestialResult>> results;
   };
 
   void WriteLoop();
@@ -12,6 +12,7 @@
 #include <memory>
 
 #include "app_controller.hpp"
+#include "catalog_loader.hpp"
 #include "config_manager.hpp"
 #include "ui/zenith_ui.hpp"
 
@@ -39,8 +40,19 @@ int main(int argc, char** argv) {
   app::AppConfig app_config;
   app_config.manual_location = config_file.observer;
   app_config.catalog_path = config_file.catalog_path;
+  app_config.catalog_filter = config_file.catalog_filter;
+  app_config.snapshot_path = config_file.snapshot_path;
+  app_config.watch_catalog = config_file.watch_catalog;
   app_config.ephemeris_path = config_file.ephemeris_path;
+  app_config.prefetch_ephemeris = config_file.prefetch_ephemeris;
+  app_config.ephemeris_preload_days = config_file.ephemeris_preload_days;
+  app_config.analytic_planets = config_file.analytic_planets;
   app_config.refresh_rate_ms = config_file.refresh_rate_ms;
+  app_config.engine_threads = config_file.engine_threads;
+  app_config.engine_grain = config_file.engine_grain;
+  app_config.engine_cpus = config_file.engine_cpus;
+  app_config.catalog_storage = config_file.catalog_storage;
+  app_config.planet_cache_window_s = config_file.planet_cache_window_s;
 
   app.add_option("--lat", app_config.manual_location.latitude,
                  "Observer latitude (degrees)")
@@ -53,13 +65,56 @@ int main(int argc, char** argv) {
       ->default_val(0.0);
   app.add_flag("--gps", app_config.use_gps, "Use system GPS location service");
   app.add_option("--catalog", app_config.catalog_path,
-                 "Path to the star catalog CSV file")
+                 "Path to the star catalog (JSON, CSV or binary .zcat)")
       ->check(CLI::ExistingFile);
+  app.add_option("--snapshot", app_config.snapshot_path,
+                 "Engine snapshot file, reused while the catalog is "
+                 "unchanged");
+  app.add_flag("--watch-catalog", app_config.watch_catalog,
+               "Reload the catalog whenever its file changes");
+  app.add_option("--max-magnitude",
+                 app_config.catalog_filter.max_magnitude,
+                 "Skip stars fainter than this magnitude when loading");
+  app.add_flag("--prefetch-ephemeris", app_config.prefetch_ephemeris,
+               "Read the ephemeris into memory and compute planets in "
+               "parallel");
+  app.add_option("--preload-ephemeris", app_config.ephemeris_preload_days,
+                 "Days of the ephemeris kept in memory around now "
+                 "(0 = read on demand)")
+      ->check(CLI::NonNegativeNumber);
+  app.add_flag("--analytic-planets", app_config.analytic_planets,
+               "Compute the Sun, Moon and planets from an analytic theory "
+               "instead of the ephemeris");
+  app.add_option("--threads", app_config.engine_threads,
+                 "Engine worker threads (0 = all hardware threads)");
+  app.add_option("--planet-cache-window", app_config.planet_cache_window_s,
+                 "Seconds per fitted planet window (0 = exact every tick)")
+      ->check(CLI::Range(
+          int64_t{0},
+          std::chrono::duration_cast<std::chrono::seconds>(
+              engine::AstrometryEngine::kMaxPlanetCacheWindow)
+              .count()));
   app.add_flag("--log", app_config.enable_logging,
                "Enable logging to a timestamped CSV file");
 
+  std::string convert_output;
+  bool convert_tiled = false;
+  app.add_option("--convert-catalog", convert_output,
+                 "Write the catalog as a binary .zcat file and exit");
+  app.add_flag("--tiled", convert_tiled,
+               "With --convert-catalog, write a tiled, magnitude-sorted file "
+               "for storage = 'mapped'");
+
   CLI11_PARSE(app, argc, argv);
 
+  if (!convert_output.empty()) {
+    bool converted = engine::CatalogLoader::ConvertToBinaryCatalog(
+        app_config.catalog_path, convert_output, app_config.catalog_filter,
+        convert_tiled);
+    if (SUCCEEDED(hr_com)) CoUninitialize();
+    return converted ? 0 : 1;
+  }
+
   auto controller = std::make_shared<app::AppController>();
   global_controller = controller;
 
@@ -14,6 +14,25 @@
 
 namespace app {
 
+namespace {
+ftxui::Element RenderCatalogStatus(engine::StartupStage stage,
+                                   size_t star_count) {
+  switch (stage) {
+    case engine::StartupStage::LOADING:
+      return ftxui::text("Catalog: Loading") |
+             ftxui::color(ftxui::Color::Yellow);
+    case engine::StartupStage::BRIGHT_READY:
+      return ftxui::text(std::format("Catalog: {} bright", star_count)) |
+             ftxui::color(ftxui::Color::Yellow);
+    case engine::StartupStage::COMPLETE:
+      return ftxui::text(std::format("Catalog: {} stars", star_count));
+    case engine::StartupStage::FAILED:
+      break;
+  }
+  return ftxui::text("Catalog: Failed") | ftxui::color(ftxui::Color::Red);
+}
+}  // namespace
+
 ZenithUI::ZenithUI(std::shared_ptr<AppState> state)
     : state_(std::move(state)),
       screen_(ftxui::ScreenInteractive::Fullscreen()) {
@@ -369,6 +388,7 @@ ftxui::Element ZenithUI::RenderSidebar(const engine::Observer& loc,
       ftxui::text(
           std::format("Log: {}", state_->logging_enabled ? "On" : "Off")),
       ftxui::text("Time: " + time_str),
+      RenderCatalogStatus(state_->startup_stage, state_->star_count),
   });
 
   auto location_box = ftxui::vbox({
@@ -386,10 +406,17 @@ ftxui::Element ZenithUI::RenderSidebar(const engine::Observer& loc,
     auto debug_box = ftxui::vbox({
         ftxui::text(std::format("Engine Latency: {:.2f} ms",
                                 state_->engine_latency_ms.load())),
+        ftxui::text(std::format("Ephemeris Read: {:.1f} us (max {:.1f})",
+                                state_->ephemeris_read_us.load(),
+                                state_->ephemeris_read_max_us.load())),
         ftxui::text(std::format("UI Render Time: {:.2f} ms",
                                 state_->ui_render_time_ms.load())),
         ftxui::text(std::format("Memory Usage:   {} KB",
                                 state_->memory_usage_kb.load())),
+        ftxui::text(std::format("First Result:   {:.0f} ms",
+                                state_->first_result_ms.load())),
+        ftxui::text(std::format("Reloads:        {}",
+                                state_->catalog_reloads.load())),
     });
     sidebar = ftxui::vbox({
         sidebar,
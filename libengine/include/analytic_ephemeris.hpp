@@ -0,0 +1,62 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_ANALYTIC_EPHEMERIS_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_ANALYTIC_EPHEMERIS_HPP_
+
+#include <array>
+#include <span>
+
+namespace engine {
+
+// Bodies of the analytic theory.
+enum class AnalyticBody {
+  SUN,
+  MERCURY,
+  VENUS,
+  EARTH,
+  MARS,
+  JUPITER,
+  SATURN,
+  URANUS,
+  NEPTUNE,
+  PLUTO,
+  MOON
+};
+
+struct BodyState {
+  std::array<double, 3> position{};  // AU
+  std::array<double, 3> velocity{};  // AU/day
+};
+
+// Heliocentric states of `body`, equatorial J2000 (ICRS to within 0.02"),
+// at each of the TDB Julian dates `jd_tdb`, for use without an ephemeris
+// file. `states` must be at least as long as `jd_tdb`.
+//
+// The planets and the Earth follow the truncated VSOP87D series of Meeus,
+// Astronomical Algorithms, appendix III; Pluto his chapter 37 and the Moon
+// his truncated ELP-2000/82 series of chapter 47. Heliocentric errors
+// within a century or two of J2000:
+//   Mercury, Venus, Earth            ~1"
+//   Mars, Jupiter, Saturn            a few arcseconds
+//   Uranus, Neptune                  a few arcseconds
+//   Pluto                            a few arcseconds, 1885-2099 only
+// Seen from the Earth, a planet's error grows by its heliocentric distance
+// over its distance from the Earth (Mars near opposition ~10"). The Moon is
+// within ~10" in longitude and ~4" in latitude.
+//
+// Each body has its own kernel over compile-time coefficient tables, with
+// branch-free loops over blocks of time samples.
+void AnalyticStates(AnalyticBody body, std::span<const double> jd_tdb,
+                    std::span<BodyState> states);
+
+// Geometric geocentric position of the Moon: longitude and latitude in
+// degrees, referred to the mean ecliptic and equinox of date, and distance
+// in kilometers.
+struct LunarPosition {
+  double longitude = 0.0;
+  double latitude = 0.0;
+  double distance_km = 0.0;
+};
+LunarPosition AnalyticMoon(double jd_tdb);
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_ANALYTIC_EPHEMERIS_HPP_
@@ -0,0 +1,172 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_BINARY_CATALOG_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_BINARY_CATALOG_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include "engine.hpp"
+#include "mapped_file.hpp"
+#include "sky_index.hpp"
+
+namespace engine {
+
+// Columns of a .zcat file, in file order.
+enum class ZcatColumn : uint32_t {
+  RA,               // double, degrees
+  DEC,              // double, degrees
+  PMRA,             // double, mas/yr
+  PMDEC,            // double, mas/yr
+  PARALLAX,         // double, mas
+  RADIAL_VELOCITY,  // double, km/s
+  FLUX,             // float, magnitude
+  FLUX_ERR,         // float
+  CATALOG_ID,       // int64
+  COO_QUAL,         // char
+  PM_QUAL,          // char
+  PLX_QUAL,         // char
+  RVZ_QUAL,         // char
+  FLUX_QUAL,        // char
+  NAME_OFFSETS,     // uint64, star_count + 1 offsets into STRING_POOL
+  CATALOG_OFFSETS,  // uint64, star_count + 1 offsets into STRING_POOL
+  IDS_OFFSETS,      // uint64, star_count + 1 offsets into STRING_POOL
+  STRING_POOL,      // char, every string back to back, not terminated
+  TILE_OFFSETS,     // uint64, tile count + 1 row offsets; empty if untiled
+  TILE_CAPS,        // SkyCap per tile; empty if untiled
+  COUNT
+};
+
+constexpr uint32_t kZcatVersion = 2;
+constexpr size_t kZcatAlignment = 64;
+
+struct ZcatColumnExtent {
+  uint64_t offset;  // From the start of the file, kZcatAlignment aligned
+  uint64_t bytes;
+};
+
+// Fixed header at the start of every .zcat file. All values are stored in
+// the writer's native byte order; `byte_order` lets readers reject files
+// written on a machine of the other endianness.
+//
+// A tiled file stores its rows grouped by SkyIndex leaf tile at
+// `tile_depth`, brightest first within each tile, so that a query can read
+// only the tiles it needs and stop each one at a magnitude limit. Untiled
+// files keep the order they were written in and have a negative depth.
+struct ZcatHeader {
+  char magic[4];        // "ZCAT"
+  uint32_t version;     // kZcatVersion
+  uint32_t byte_order;  // 0x01020304 as written
+  uint32_t column_count;
+  int32_t tile_depth;
+  uint32_t reserved;
+  uint64_t star_count;
+  uint64_t file_size;
+  double max_proper_motion;  // Largest total proper motion, degrees per year
+  ZcatColumnExtent columns[static_cast<size_t>(ZcatColumn::COUNT)];
+};
+
+// Star catalog backed by a memory-mapped .zcat file. Columns are exposed as
+// spans and strings as views straight into the mapping, so opening a
+// catalog does no parsing and no per-star allocation. Copies share the
+// mapping.
+class BinaryCatalog {
+ public:
+  // Maps and validates a .zcat file, or returns nullptr if it is missing,
+  // truncated, or of another version or byte order.
+  static std::shared_ptr<const BinaryCatalog> Open(
+      const std::filesystem::path& path);
+
+  // Writes a catalog in .zcat format, tiled (see ZcatHeader) if requested.
+  // The file is written as `path`.tmp and renamed over `path`, so readers
+  // never see it half-written. Returns false on I/O errors, or if the
+  // catalog has more than 2^32 - 1 stars (rows are 32-bit; Open rejects
+  // such files too).
+  static bool Write(const std::filesystem::path& path,
+                    std::span<const Star> catalog, bool tiled = false);
+
+  size_t size() const { return star_count_; }
+
+  bool tiled() const { return header_->tile_depth >= 0; }
+  int tile_depth() const { return header_->tile_depth; }
+  double max_proper_motion() const { return header_->max_proper_motion; }
+
+  // Leaf tile t holds rows [tile_offsets()[t], tile_offsets()[t + 1]) and
+  // has bounding cap tile_caps()[t]. Both are empty for untiled files.
+  std::span<const uint64_t> tile_offsets() const {
+    return Column<uint64_t>(ZcatColumn::TILE_OFFSETS);
+  }
+  std::span<const SkyCap> tile_caps() const {
+    return Column<SkyCap>(ZcatColumn::TILE_CAPS);
+  }
+
+  std::span<const double> ra() const { return Column<double>(ZcatColumn::RA); }
+  std::span<const double> dec() const {
+    return Column<double>(ZcatColumn::DEC);
+  }
+  std::span<const double> pmra() const {
+    return Column<double>(ZcatColumn::PMRA);
+  }
+  std::span<const double> pmdec() const {
+    return Column<double>(ZcatColumn::PMDEC);
+  }
+  std::span<const double> parallax() const {
+    return Column<double>(ZcatColumn::PARALLAX);
+  }
+  std::span<const double> radial_velocity() const {
+    return Column<double>(ZcatColumn::RADIAL_VELOCITY);
+  }
+  std::span<const float> flux() const {
+    return Column<float>(ZcatColumn::FLUX);
+  }
+  std::span<const float> flux_err() const {
+    return Column<float>(ZcatColumn::FLUX_ERR);
+  }
+  std::span<const int64_t> catalog_id() const {
+    return Column<int64_t>(ZcatColumn::CATALOG_ID);
+  }
+  std::span<const char> quality(ZcatColumn column) const {
+    return Column<char>(column);
+  }
+
+  std::string_view name(size_t i) const {
+    return String(ZcatColumn::NAME_OFFSETS, i);
+  }
+  std::string_view catalog(size_t i) const {
+    return String(ZcatColumn::CATALOG_OFFSETS, i);
+  }
+  std::string_view ids(size_t i) const {
+    return String(ZcatColumn::IDS_OFFSETS, i);
+  }
+
+  // Copies one star out of the mapping.
+  Star GetStar(size_t i) const;
+
+  // The mapping every view points into.
+  const std::shared_ptr<const MappedFile>& file() const { return file_; }
+
+ private:
+  BinaryCatalog() = default;
+
+  template <typename T>
+  std::span<const T> Column(ZcatColumn column) const {
+    const auto& extent = header_->columns[static_cast<size_t>(column)];
+    return {reinterpret_cast<const T*>(file_->data() + extent.offset),
+            static_cast<size_t>(extent.bytes / sizeof(T))};
+  }
+
+  std::string_view String(ZcatColumn offsets, size_t i) const {
+    auto bounds = Column<uint64_t>(offsets);
+    return {pool_ + bounds[i], static_cast<size_t>(bounds[i + 1] - bounds[i])};
+  }
+
+  std::shared_ptr<const MappedFile> file_;
+  const ZcatHeader* header_ = nullptr;
+  const char* pool_ = nullptr;
+  size_t star_count_ = 0;
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_BINARY_CATALOG_HPP_
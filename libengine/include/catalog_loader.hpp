@@ -1,8 +1,10 @@
 #ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_CATALOG_LOADER_HPP_
 #define ZENITH_FINDER_LIBENGINE_INCLUDE_CATALOG_LOADER_HPP_
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -10,26 +12,68 @@ extern "C" {
 #include <calceph.h>
 }
 
+#include "binary_catalog.hpp"
 #include "engine.hpp"
+#include "thread_pool.hpp"
 
 namespace engine {
 
+// A catalog row that was skipped while loading, and why.
+struct CatalogRowError {
+  size_t line;  // 1-based line number in the file
+  std::string reason;
+};
+
 // CatalogLoader provides static methods to load astronomical data from
 // various file formats, including star catalogs and planetary ephemeris.
 class CatalogLoader {
  public:
-  // Loads star data from a CSV formatted file.
+  // Loads star data from a CSV file. The first line is a header; columns
+  // follow the order of the Star fields (name, catalog, catalog_id, ra, dec,
+  // coo_qual, ..., flux_qual, ids) and rows may stop after dec. The file is
+  // memory-mapped and parsed in newline-aligned chunks on `pool`. Malformed
+  // rows are skipped and reported on stderr and, if given, in `bad_rows`.
+  // Rows that `filter` rejects are dropped while parsing.
   static std::vector<Star> LoadStarDataFromCSV(
-      const std::filesystem::path& path);
+      const std::filesystem::path& path, const CatalogFilter& filter = {},
+      std::vector<CatalogRowError>* bad_rows = nullptr,
+      ThreadPool& pool = ThreadPool::Default());
 
-  // Loads star data from a JSON formatted file.
+  // Loads star data from a SIMBAD JSON export ({"data": [[...], ...]}). The
+  // file is memory-mapped and parsed as a stream, row by row, so memory use
+  // follows the size of the catalog rather than of the document. Rows that
+  // `filter` rejects are dropped while parsing.
   static std::vector<Star> LoadStarDataFromJSON(
+      const std::filesystem::path& path, const CatalogFilter& filter = {});
+
+  // Memory-maps a binary .zcat catalog. Nothing is parsed or copied; pass
+  // the result to AstrometryEngine::SetCatalog. Returns nullptr if the file
+  // is missing or not a valid .zcat file.
+  static std::shared_ptr<const BinaryCatalog> OpenBinaryCatalog(
       const std::filesystem::path& path);
 
+  // Hashes the bytes of a catalog file, as the source key of an engine
+  // snapshot (AstrometryEngine::SaveSnapshot). The file is mapped and
+  // hashed in chunks on `pool`. Returns nullopt if it cannot be read.
+  static std::optional<uint64_t> HashCatalogFile(
+      const std::filesystem::path& path,
+      ThreadPool& pool = ThreadPool::Default());
+
+  // Converts a JSON or CSV catalog (by file extension) to a .zcat file,
+  // keeping only the stars that pass `filter`. A tiled file can be served
+  // by CatalogStorage::MAPPED.
+  static bool ConvertToBinaryCatalog(const std::filesystem::path& input,
+                                     const std::filesystem::path& output,
+                                     const CatalogFilter& filter = {},
+                                     bool tiled = false);
+
   // Loads planetary ephemeris data from a file (e.g., JPL DE405) using CALCEPH.
   // Returns a shared pointer that automatically handles resource cleanup.
+  // With `prefetch` the whole file is read into memory, which makes the
+  // handle safe to use from several threads at once (calceph_isthreadsafe);
+  // if that fails the handle is still returned, for serial use.
   static std::shared_ptr<t_calcephbin> LoadFromEphemeris(
-      const std::filesystem::path& path);
+      const std::filesystem::path& path, bool prefetch = false);
 };
 
 }  // namespace engine
@@ -0,0 +1,51 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_CHEBYSHEV_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_CHEBYSHEV_HPP_
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+namespace engine {
+
+// Chebyshev series approximating a smooth function on [start, end]. A
+// series through n samples taken at the Chebyshev nodes of the interval is
+// the degree n - 1 interpolant, whose error is close to the best possible
+// polynomial of that degree; evaluating it costs about 2n multiply-adds.
+class ChebyshevSeries {
+ public:
+  static constexpr size_t kMaxCoefficients = 16;
+
+  // Position of the k-th of `count` Chebyshev nodes in [start, end].
+  static double Node(size_t k, size_t count, double start, double end);
+
+  // Fits the series through samples[k] = f(Node(k, samples.size(), start,
+  // end)). At most kMaxCoefficients samples are used.
+  static ChebyshevSeries Fit(std::span<const double> samples, double start,
+                             double end);
+
+  double start() const { return start_; }
+  double end() const { return end_; }
+
+  // Evaluates the series at `t` by Clenshaw's recurrence. Meant for t in
+  // [start, end]; outside it the series diverges quickly.
+  double operator()(double t) const {
+    double x = (2.0 * t - start_ - end_) / (end_ - start_);
+    double b1 = 0.0, b2 = 0.0;
+    for (size_t j = size_; j-- > 1;) {
+      double b0 = 2.0 * x * b1 - b2 + coefficients_[j];
+      b2 = b1;
+      b1 = b0;
+    }
+    return x * b1 - b2 + coefficients_[0];
+  }
+
+ private:
+  std::array<double, kMaxCoefficients> coefficients_{};
+  size_t size_ = 0;
+  double start_ = 0.0;
+  double end_ = 1.0;
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_CHEBYSHEV_HPP_
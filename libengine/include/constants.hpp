@@ -1,6 +1,8 @@
 #ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_CONSTANTS_HPP_
 #define ZENITH_FINDER_LIBENGINE_INCLUDE_CONSTANTS_HPP_
 
+#include <numbers>
+
 namespace engine {
 
 /**
@@ -38,6 +40,22 @@ constexpr double kDegToHours = 1.0 / 15.0;
  */
 constexpr double kHoursToDeg = 15.0;
 
+/**
+ * @brief Rate of the Earth's rotation relative to the stars, in degrees per
+ * minute of UT1 (360.98564736629 degrees per day).
+ */
+constexpr double kSiderealRateDegPerMin = 360.98564736629 / 1440.0;
+
+/**
+ * @brief Conversion factor from degrees to radians.
+ */
+constexpr double kDegToRad = std::numbers::pi / 180.0;
+
+/**
+ * @brief Conversion factor from milliarcseconds to radians.
+ */
+constexpr double kMasToRad = kDegToRad / 3.6e6;
+
 }  // namespace engine
 
 #endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_CONSTANTS_HPP_
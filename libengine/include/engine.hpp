@@ -3,15 +3,29 @@
 
 #include <calceph.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "sky_index.hpp"
+#include "thread_pool.hpp"
+
 namespace engine {
 
+class BinaryCatalog;
+class EphemerisPreloader;
+class PlanetCache;
+struct ApparentPlace;
+
 struct Star {
   std::string name;        // Name of the star
   std::string catalog;     // Catalog name
@@ -39,6 +53,8 @@ struct CelestialResult {
   double zenith_dist;
   float magnitude;
   bool is_rising;
+  double elevation_rate = 0.0;  // Change in elevation (degrees per minute)
+  size_t catalog_index = 0;     // Position in the catalog given to SetCatalog
 };
 
 struct SolarBody {
@@ -48,6 +64,16 @@ struct SolarBody {
   double zenith_dist;
   double distance_au;  // Distance from observer in AU
   bool is_rising;
+  double elevation_rate = 0.0;  // Change in elevation (degrees per minute)
+  size_t catalog_index = 0;     // Position in the planets catalog
+};
+
+// Ephemeris lookups over some period: the solar system bodies, and the
+// Earth and Sun read while building observer frames.
+struct EphemerisReadStats {
+  uint64_t reads = 0;
+  double mean_us = 0.0;
+  double max_us = 0.0;
 };
 
 struct Observer {
@@ -56,6 +82,7 @@ struct Observer {
   double altitude;
 };
 
+// Result ordering. NONE keeps catalog order, whatever the storage.
 enum class SortColumn {
   NONE,
   NAME,
@@ -67,6 +94,61 @@ enum class SortColumn {
   STATE
 };
 
+// Selects how star apparent positions are computed.
+//
+// PRECISE runs the full NOVAS apparent-place calculation (novas_sky_pos +
+// novas_app_to_hor) for every star.
+//
+// FAST folds precession, nutation, frame bias, Earth rotation, polar motion
+// and the observer's position into a single ICRS -> horizon rotation matrix
+// once per call, and applies it to precomputed unit vectors with linear proper
+// motion and first-order annual aberration. It ignores parallax (< 0.8") and
+// gravitational light deflection (< 0.01" more than 45 degrees from the Sun,
+// 1.75" at the solar limb). Outside the solar disk the fast position agrees
+// with PRECISE to better than 3 arcseconds; refraction uses the same model.
+enum class AccuracyMode { PRECISE, FAST };
+
+// How SetCatalog stores star coordinates.
+//
+// FULL keeps double-precision columns plus the unit vectors and proper
+// motion vectors of the FAST path, 100 bytes per star.
+//
+// COMPACT keeps fixed-point columns, 22 bytes per star: RA/Dec as 32-bit
+// fractions of a turn (0.3 mas steps), proper motion in uas/yr, parallax in
+// 0.02 mas steps (negative parallaxes become 0, the largest kept is 1310
+// mas), radial velocity in 0.1 km/s and magnitude in millimagnitudes. Both
+// transform paths dequantize on the fly. Positions stay within 0.25 mas of
+// FULL, at the cost of a few trigonometric calls per star in the FAST path.
+// Only the coordinate columns shrink: names, catalog codes and ids,
+// identifiers, index tables and the visibility table add about 76 bytes per
+// star to both, plus the strings themselves, so a compact catalog takes a
+// little over half the memory of a full one.
+//
+// MAPPED leaves the stars of a tiled .zcat file (BinaryCatalog::Write with
+// `tiled`) in the mapping and builds nothing. Each query reads only the
+// tiles that can reach the elevation band, and within them only the stars
+// up to the filter's magnitude limit, so catalogs larger than memory work.
+// Other catalogs are stored as FULL.
+enum class CatalogStorage { FULL, COMPACT, MAPPED };
+
+// Where solar system positions come from.
+//
+// EPHEMERIS asks NOVAS, which reads the ephemeris given to SetEphemeris.
+// Without one NOVAS only models the Sun and the Earth, and the other bodies
+// are left out of the results.
+//
+// ANALYTIC installs the analytic theory of analytic_ephemeris.hpp as the
+// NOVAS planet provider and ignores the ephemeris. Every body is available
+// without a DE file, in microseconds and without I/O. Within a century or
+// two of J2000 the truncated VSOP87 series put Mercury, Venus and the Sun
+// within ~1" and the other planets within a few arcseconds, heliocentric;
+// seen from the Earth the error grows by the planet's heliocentric over
+// geocentric distance (Mars near opposition ~10"). Pluto is valid over
+// 1885-2099 and the Moon's ELP-2000/82 series is good to ~10". See
+// analytic_ephemeris.hpp. The NOVAS planet provider is process-wide, so
+// engines in one process should use the same mode.
+enum class SolarSystemMode { EPHEMERIS, ANALYTIC };
+
 struct SortCriteria {
   SortColumn column = SortColumn::NONE;
   bool ascending = true;
@@ -78,6 +160,7 @@ struct FilterCriteria {
   float max_elevation = 90.0f;
   float min_azimuth = 0.0f;
   float max_azimuth = 360.0f;
+  float max_magnitude = std::numeric_limits<float>::infinity();
   size_t star_offset = 0;
   size_t star_limit = 0;
   size_t solar_offset = 0;
@@ -85,10 +168,64 @@ struct FilterCriteria {
   bool active = false;
 };
 
+// Load-time star selection. Loaders and SetCatalog drop the stars it
+// rejects before building anything for them. The default keeps every star.
+// catalog_index counts positions in the list given to SetCatalog, so for a
+// catalog the loader already filtered it is the row among the kept stars,
+// not in the source file.
+struct CatalogFilter {
+  float max_magnitude = std::numeric_limits<float>::infinity();
+  double min_dec = -90.0;  // Declination band, degrees
+  double max_dec = 90.0;
+  // Worst accepted SIMBAD quality grade ('A' best to 'E'), or 0 for any.
+  // Stars without a grade fail a set limit.
+  char max_coo_qual = 0;
+  char max_pm_qual = 0;
+  char max_plx_qual = 0;
+
+  bool Accepts(float magnitude, double dec, char coo_qual, char pm_qual,
+               char plx_qual) const {
+    auto grade_ok = [](char grade, char limit) {
+      return limit == 0 || (grade >= 'A' && grade <= limit);
+    };
+    return !(magnitude > max_magnitude) && dec >= min_dec && dec <= max_dec &&
+           grade_ok(coo_qual, max_coo_qual) && grade_ok(pm_qual, max_pm_qual) &&
+           grade_ok(plx_qual, max_plx_qual);
+  }
+  bool Accepts(const Star& star) const {
+    return Accepts(star.flux, star.dec, star.coo_qual, star.pm_qual,
+                   star.plx_qual);
+  }
+
+  bool operator==(const CatalogFilter&) const = default;
+};
+
+// Filtering, sorting and pagination for one CalculateSky call.
+struct SkyQuery {
+  FilterCriteria filter;
+  SortCriteria star_sort;
+  SortCriteria solar_sort;
+};
+
 struct ResultBuffer {
   std::vector<CelestialResult> star_results;
   std::vector<SolarBody> solar_results;
 
+  // Catalog snapshot the star names point into. Holding it keeps the names
+  // valid after the engine swaps in another catalog; copies of the results
+  // should hold it too.
+  std::shared_ptr<const void> catalog;
+
+  // Working memory reused by the engine across calls so a steady-state tick
+  // does not touch the heap. It only ever grows; callers can ignore it.
+  struct Scratch {
+    std::vector<SkyRange> tiles;             // Tiles overlapping the band
+    std::vector<SkyRange> chunks;            // Tiles split into work units
+    std::vector<size_t> chunk_starts;        // Chunk slots in survivors
+    std::vector<size_t> chunk_offsets;       // Survivors, then prefix sums
+    std::vector<CelestialResult> survivors;  // Written in place per chunk
+  } scratch;
+
   void reserve(size_t star_count, size_t solar_count) {
     star_results.reserve(star_count);
     solar_results.reserve(solar_count);
@@ -97,6 +234,7 @@ struct ResultBuffer {
   void clear() {
     star_results.clear();
     solar_results.clear();
+    catalog.reset();
   }
 };
 
@@ -105,15 +243,129 @@ class AstrometryEngine {
   AstrometryEngine();
   ~AstrometryEngine();
 
-  // Pre-builds the NOVAS star objects from the catalog for efficient
-  // calculation.
-  void SetCatalog(std::span<const Star> catalog);
+  // Pre-builds the column-oriented star catalog used by the transform loop
+  // from the stars that pass `filter`. The build runs on the thread pool.
+  //
+  // Catalogs are immutable snapshots: SetCatalog and LoadSnapshot build a
+  // new one and swap it in atomically, so they are safe to call while
+  // calculations run on other threads. A calculation keeps the snapshot it
+  // started with, and ResultBuffer::catalog keeps its names alive.
+  void SetCatalog(std::span<const Star> catalog,
+                  const CatalogFilter& filter = {});
+
+  // Pre-builds the star catalog from a memory-mapped .zcat file. Names and
+  // catalog codes stay in the mapping, which the engine keeps alive.
+  void SetCatalog(std::shared_ptr<const BinaryCatalog> catalog,
+                  const CatalogFilter& filter = {});
+
+  // Layout version of the files written by SaveSnapshot. Bumped whenever
+  // the prebuilt catalog or the way it is built changes, so that older
+  // snapshots are rebuilt instead of misread.
+  static constexpr uint32_t kSnapshotVersion = 2;
+
+  // Saves the built catalog (columns, sky index and strings) to `path`,
+  // tagged with `source_key`, a hash of the catalog it was built from (see
+  // CatalogLoader::HashCatalogFile). The file is written under a temporary
+  // name and renamed into place. Returns false on I/O errors, and for
+  // CatalogStorage::MAPPED, which has nothing to save.
+  bool SaveSnapshot(const std::filesystem::path& path,
+                    uint64_t source_key) const;
+
+  // Replaces the catalog with one saved by SaveSnapshot, if it was saved
+  // with the same `source_key`, snapshot version, catalog storage and
+  // `filter`. Columns are copied out of the mapped file; strings stay views
+  // into it. Returns false and keeps the current catalog on any mismatch,
+  // or if the file is missing or damaged.
+  bool LoadSnapshot(const std::filesystem::path& path, uint64_t source_key,
+                    const CatalogFilter& filter = {});
+
+  // Identifiers of a star (the '|' separated ids list of the source), split
+  // on demand. `catalog_index` is a result's catalog_index. Stars that were
+  // filtered out, or have no ids, give an empty list. The returned pointer
+  // holds the catalog snapshot, so the views stay valid across SetCatalog.
+  [[nodiscard]] std::shared_ptr<const std::vector<std::string_view>>
+  GetIdentifiers(size_t catalog_index) const;
+
+  // Number of stars in the current catalog: those kept by SetCatalog, or
+  // every row of a mapped file, whose filter is applied per query.
+  size_t GetStarCount() const;
+
+  // Sky-tile index over the current catalog. order()[k] is the position of
+  // the k-th indexed star among those kept by SetCatalog; results carry the
+  // position in the list given to SetCatalog as catalog_index. Empty for
+  // CatalogStorage::MAPPED, whose tiles live in the file. The returned
+  // pointer holds the catalog snapshot the index belongs to.
+  [[nodiscard]] std::shared_ptr<const SkyIndex> GetSkyIndex() const;
+
+  // Returns the catalog positions of the stars within radius_deg of an ICRS
+  // direction (catalog coordinates, no proper motion), in catalog order.
+  [[nodiscard]] std::vector<size_t> ConeSearch(double ra_deg, double dec_deg,
+                                               double radius_deg) const;
+
+  // Smallest number of stars handed to one pool task by default.
+  static constexpr size_t kDefaultGrain = 2048;
+
+  // Runs the engine's parallel work on `pool` instead of the process-wide
+  // ThreadPool::Default(). `grain` is the smallest number of stars handed to
+  // one task. Not safe to call while a calculation is running.
+  void SetThreadPool(std::shared_ptr<ThreadPool> pool,
+                     size_t grain = kDefaultGrain);
+
+  // Selects the star transform path. Defaults to AccuracyMode::PRECISE.
+  void SetAccuracyMode(AccuracyMode mode);
+  AccuracyMode GetAccuracyMode() const { return accuracy_mode_; }
+
+  // Selects how the next SetCatalog stores coordinates. Defaults to
+  // CatalogStorage::FULL; the current catalog is left as it is.
+  void SetCatalogStorage(CatalogStorage storage) { storage_ = storage; }
+  CatalogStorage GetCatalogStorage() const { return storage_; }
 
   // Sets the ephemeris to be used for solar system and high-precision
   // calculations.
   void SetEphemeris(std::shared_ptr<t_calcephbin> ephemeris);
 
-  // Calculates zenith proximity using the pre-built catalog.
+  // Selects where solar system positions come from. Defaults to
+  // SolarSystemMode::EPHEMERIS.
+  void SetSolarSystemMode(SolarSystemMode mode);
+  SolarSystemMode GetSolarSystemMode() const { return solar_system_mode_; }
+
+  // Keeps the ephemeris records around the time of each calculation in
+  // memory. The preloader may be shared by several engines on the same file.
+  void SetEphemerisPreloader(std::shared_ptr<EphemerisPreloader> preloader) {
+    preloader_ = std::move(preloader);
+  }
+
+  // Ephemeris lookups since the previous call (or since the engine was
+  // created), and resets the counts.
+  EphemerisReadStats TakeEphemerisReadStats() const;
+
+  // Longest planet cache window. The Moon's diurnal parallax is the
+  // fastest term in a topocentric fit; over six hours ten nodes still
+  // follow it to well under a milliarcsecond.
+  static constexpr std::chrono::milliseconds kMaxPlanetCacheWindow =
+      std::chrono::hours(6);
+
+  // Serves solar system positions from Chebyshev fits over windows of this
+  // length, each fitted from ten exact evaluations and refitted in the
+  // background before it runs out. Zero, the default, evaluates every body
+  // on every call. Longer windows are clamped to kMaxPlanetCacheWindow.
+  void SetPlanetCacheWindow(std::chrono::milliseconds window);
+
+  // Number of planet cache fits made so far, in the background or not.
+  uint64_t GetPlanetFitCount() const;
+
+  // Calculates stars and solar system bodies for one observer and time into
+  // a pre-allocated buffer. The observer frame is built once and the solar
+  // system is computed concurrently with the star batch.
+  void CalculateSky(ResultBuffer& buffer, const Observer& obs,
+                    const SkyQuery& query = {},
+                    std::chrono::system_clock::time_point time =
+                        std::chrono::system_clock::now()) const;
+
+  // Calculates zenith proximity using the pre-built catalog. Nothing holds
+  // the catalog snapshot for these results, so their names only stay valid
+  // until the next SetCatalog or LoadSnapshot; the ResultBuffer overload
+  // keeps them alive through ResultBuffer::catalog.
   [[nodiscard]] std::vector<CelestialResult> CalculateZenithProximity(
       const Observer& obs, const FilterCriteria& filter = {},
       const SortCriteria& sort = {},
@@ -143,18 +395,95 @@ class AstrometryEngine {
  private:
   // Internal helper to ensure NOVAS is initialized with the current ephemeris.
   void InitializeNovas() const;
-  void BuildPlanetsCatalog() const;
-
-  std::vector<std::string> star_names_;
-  std::vector<float> magnitudes_;
 
+  // Current catalog snapshot. Readers take their own reference once per
+  // call; writers build a new snapshot and Publish it.
   struct PrebuiltCatalog;
-  std::unique_ptr<PrebuiltCatalog> prebuilt_;
+  std::atomic<std::shared_ptr<const PrebuiltCatalog>> prebuilt_;
+  std::shared_ptr<const PrebuiltCatalog> Catalog() const;
+  void Publish(std::shared_ptr<const PrebuiltCatalog> catalog);
+
+  // Lays out the kept stars, read through `star(j)` for the j-th of them,
+  // in the columns of `catalog`; kept[j] is its position in the caller's
+  // catalog. `strings` owns the memory behind the records' string views.
+  struct StarRecord;
+  template <typename Source>
+  void BuildCatalog(PrebuiltCatalog& catalog, std::span<const uint32_t> kept,
+                    const Source& star, std::shared_ptr<const void> strings);
+
+  // Switches to CatalogStorage::MAPPED over a tiled binary catalog.
+  void SetMappedCatalog(std::shared_ptr<const BinaryCatalog> catalog,
+                        const CatalogFilter& filter);
+
+  // Returns the visibility table of `catalog` for the given latitude,
+  // rebuilding it only for another catalog or when the latitude moved by
+  // more than the tolerance since the last build. Rebuilds run on the pool
+  // without holding visibility_mutex_ and are published by a swap.
+  struct VisibilityTable;
+  std::shared_ptr<const VisibilityTable> GetVisibilityTable(
+      const std::shared_ptr<const PrebuiltCatalog>& catalog,
+      double latitude) const;
+  mutable std::mutex visibility_mutex_;
+  mutable std::shared_ptr<const VisibilityTable> visibility_;
+
+  // Returns the observer frame for the observer and time (rounded down to
+  // the millisecond), reusing a recently built one when the observer, time
+  // and NOVAS accuracy all match. Returns nullptr if NOVAS fails.
+  struct CachedFrame;
+  std::shared_ptr<const CachedFrame> GetFrame(
+      const Observer& obs, std::chrono::system_clock::time_point time) const;
+  static constexpr size_t kFrameCacheSize = 4;
+  mutable std::mutex frame_mutex_;
+  mutable std::array<std::shared_ptr<const CachedFrame>, kFrameCacheSize>
+      frames_;
+  mutable size_t next_frame_slot_ = 0;
+
+  // Star and solar system passes over an already built frame.
+  void ComputeStars(ResultBuffer& buffer,
+                    std::shared_ptr<const PrebuiltCatalog> catalog,
+                    const Observer& obs, const FilterCriteria& filter,
+                    const SortCriteria& sort,
+                    const CachedFrame& cached_frame) const;
+  void ComputeSolarSystem(std::vector<SolarBody>& results,
+                          const Observer& obs, const FilterCriteria& filter,
+                          const SortCriteria& sort,
+                          const CachedFrame& cached_frame) const;
+
+  // Adds `reads` ephemeris lookups taking `total_ns` in all and at most
+  // `max_ns` each to the counts.
+  void RecordEphemerisReads(uint64_t reads, uint64_t total_ns,
+                            uint64_t max_ns) const;
+  mutable std::atomic<uint64_t> ephemeris_reads_{0};
+  mutable std::atomic<uint64_t> ephemeris_read_ns_{0};
+  mutable std::atomic<uint64_t> ephemeris_read_max_ns_{0};
+
+  // Light time (days) of each solar system body at its last evaluation,
+  // the starting point of the next one.
+  static constexpr size_t kMaxSolarBodies = 16;
+  mutable std::array<std::atomic<double>, kMaxSolarBodies> light_times_{};
+
+  // Exact apparent places of every planet for the observer at each of
+  // `times_ms`, row by row, for the planet cache to fit. With the analytic
+  // solar system, each body is evaluated at all the times in one batch.
+  void SamplePlanets(const Observer& obs, std::span<const int64_t> times_ms,
+                     std::span<ApparentPlace> places) const;
+
+  ThreadPool& Pool() const;
+  std::shared_ptr<ThreadPool> pool_;
+  size_t grain_ = kDefaultGrain;
 
   std::shared_ptr<t_calcephbin> ephemeris_;
+  std::shared_ptr<EphemerisPreloader> preloader_;
+  AccuracyMode accuracy_mode_ = AccuracyMode::PRECISE;
+  SolarSystemMode solar_system_mode_ = SolarSystemMode::EPHEMERIS;
+  CatalogStorage storage_ = CatalogStorage::FULL;
   mutable std::mutex initialization_mutex_;
   mutable int accuracy_ = 0;
   mutable bool initialized_ = false;
+  mutable bool parallel_ephemeris_ = false;  // Bodies may run concurrently
+
+  // Last, so that a background fit finishes before anything it reads goes
+  std::unique_ptr<PlanetCache> planet_cache_;
 };
 
 }  // namespace engine
@@ -0,0 +1,120 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_EPHEMERIS_PRELOADER_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_EPHEMERIS_PRELOADER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace engine {
+
+// Keeps the parts of a JPL SPK ephemeris (a DE4xx .bsp file) that cover a
+// span of time around the current one in memory. The file is mapped and the
+// Chebyshev records of every segment that fall in the span are read through
+// the mapping and locked there; CALCEPH's own reads of the same file then
+// come from the page cache instead of the disk. The next span is read in
+// the background once the time reaches the last quarter of the current one,
+// and the span before the current one is released.
+//
+// If the pages cannot be locked (the locked memory limit, RLIMIT_MEMLOCK
+// on Linux, is often small), Advance touches them again on every call
+// instead. That keeps them recently used, but under memory pressure the
+// system may still evict them between calls.
+class EphemerisPreloader {
+ public:
+  // Milestones of the preloader, for the debug metrics.
+  struct Stats {
+    uint64_t loads = 0;           // Spans read so far
+    uint64_t bytes = 0;           // Bytes read by the last load
+    uint64_t resident_bytes = 0;  // Bytes of the spans kept in memory
+    double last_load_ms = 0.0;    // Duration of the last load
+    bool stalled = false;         // A calculation waited for the last load
+  };
+
+  // Maps the file and reads its segment directory. Returns nullptr if the
+  // file cannot be mapped or is not a little-endian SPK file; those are left
+  // to CALCEPH's own I/O. `span` is the length of time kept in memory.
+  static std::shared_ptr<EphemerisPreloader> Open(
+      const std::filesystem::path& path, std::chrono::hours span);
+
+  // Waits for a background load.
+  ~EphemerisPreloader();
+
+  EphemerisPreloader(const EphemerisPreloader&) = delete;
+  EphemerisPreloader& operator=(const EphemerisPreloader&) = delete;
+
+  // Reads the span starting half a span before `time`, now.
+  void Preload(std::chrono::system_clock::time_point time);
+
+  // Called with the time of every calculation. Free while `time` is in the
+  // preloaded span, unless its pages could not be locked; starts the
+  // background load of the next span in its last quarter, and loads
+  // synchronously after a jump outside it.
+  void Advance(std::chrono::system_clock::time_point time);
+
+  std::chrono::hours span() const { return span_; }
+  size_t segment_count() const { return segments_.size(); }
+  Stats stats() const;
+
+ private:
+  // One SPK segment. Types 2 and 3 store equal-length Chebyshev records,
+  // so the records for a time range are found by index; other types are
+  // read whole.
+  struct Segment {
+    double start_et = 0.0;  // TDB seconds past J2000
+    double end_et = 0.0;
+    uint64_t begin_word = 0;  // 1-based 8-byte word addresses, inclusive
+    uint64_t end_word = 0;
+    double init = 0.0;        // Start of the first record, TDB seconds
+    double interval = 0.0;    // Seconds per record; 0 for other types
+    uint64_t record_words = 0;
+    uint64_t records = 0;
+  };
+
+  // A span that has been read.
+  struct LoadResult {
+    double start_et = 0.0;
+    double end_et = 0.0;
+    uint64_t bytes = 0;
+    double ms = 0.0;
+    std::vector<std::pair<size_t, size_t>> ranges;  // Byte offset, length
+    bool locked = true;  // Every range is locked in memory
+  };
+
+  EphemerisPreloader() = default;
+
+  // Reads and locks the records covering [start_et, end_et) of every
+  // segment.
+  LoadResult Load(double start_et, double end_et) const;
+
+  // Reads one byte of every page of `ranges`.
+  void Touch(const std::vector<std::pair<size_t, size_t>>& ranges) const;
+
+  // Records a finished load, releasing the spans it makes unnecessary.
+  // Requires mutex_.
+  void Apply(LoadResult result, bool stalled);
+
+  std::shared_ptr<const MappedFile> file_;
+  std::vector<Segment> segments_;
+  std::chrono::hours span_{0};
+
+  mutable std::mutex mutex_;  // Guards everything below
+  // At most two adjoining spans, oldest first: the one in use and the one
+  // read ahead
+  std::vector<LoadResult> resident_;
+  double loaded_start_et_ = 0.0;
+  double loaded_end_et_ = 0.0;  // Empty span until the first load
+  bool warned_ = false;  // Reported a failure to lock
+  std::future<LoadResult> next_;  // Background load of the next span
+  Stats stats_;
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_EPHEMERIS_PRELOADER_HPP_
@@ -0,0 +1,48 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_MAPPED_FILE_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace engine {
+
+// Read-only memory mapping of a whole file. The mapping stays valid for the
+// lifetime of the object, so views into it can be shared by holding the
+// shared_ptr returned by Open.
+class MappedFile {
+ public:
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps the file, or returns nullptr if it cannot be opened or mapped.
+  static std::shared_ptr<const MappedFile> Open(
+      const std::filesystem::path& path);
+
+  const std::byte* data() const { return data_; }
+  size_t size() const { return size_; }
+  std::span<const std::byte> bytes() const { return {data_, size_}; }
+
+  // Locks the pages holding [offset, offset + bytes) in memory (mlock or
+  // VirtualLock), so they are not paged out, or unlocks them. Locking fails
+  // beyond the process's limit on locked memory.
+  bool Lock(size_t offset, size_t bytes) const;
+  void Unlock(size_t offset, size_t bytes) const;
+
+ private:
+  MappedFile() = default;
+
+  const std::byte* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  void* file_ = nullptr;     // HANDLE
+  void* mapping_ = nullptr;  // HANDLE
+#endif
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_MAPPED_FILE_HPP_
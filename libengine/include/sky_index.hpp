@@ -0,0 +1,146 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_SKY_INDEX_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_SKY_INDEX_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine {
+
+// Unit vector on the celestial sphere.
+struct SkyVector {
+  double x;
+  double y;
+  double z;
+
+  // Builds the unit vector for a Right Ascension / Declination in degrees.
+  static SkyVector FromRaDec(double ra_deg, double dec_deg);
+
+  double Dot(const SkyVector& other) const {
+    return x * other.x + y * other.y + z * other.z;
+  }
+};
+
+// A run of consecutive members, as positions in SkyIndex::order().
+struct SkyRange {
+  uint32_t begin;
+  uint32_t end;
+};
+
+// Spherical cap bounding every member of a tile: the members lie within
+// `radius` radians of `center`. Empty tiles have a negative radius.
+struct SkyCap {
+  SkyVector center;
+  double radius;
+};
+
+// How a region relates to a tile, as reported by a QueryRegion classifier.
+enum class SkyOverlap {
+  NONE,     // The tile's cap lies entirely outside the region
+  PARTIAL,  // The cap straddles the region boundary
+  FULL,     // The cap lies entirely inside the region
+};
+
+// Equal-area hierarchical tiling of the sphere (HEALPix, nested scheme) over
+// a set of unit vectors. At depth d the sphere is split into 12 * 4^d tiles
+// of equal area, and tile t at depth d is the parent of tiles 4t..4t+3 at
+// depth d + 1. Members are ordered by leaf tile, so every tile, and every
+// subtree of tiles, is one contiguous range of members.
+//
+// Region queries descend the hierarchy with per-tile bounding caps computed
+// from the members themselves, skipping whole subtrees that miss the region.
+class SkyIndex {
+ public:
+  // Depth 4 gives 3072 leaf tiles of ~13.4 square degrees.
+  static constexpr int kDefaultDepth = 4;
+  static constexpr int kMaxDepth = 13;
+
+  SkyIndex() = default;
+
+  // Builds the index over unit vectors given as three coordinate columns.
+  // Within a tile, members keep their original relative order.
+  void Build(std::span<const double> x, std::span<const double> y,
+             std::span<const double> z, int depth = kDefaultDepth);
+
+  // Returns the leaf tile containing the (not necessarily normalized)
+  // direction at the given depth.
+  static uint32_t TileOf(const SkyVector& v, int depth);
+
+  // Number of tiles at a depth: 12 * 4^depth.
+  static uint32_t TileCount(int depth) { return 12u << (2 * depth); }
+
+  int depth() const { return depth_; }
+  size_t size() const { return order_.size(); }
+
+  // order()[k] is the original index of the k-th member in tile order.
+  std::span<const uint32_t> order() const { return order_; }
+
+  // Members of one leaf tile, as positions in order().
+  SkyRange Members(uint32_t tile) const {
+    return {offsets_[tile], offsets_[tile + 1]};
+  }
+
+  // Bounding cap of a tile at a depth in [0, depth()].
+  const SkyCap& Cap(int depth, uint32_t tile) const {
+    return caps_[depth][tile];
+  }
+
+  // Leaf tile offsets into order() and the caps of every depth, shallowest
+  // first. Together with order() they are the whole index, for saving it.
+  std::span<const uint32_t> offsets() const { return offsets_; }
+  std::vector<SkyCap> caps() const;
+
+  // Restores an index saved as order(), offsets() and caps(). Returns false,
+  // leaving the index unchanged, if the parts do not form a valid index.
+  bool Restore(int depth, std::span<const uint32_t> order,
+               std::span<const uint32_t> offsets,
+               std::span<const SkyCap> caps);
+
+  // Appends the member ranges of every tile the classifier does not reject.
+  // `classify(const SkyCap&)` returns a SkyOverlap; FULL accepts the whole
+  // subtree without descending further. Adjacent ranges are merged.
+  template <typename Classifier>
+  void QueryRegion(Classifier&& classify, std::vector<SkyRange>& out) const {
+    if (order_.empty()) return;
+    for (uint32_t tile = 0; tile < TileCount(0); ++tile) {
+      Descend(0, tile, classify, out);
+    }
+  }
+
+  // Appends the member ranges of tiles that may hold points whose angular
+  // distance from `axis` lies in [min_angle, max_angle] (radians). A cone
+  // search is the case min_angle == 0.
+  void QueryAnnulus(const SkyVector& axis, double min_angle, double max_angle,
+                    std::vector<SkyRange>& out) const;
+
+ private:
+  template <typename Classifier>
+  void Descend(int depth, uint32_t tile, Classifier& classify,
+               std::vector<SkyRange>& out) const {
+    const SkyCap& cap = caps_[depth][tile];
+    if (cap.radius < 0.0) return;
+
+    auto overlap = classify(cap);
+    if (overlap == SkyOverlap::NONE) return;
+    if (overlap == SkyOverlap::FULL || depth == depth_) {
+      int shift = 2 * (depth_ - depth);
+      Append(offsets_[tile << shift], offsets_[(tile + 1) << shift], out);
+      return;
+    }
+    for (uint32_t child = tile * 4; child < tile * 4 + 4; ++child) {
+      Descend(depth + 1, child, classify, out);
+    }
+  }
+
+  static void Append(uint32_t begin, uint32_t end, std::vector<SkyRange>& out);
+
+  int depth_ = 0;
+  std::vector<uint32_t> order_;
+  std::vector<uint32_t> offsets_;  // Leaf tile t spans [offsets_[t], [t+1])
+  std::vector<std::vector<SkyCap>> caps_;  // One level per depth
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_SKY_INDEX_HPP_
@@ -0,0 +1,122 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_STARTUP_PIPELINE_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_STARTUP_PIPELINE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "engine.hpp"
+#include "thread_pool.hpp"
+
+namespace engine {
+
+// Milestones of a StartupPipeline, in the order they are reached.
+enum class StartupStage {
+  LOADING,       // Reading the catalog and opening the ephemeris
+  BRIGHT_READY,  // An engine over the bright stars has been published,
+                 // with the ephemeris only if it was already open
+  COMPLETE,      // The engine over the whole catalog has been published
+  FAILED,        // The catalog could not be loaded
+};
+
+struct StartupOptions {
+  std::filesystem::path catalog_path;    // .json, .csv or .zcat
+  std::filesystem::path ephemeris_path;  // Empty skips the ephemeris
+  bool prefetch_ephemeris = false;  // Read it into memory for parallel use
+
+  // ANALYTIC computes the solar system without an ephemeris, which is then
+  // not opened.
+  SolarSystemMode solar_system = SolarSystemMode::EPHEMERIS;
+
+  // Span of an SPK ephemeris kept in memory around the calculation time;
+  // zero leaves reads to CALCEPH.
+  std::chrono::hours ephemeris_preload{0};
+  std::filesystem::path snapshot_path;   // Engine snapshot; empty disables it
+  CatalogFilter filter;                  // Load-time filter of the catalog
+  CatalogStorage storage = CatalogStorage::FULL;
+
+  // Pool for loading and for the published engines; nullptr uses
+  // ThreadPool::Default().
+  std::shared_ptr<ThreadPool> pool;
+  size_t grain = AstrometryEngine::kDefaultGrain;
+
+  // Catalogs of at least `progressive_stars` stars first publish an engine
+  // over the stars up to `bright_magnitude`, which builds in a fraction of
+  // the time, and then one over the whole catalog.
+  float bright_magnitude = 6.5f;
+  size_t progressive_stars = 100000;
+
+  // Window of the published engines' planet cache; zero disables it.
+  std::chrono::milliseconds planet_cache_window{0};
+};
+
+// Milliseconds from the start of the pipeline to each milestone, negative
+// until it is reached.
+struct StartupTimings {
+  double catalog_loaded_ms = -1.0;
+  double ephemeris_ready_ms = -1.0;
+  double bright_ready_ms = -1.0;
+  double complete_ms = -1.0;
+};
+
+// Loads the catalog and opens the ephemeris concurrently on a background
+// thread, and publishes engines as they become usable: first one over the
+// bright stars, then one over the whole catalog. A current snapshot, or a
+// mapped catalog, is published complete straight away.
+//
+// Every publication is a new engine that is never modified again, so the
+// receiver can keep calculating with the previous one while the next is
+// built, and swap them between ticks.
+class StartupPipeline {
+ public:
+  using PublishCallback =
+      std::function<void(std::shared_ptr<const AstrometryEngine> engine,
+                         StartupStage stage)>;
+
+  // Starts the pipeline. `publish` runs on the pipeline's thread, once per
+  // published engine; FAILED is reported with a null engine.
+  StartupPipeline(StartupOptions options, PublishCallback publish);
+
+  // Abandons the remaining stages and waits for the current one to end.
+  ~StartupPipeline();
+
+  StartupPipeline(const StartupPipeline&) = delete;
+  StartupPipeline& operator=(const StartupPipeline&) = delete;
+
+  // Blocks until the pipeline reaches COMPLETE or FAILED.
+  void Wait();
+
+  StartupStage stage() const { return stage_.load(); }
+  StartupTimings timings() const;
+
+ private:
+  void Run();
+  std::shared_ptr<AstrometryEngine> MakeEngine() const;
+  void Publish(std::shared_ptr<const AstrometryEngine> engine,
+               StartupStage stage);
+  void Mark(double StartupTimings::*milestone);
+
+  StartupOptions options_;
+  PublishCallback publish_;
+  std::chrono::steady_clock::time_point start_;
+
+  std::atomic<StartupStage> stage_{StartupStage::LOADING};
+  std::atomic<bool> cancel_{false};
+
+  // Guards the timings and signals the end of the pipeline to Wait
+  mutable std::mutex mutex_;
+  std::condition_variable finished_;
+  StartupTimings timings_;
+
+  std::thread thread_;
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_STARTUP_PIPELINE_HPP_
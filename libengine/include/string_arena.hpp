@@ -0,0 +1,54 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_STRING_ARENA_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_STRING_ARENA_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace engine {
+
+// Append-only storage for many small strings. Text is packed into large
+// blocks that never move, so the views handed out stay valid for the
+// arena's lifetime, and each string costs only its characters. Short,
+// highly repeated strings (catalog codes) can be interned so that every
+// copy shares one view.
+//
+// Not thread-safe; fill it from one thread, or Allocate once and write the
+// returned span from many.
+class StringArena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit StringArena(size_t block_size = kDefaultBlockSize)
+      : block_size_(block_size) {}
+
+  StringArena(const StringArena&) = delete;
+  StringArena& operator=(const StringArena&) = delete;
+
+  // Reserves `size` contiguous bytes. Requests larger than a quarter of a
+  // block get a block of their own.
+  char* Allocate(size_t size);
+
+  // Copies `value` into the arena.
+  std::string_view Store(std::string_view value);
+
+  // Returns the arena's single copy of `value`, storing it on first use.
+  std::string_view Intern(std::string_view value);
+
+  size_t bytes() const { return bytes_; }  // Characters stored
+  size_t interned() const { return dictionary_.size(); }
+
+ private:
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* cursor_ = nullptr;
+  size_t remaining_ = 0;
+  size_t bytes_ = 0;
+  std::unordered_set<std::string_view> dictionary_;
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_STRING_ARENA_HPP_
@@ -0,0 +1,121 @@
+#ifndef ZENITH_FINDER_LIBENGINE_INCLUDE_THREAD_POOL_HPP_
+#define ZENITH_FINDER_LIBENGINE_INCLUDE_THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+struct ThreadPoolOptions {
+  size_t threads = 0;     // Worker threads; 0 uses every hardware thread
+  std::vector<int> cpus;  // CPUs to pin workers to, round-robin; empty = any
+};
+
+// Fixed set of worker threads with one task deque each. A worker pops its
+// own newest task and, when it runs dry, steals the oldest task of another
+// worker, so a loop split into halves spreads over the pool on demand.
+//
+// Work only ever runs on the workers: a thread outside the pool that calls
+// ParallelFor queues the loop and sleeps until it is done, which keeps the
+// work on the pinned CPUs. A worker that calls ParallelFor (nested
+// parallelism) keeps running tasks while it waits.
+class ThreadPool {
+ public:
+  explicit ThreadPool(const ThreadPoolOptions& options = {});
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Process-wide pool with default options, created on first use.
+  static ThreadPool& Default();
+
+  size_t size() const { return queue_count_ - 1; }
+
+  // Calls body(i) for every i in [0, count) and returns when all calls are
+  // done. Ranges of at most `grain` indices run as one task. The body must
+  // not throw.
+  template <typename Body>
+  void ParallelFor(size_t count, size_t grain, Body&& body) {
+    if (count == 0) return;
+    using BodyType = std::remove_reference_t<Body>;
+    Job job;
+    job.run = [](void* context, size_t begin, size_t end) {
+      auto& fn = *static_cast<BodyType*>(context);
+      for (size_t i = begin; i < end; ++i) fn(i);
+    };
+    job.context =
+        const_cast<void*>(static_cast<const void*>(std::addressof(body)));
+    job.grain = grain > 0 ? grain : 1;
+    Run(job, count);
+  }
+
+  // Runs both callables, possibly concurrently, and returns when both are
+  // done.
+  template <typename A, typename B>
+  void Invoke(A&& a, B&& b) {
+    ParallelFor(2, 1, [&](size_t i) {
+      if (i == 0) {
+        a();
+      } else {
+        b();
+      }
+    });
+  }
+
+ private:
+  // One ParallelFor call. It lives on the caller's stack until `done`.
+  struct Job {
+    void (*run)(void* context, size_t begin, size_t end) = nullptr;
+    void* context = nullptr;
+    size_t grain = 1;
+    std::atomic<size_t> remaining{0};  // Indices not yet run
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+  };
+
+  struct Task {
+    Job* job;
+    size_t begin;
+    size_t end;
+  };
+
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void Run(Job& job, size_t count);
+  void WorkerLoop(size_t index);
+  void Push(size_t queue, const Task& task);
+  bool TryRunOne(size_t index);
+  void Execute(Task task, size_t index);
+
+  // Index of the calling thread's queue, or the shared queue for threads
+  // outside the pool.
+  size_t CallerQueue() const;
+
+  // One queue per worker plus a shared one for outside callers. Both are
+  // fixed before the first worker starts.
+  std::unique_ptr<Queue[]> queues_;
+  size_t queue_count_ = 0;
+  std::vector<std::thread> workers_;
+
+  std::atomic<size_t> queued_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_INCLUDE_THREAD_POOL_HPP_
@@ -0,0 +1,568 @@
+#include "analytic_ephemeris.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+#include "vsop87_tables.hpp"
+
+namespace engine {
+
+namespace {
+
+constexpr double kDegree = std::numbers::pi / 180.0;
+constexpr double kArcsecond = kDegree / 3600.0;
+constexpr double kJ2000 = 2451545.0;
+constexpr double kDaysPerCentury = 36525.0;
+constexpr double kDaysPerMillennium = 365250.0;
+constexpr double kAuKm = 149597870.7;
+
+// Obliquity of the J2000 ecliptic (IAU 1976), which Pluto's series is
+// referred to
+constexpr double kObliquityJ2000 = 84381.448 * kArcsecond;
+
+// General precession in longitude, rad/day. The equinox of date moves along
+// the ecliptic at this rate.
+constexpr double kPrecessionRate = 5029.0966 * kArcsecond / kDaysPerCentury;
+
+// Samples per block. The scratch arrays stay on the stack and every inner
+// loop runs over the samples of a block.
+constexpr size_t kBlock = 16;
+
+// Step of the central difference for the Moon's velocity, days
+constexpr double kMoonStep = 0.01;
+
+// Periodic terms of Pluto, Meeus table 37.A. The argument is j*J + s*S +
+// p*P for the mean longitudes J, S and P of Jupiter, Saturn and Pluto, and
+// each coordinate gets A sin + B cos of it: in 1e-6 degree for the
+// longitude and latitude, 1e-7 AU for the radius.
+struct PlutoTerm {
+  int8_t j, s, p;
+  int32_t longitude_a, longitude_b, latitude_a, latitude_b, radius_a,
+      radius_b;
+};
+
+constexpr PlutoTerm kPluto[] = {
+    {0, 0, 1, -19799805, 19850055, -5452852, -14974862, 66865439, 68951812},
+    {0, 0, 2, 897144, -4954829, 3527812, 1672790, -11827535, -332538},
+    {0, 0, 3, 611149, 1211027, -1050748, 327647, 1593179, -1438890},
+    {0, 0, 4, -341243, -189585, 178690, -292153, -18444, 483220},
+    {0, 0, 5, 129287, -34992, 18650, 100340, -65977, -85431},
+    {0, 0, 6, -38164, 30893, -30697, -25823, 31174, -6032},
+    {0, 1, -1, 20442, -9987, 4878, 11248, -5794, 22161},
+    {0, 1, 0, -4063, -5071, 226, -64, 4601, 4032},
+    {0, 1, 1, -6016, -3336, 2030, -836, -1729, 234},
+    {0, 1, 2, -3956, 3039, 69, -604, -415, 702},
+    {0, 1, 3, -667, 3572, -247, -567, 239, 723},
+    {0, 2, -2, 1276, 501, -57, 1, 67, -67},
+    {0, 2, -1, 1152, -917, -122, 175, 1034, -451},
+    {0, 2, 0, 630, -1277, -49, -164, -129, 504},
+    {1, -1, 0, 2571, -459, -197, 199, 480, -231},
+    {1, -1, 1, 899, -1449, -25, 217, 2, -441},
+    {1, 0, -3, -1016, 1043, 589, -248, -3359, 265},
+    {1, 0, -2, -2343, -1012, -269, 711, 7856, -7832},
+    {1, 0, -1, 7042, 788, 185, 193, 36, 45763},
+    {1, 0, 0, 1199, -338, 315, 807, 8663, 8547},
+    {1, 0, 1, 418, -67, -130, -43, -809, -769},
+    {1, 0, 2, 120, -274, 5, 3, 263, -144},
+    {1, 0, 3, -60, -159, 2, 17, -126, 32},
+    {1, 0, 4, -82, -29, 2, 5, -35, -16},
+    {1, 1, -3, -36, -29, 2, 3, -19, -4},
+    {1, 1, -2, -40, 7, 3, 1, -15, 8},
+    {1, 1, -1, -14, 22, 2, -1, -4, 12},
+    {1, 1, 0, 4, 13, 1, -1, 5, 6},
+    {1, 1, 1, 5, 2, 0, -1, 3, 1},
+    {1, 1, 3, -1, 0, 0, 0, 6, -2},
+    {2, 0, -6, 2, 0, 0, -2, 2, 2},
+    {2, 0, -5, -4, 5, 2, 2, -2, -2},
+    {2, 0, -4, 4, -7, -7, 0, 14, 13},
+    {2, 0, -3, 14, 24, 10, -8, -63, 13},
+    {2, 0, -2, -49, -34, -3, 20, 136, -236},
+    {2, 0, -1, 163, -48, 6, 5, 273, 1065},
+    {2, 0, 0, 9, -24, 14, 17, 251, 149},
+    {2, 0, 1, -4, 1, -2, 0, -25, -9},
+    {2, 0, 2, -3, 1, 0, 0, 9, -2},
+    {2, 0, 3, 1, 3, 0, 0, -8, 7},
+    {3, 0, -2, -3, -1, 0, 1, 9, -10},
+    {3, 0, -1, 5, -3, 0, 0, -2, 8},
+    {3, 0, 0, 0, 0, 0, 0, 1, 0},
+};
+
+// Periodic terms of the Moon's longitude (1e-6 degree, sine) and distance
+// (1e-3 km, cosine), Meeus table 47.A. The argument is d*D + m*M + mp*M' +
+// f*F; terms in M are scaled by E^|m| for the Earth's orbital eccentricity.
+struct LunarTerm {
+  int8_t d, m, mp, f;
+  int32_t longitude, distance;
+};
+
+constexpr LunarTerm kLunarLongitudeDistance[] = {
+    {0, 0, 1, 0, 6288774, -20905355},
+    {2, 0, -1, 0, 1274027, -3699111},
+    {2, 0, 0, 0, 658314, -2955968},
+    {0, 0, 2, 0, 213618, -569925},
+    {0, 1, 0, 0, -185116, 48888},
+    {0, 0, 0, 2, -114332, -3149},
+    {2, 0, -2, 0, 58793, 246158},
+    {2, -1, -1, 0, 57066, -152138},
+    {2, 0, 1, 0, 53322, -170733},
+    {2, -1, 0, 0, 45758, -204586},
+    {0, 1, -1, 0, -40923, -129620},
+    {1, 0, 0, 0, -34720, 108743},
+    {0, 1, 1, 0, -30383, 104755},
+    {2, 0, 0, -2, 15327, 10321},
+    {0, 0, 1, 2, -12528, 0},
+    {0, 0, 1, -2, 10980, 79661},
+    {4, 0, -1, 0, 10675, -34782},
+    {0, 0, 3, 0, 10034, -23210},
+    {4, 0, -2, 0, 8548, -21636},
+    {2, 1, -1, 0, -7888, 24208},
+    {2, 1, 0, 0, -6766, 30824},
+    {1, 0, -1, 0, -5163, -8379},
+    {1, 1, 0, 0, 4987, -16675},
+    {2, -1, 1, 0, 4036, -12831},
+    {2, 0, 2, 0, 3994, -10445},
+    {4, 0, 0, 0, 3861, -11650},
+    {2, 0, -3, 0, 3665, 14403},
+    {0, 1, -2, 0, -2689, -7003},
+    {2, 0, -1, 2, -2602, 0},
+    {2, -1, -2, 0, 2390, 10056},
+    {1, 0, 1, 0, -2348, 6322},
+    {2, -2, 0, 0, 2236, -9884},
+    {0, 1, 2, 0, -2120, 5751},
+    {0, 2, 0, 0, -2069, 0},
+    {2, -2, -1, 0, 2048, -4950},
+    {2, 0, 1, -2, -1773, 4130},
+    {2, 0, 0, 2, -1595, 0},
+    {4, -1, -1, 0, 1215, -3958},
+    {0, 0, 2, 2, -1110, 0},
+    {3, 0, -1, 0, -892, 3258},
+    {2, 1, 1, 0, -810, 2616},
+    {4, -1, -2, 0, 759, -1897},
+    {0, 2, -1, 0, -713, -2117},
+    {2, 2, -1, 0, -700, 2354},
+    {2, 1, -2, 0, 691, 0},
+    {2, -1, 0, -2, 596, 0},
+    {4, 0, 1, 0, 549, -1423},
+    {0, 0, 4, 0, 537, -1117},
+    {4, -1, 0, 0, 520, -1571},
+    {1, 0, -2, 0, -487, -1739},
+    {2, 1, 0, -2, -399, 0},
+    {0, 0, 2, -2, -381, -4421},
+    {1, 1, 1, 0, 351, 0},
+    {3, 0, -2, 0, -340, 0},
+    {4, 0, -3, 0, 330, 0},
+    {2, -1, 2, 0, 327, 0},
+    {0, 2, 1, 0, -323, 1165},
+    {1, 1, -1, 0, 299, 0},
+    {2, 0, 3, 0, 294, 0},
+    {2, 0, -1, -2, 0, 8752},
+};
+
+// Periodic terms of the Moon's latitude (1e-6 degree, sine), Meeus table
+// 47.B.
+struct LunarLatitudeTerm {
+  int8_t d, m, mp, f;
+  int32_t latitude;
+};
+
+constexpr LunarLatitudeTerm kLunarLatitude[] = {
+    {0, 0, 0, 1, 5128122},
+    {0, 0, 1, 1, 280602},
+    {0, 0, 1, -1, 277693},
+    {2, 0, 0, -1, 173237},
+    {2, 0, -1, 1, 55413},
+    {2, 0, -1, -1, 46271},
+    {2, 0, 0, 1, 32573},
+    {0, 0, 2, 1, 17198},
+    {2, 0, 1, -1, 9266},
+    {0, 0, 2, -1, 8822},
+    {2, -1, 0, -1, 8216},
+    {2, 0, -2, -1, 4324},
+    {2, 0, 1, 1, 4200},
+    {2, 1, 0, -1, -3359},
+    {2, -1, -1, 1, 2463},
+    {2, -1, 0, 1, 2211},
+    {2, -1, -1, -1, 2065},
+    {0, 1, -1, -1, -1870},
+    {4, 0, -1, -1, 1828},
+    {0, 1, 0, 1, -1794},
+    {0, 0, 0, 3, -1749},
+    {0, 1, -1, 1, -1565},
+    {1, 0, 0, 1, -1491},
+    {0, 1, 1, 1, -1475},
+    {0, 1, 1, -1, -1410},
+    {0, 1, 0, -1, -1344},
+    {1, 0, 0, -1, -1335},
+    {0, 0, 3, 1, 1107},
+    {4, 0, 0, -1, 1021},
+    {4, 0, -1, 1, 833},
+    {0, 0, 1, -3, 777},
+    {4, 0, -2, 1, 671},
+    {2, 0, 0, -3, 607},
+    {2, 0, 2, -1, 596},
+    {2, -1, 1, -1, 491},
+    {2, 0, -2, 1, -451},
+    {0, 0, 3, -1, 439},
+    {2, 0, 2, 1, 422},
+    {2, 0, -3, -1, 421},
+    {2, 1, -1, 1, -366},
+    {2, 1, 0, 1, -351},
+    {4, 0, 0, 1, 331},
+    {2, -1, 1, 1, 315},
+    {2, -2, 0, -1, 302},
+    {0, 0, 1, 3, -283},
+    {2, 1, 1, -1, -229},
+    {1, 1, 0, -1, 223},
+    {1, 1, 0, 1, 223},
+    {0, 1, -2, -1, -220},
+    {2, 1, -1, -1, -220},
+    {1, 0, 1, 1, -185},
+    {2, -1, -2, -1, 181},
+    {0, 1, 2, 1, -177},
+    {4, 0, -2, -1, 176},
+    {4, -1, -1, -1, 166},
+    {1, 0, 1, -1, -164},
+    {4, 0, 1, -1, 132},
+    {1, 0, -1, -1, -119},
+    {4, -1, 0, -1, 115},
+    {2, -2, 0, 1, 107},
+};
+
+double Centuries(double jd_tdb) { return (jd_tdb - kJ2000) / kDaysPerCentury; }
+
+double Millennia(double jd_tdb) {
+  return (jd_tdb - kJ2000) / kDaysPerMillennium;
+}
+
+using Rotation = std::array<std::array<double, 3>, 3>;
+
+std::array<double, 3> Rotate(const Rotation& m,
+                             const std::array<double, 3>& v) {
+  return {m[0][0] * v[0] + m[0][1] * v[1] + m[0][2] * v[2],
+          m[1][0] * v[0] + m[1][1] * v[1] + m[1][2] * v[2],
+          m[2][0] * v[0] + m[2][1] * v[1] + m[2][2] * v[2]};
+}
+
+// From ecliptic coordinates with obliquity `eps` to equatorial ones
+Rotation EclipticToEquator(double eps) {
+  const double c = std::cos(eps), s = std::sin(eps);
+  return {{{1.0, 0.0, 0.0}, {0.0, c, -s}, {0.0, s, c}}};
+}
+
+// From the mean ecliptic and equinox of date, `t` centuries after J2000, to
+// the J2000 equator: to the mean equator of date, then back to J2000 with
+// the IAU 1976 precession angles.
+Rotation EclipticOfDateToJ2000(double t) {
+  const double t2 = t * t, t3 = t2 * t;
+  const double eps =
+      (84381.448 - 46.8150 * t - 0.00059 * t2 + 0.001813 * t3) * kArcsecond;
+  const double zeta =
+      (2306.2181 * t + 0.30188 * t2 + 0.017998 * t3) * kArcsecond;
+  const double zz =
+      (2306.2181 * t + 1.09468 * t2 + 0.018203 * t3) * kArcsecond;
+  const double theta =
+      (2004.3109 * t - 0.42665 * t2 - 0.041833 * t3) * kArcsecond;
+  const double cz = std::cos(zeta), sz = std::sin(zeta);
+  const double cZ = std::cos(zz), sZ = std::sin(zz);
+  const double ct = std::cos(theta), st = std::sin(theta);
+
+  // Transpose of the J2000-to-date precession matrix
+  const Rotation precession = {{{cz * ct * cZ - sz * sZ, cz * ct * sZ + sz * cZ,
+                                 cz * st},
+                                {-sz * ct * cZ - cz * sZ,
+                                 -sz * ct * sZ + cz * cZ, -sz * st},
+                                {-st * cZ, -st * sZ, ct}}};
+  const Rotation equator = EclipticToEquator(eps);
+  Rotation m{};
+  for (size_t r = 0; r < 3; ++r) {
+    for (size_t c = 0; c < 3; ++c) {
+      for (size_t k = 0; k < 3; ++k) {
+        m[r][c] += precession[r][k] * equator[k][c];
+      }
+    }
+  }
+  return m;
+}
+
+// State from spherical coordinates (radians, AU) and their rates per day,
+// turned by `rotation`
+BodyState FromSpherical(double lon, double lat, double r, double lon_rate,
+                        double lat_rate, double r_rate,
+                        const Rotation& rotation) {
+  const double cl = std::cos(lon), sl = std::sin(lon);
+  const double cb = std::cos(lat), sb = std::sin(lat);
+  const std::array<double, 3> position = {r * cb * cl, r * cb * sl, r * sb};
+  const double radial = r_rate * cb - r * sb * lat_rate;
+  const std::array<double, 3> velocity = {
+      radial * cl - r * cb * sl * lon_rate,
+      radial * sl + r * cb * cl * lon_rate, r_rate * sb + r * cb * lat_rate};
+  return {Rotate(rotation, position), Rotate(rotation, velocity)};
+}
+
+// One coordinate of a VSOP87 series and its rate per millennium, for up to
+// kBlock samples. Each term is summed over the whole block before the next,
+// and the powers of tau are folded in by Horner's rule.
+void VsopCoordinate(const std::array<std::span<const VsopTerm>, 6>& series,
+                    const double* tau, size_t count, double* value,
+                    double* rate) {
+  std::fill_n(value, count, 0.0);
+  std::fill_n(rate, count, 0.0);
+  std::array<double, kBlock> sum, sum_rate;
+  for (size_t k = series.size(); k-- > 0;) {
+    sum.fill(0.0);
+    sum_rate.fill(0.0);
+    for (const auto& term : series[k]) {
+      for (size_t i = 0; i < count; ++i) {
+        const double arg = term.b + term.c * tau[i];
+        sum[i] += term.a * std::cos(arg);
+        sum_rate[i] -= term.a * term.c * std::sin(arg);
+      }
+    }
+    for (size_t i = 0; i < count; ++i) {
+      rate[i] = rate[i] * tau[i] + value[i] + sum_rate[i];
+      value[i] = value[i] * tau[i] + sum[i];
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    value[i] *= 1e-8;
+    rate[i] *= 1e-8;
+  }
+}
+
+// Heliocentric states of a planet from its VSOP87 series.
+template <const VsopPlanet& kPlanet>
+void VsopKernel(std::span<const double> jd_tdb, std::span<BodyState> states) {
+  std::array<double, kBlock> tau, lon, lon_rate, lat, lat_rate, r, r_rate;
+  for (size_t start = 0; start < jd_tdb.size(); start += kBlock) {
+    const size_t count = std::min(kBlock, jd_tdb.size() - start);
+    for (size_t i = 0; i < count; ++i) tau[i] = Millennia(jd_tdb[start + i]);
+    VsopCoordinate(kPlanet.longitude, tau.data(), count, lon.data(),
+                   lon_rate.data());
+    VsopCoordinate(kPlanet.latitude, tau.data(), count, lat.data(),
+                   lat_rate.data());
+    VsopCoordinate(kPlanet.radius, tau.data(), count, r.data(), r_rate.data());
+    for (size_t i = 0; i < count; ++i) {
+      // The longitude of a fixed direction grows at the general precession
+      states[start + i] = FromSpherical(
+          lon[i], lat[i], r[i],
+          lon_rate[i] / kDaysPerMillennium - kPrecessionRate,
+          lat_rate[i] / kDaysPerMillennium, r_rate[i] / kDaysPerMillennium,
+          EclipticOfDateToJ2000(tau[i] * 10.0));
+    }
+  }
+}
+
+// Heliocentric states of Pluto from Meeus chapter 37, valid 1885-2099.
+void PlutoKernel(std::span<const double> jd_tdb, std::span<BodyState> states) {
+  // Mean longitudes of Jupiter, Saturn and Pluto at J2000 and their rates,
+  // degrees and degrees per century
+  constexpr double kJupiter = 34.35, kJupiterRate = 3034.9057;
+  constexpr double kSaturn = 50.08, kSaturnRate = 1222.1138;
+  constexpr double kPlutoLongitude = 238.96, kPlutoRate = 144.96;
+  const Rotation equator = EclipticToEquator(kObliquityJ2000);
+
+  std::array<double, kBlock> t, lon, lon_rate, lat, lat_rate, r, r_rate;
+  for (size_t start = 0; start < jd_tdb.size(); start += kBlock) {
+    const size_t count = std::min(kBlock, jd_tdb.size() - start);
+    for (size_t i = 0; i < count; ++i) {
+      t[i] = Centuries(jd_tdb[start + i]);
+      lon[i] = lon_rate[i] = lat[i] = lat_rate[i] = r[i] = r_rate[i] = 0.0;
+    }
+    for (const auto& term : kPluto) {
+      const double phase = (term.j * kJupiter + term.s * kSaturn +
+                            term.p * kPlutoLongitude) *
+                           kDegree;
+      const double speed = (term.j * kJupiterRate + term.s * kSaturnRate +
+                            term.p * kPlutoRate) *
+                           kDegree;
+      for (size_t i = 0; i < count; ++i) {
+        const double s = std::sin(phase + speed * t[i]);
+        const double c = std::cos(phase + speed * t[i]);
+        lon[i] += term.longitude_a * s + term.longitude_b * c;
+        lon_rate[i] += (term.longitude_a * c - term.longitude_b * s) * speed;
+        lat[i] += term.latitude_a * s + term.latitude_b * c;
+        lat_rate[i] += (term.latitude_a * c - term.latitude_b * s) * speed;
+        r[i] += term.radius_a * s + term.radius_b * c;
+        r_rate[i] += (term.radius_a * c - term.radius_b * s) * speed;
+      }
+    }
+    for (size_t i = 0; i < count; ++i) {
+      states[start + i] = FromSpherical(
+          (238.958116 + kPlutoRate * t[i] + lon[i] * 1e-6) * kDegree,
+          (-3.908239 + lat[i] * 1e-6) * kDegree, 40.7241346 + r[i] * 1e-7,
+          (kPlutoRate + lon_rate[i] * 1e-6) * kDegree / kDaysPerCentury,
+          lat_rate[i] * 1e-6 * kDegree / kDaysPerCentury,
+          r_rate[i] * 1e-7 / kDaysPerCentury, equator);
+    }
+  }
+}
+
+// Lunar series for up to kBlock samples. Each term is summed over the whole
+// block before the next, so the inner loops run over time samples.
+void LunarSeries(const double* jd_tdb, size_t count, LunarPosition* out) {
+  std::array<double, kBlock> t, lp, d, m, mp, f, e1, e2, sum_l, sum_r, sum_b;
+  for (size_t i = 0; i < count; ++i) {
+    const double c = Centuries(jd_tdb[i]);
+    const double c2 = c * c, c3 = c2 * c, c4 = c3 * c;
+    t[i] = c;
+    lp[i] = (218.3164477 + 481267.88123421 * c - 0.0015786 * c2 +
+             c3 / 538841.0 - c4 / 65194000.0) *
+            kDegree;
+    d[i] = (297.8501921 + 445267.1114034 * c - 0.0018819 * c2 +
+            c3 / 545868.0 - c4 / 113065000.0) *
+           kDegree;
+    m[i] = (357.5291092 + 35999.0502909 * c - 0.0001536 * c2 +
+            c3 / 24490000.0) *
+           kDegree;
+    mp[i] = (134.9633964 + 477198.8675055 * c + 0.0087414 * c2 +
+             c3 / 69699.0 - c4 / 14712000.0) *
+            kDegree;
+    f[i] = (93.2720950 + 483202.0175233 * c - 0.0036539 * c2 -
+            c3 / 3526000.0 + c4 / 863310000.0) *
+           kDegree;
+    e1[i] = 1.0 - 0.002516 * c - 0.0000074 * c2;
+    e2[i] = e1[i] * e1[i];
+    sum_l[i] = sum_r[i] = sum_b[i] = 0.0;
+  }
+
+  // The eccentricity factor depends on the term, not the sample
+  const std::array<double, kBlock> ones = [] {
+    std::array<double, kBlock> values;
+    values.fill(1.0);
+    return values;
+  }();
+  auto scale = [&](int order) -> const std::array<double, kBlock>& {
+    return order == 0 ? ones : std::abs(order) == 1 ? e1 : e2;
+  };
+  for (const auto& term : kLunarLongitudeDistance) {
+    const auto& factor = scale(term.m);
+    for (size_t i = 0; i < count; ++i) {
+      const double arg =
+          term.d * d[i] + term.m * m[i] + term.mp * mp[i] + term.f * f[i];
+      sum_l[i] += term.longitude * factor[i] * std::sin(arg);
+      sum_r[i] += term.distance * factor[i] * std::cos(arg);
+    }
+  }
+  for (const auto& term : kLunarLatitude) {
+    const auto& factor = scale(term.m);
+    for (size_t i = 0; i < count; ++i) {
+      const double arg =
+          term.d * d[i] + term.m * m[i] + term.mp * mp[i] + term.f * f[i];
+      sum_b[i] += term.latitude * factor[i] * std::sin(arg);
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    // Venus, Jupiter and the flattening of the Earth
+    const double a1 = (119.75 + 131.849 * t[i]) * kDegree;
+    const double a2 = (53.09 + 479264.290 * t[i]) * kDegree;
+    const double a3 = (313.45 + 481266.484 * t[i]) * kDegree;
+    sum_l[i] += 3958.0 * std::sin(a1) + 1962.0 * std::sin(lp[i] - f[i]) +
+                318.0 * std::sin(a2);
+    sum_b[i] += -2235.0 * std::sin(lp[i]) + 382.0 * std::sin(a3) +
+                175.0 * std::sin(a1 - f[i]) + 175.0 * std::sin(a1 + f[i]) +
+                127.0 * std::sin(lp[i] - mp[i]) -
+                115.0 * std::sin(lp[i] + mp[i]);
+
+    const double longitude = lp[i] / kDegree + sum_l[i] * 1e-6;
+    out[i] = {.longitude = longitude - 360.0 * std::floor(longitude / 360.0),
+              .latitude = sum_b[i] * 1e-6,
+              .distance_km = 385000.56 + sum_r[i] * 1e-3};
+  }
+}
+
+// Geocentric equatorial J2000 positions of the Moon in AU, for up to kBlock
+// samples.
+void MoonGeocentric(const double* jd_tdb, size_t count,
+                    std::array<double, 3>* out) {
+  std::array<LunarPosition, kBlock> places;
+  LunarSeries(jd_tdb, count, places.data());
+  for (size_t i = 0; i < count; ++i) {
+    const double lon = places[i].longitude * kDegree;
+    const double lat = places[i].latitude * kDegree;
+    const double r = places[i].distance_km / kAuKm;
+    out[i] = Rotate(EclipticOfDateToJ2000(Centuries(jd_tdb[i])),
+                    {r * std::cos(lat) * std::cos(lon),
+                     r * std::cos(lat) * std::sin(lon), r * std::sin(lat)});
+  }
+}
+
+// The Moon: the Earth plus the lunar series. Its velocity relative to the
+// Earth is a central difference of the series.
+void MoonKernel(std::span<const double> jd_tdb, std::span<BodyState> states) {
+  VsopKernel<kVsopEarth>(jd_tdb, states);
+
+  std::array<double, kBlock> before, after;
+  std::array<std::array<double, 3>, kBlock> moon, moon_before, moon_after;
+  for (size_t start = 0; start < jd_tdb.size(); start += kBlock) {
+    const size_t count = std::min(kBlock, jd_tdb.size() - start);
+    const double* jd = jd_tdb.data() + start;
+    for (size_t i = 0; i < count; ++i) {
+      before[i] = jd[i] - kMoonStep;
+      after[i] = jd[i] + kMoonStep;
+    }
+    MoonGeocentric(jd, count, moon.data());
+    MoonGeocentric(before.data(), count, moon_before.data());
+    MoonGeocentric(after.data(), count, moon_after.data());
+    for (size_t i = 0; i < count; ++i) {
+      auto& state = states[start + i];
+      for (size_t k = 0; k < 3; ++k) {
+        state.position[k] += moon[i][k];
+        state.velocity[k] +=
+            (moon_after[i][k] - moon_before[i][k]) / (2.0 * kMoonStep);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void AnalyticStates(AnalyticBody body, std::span<const double> jd_tdb,
+                    std::span<BodyState> states) {
+  jd_tdb = jd_tdb.first(std::min(jd_tdb.size(), states.size()));
+  switch (body) {
+    case AnalyticBody::SUN:
+      std::fill_n(states.begin(), jd_tdb.size(), BodyState{});
+      break;
+    case AnalyticBody::MERCURY:
+      VsopKernel<kVsopMercury>(jd_tdb, states);
+      break;
+    case AnalyticBody::VENUS:
+      VsopKernel<kVsopVenus>(jd_tdb, states);
+      break;
+    case AnalyticBody::EARTH:
+      VsopKernel<kVsopEarth>(jd_tdb, states);
+      break;
+    case AnalyticBody::MARS:
+      VsopKernel<kVsopMars>(jd_tdb, states);
+      break;
+    case AnalyticBody::JUPITER:
+      VsopKernel<kVsopJupiter>(jd_tdb, states);
+      break;
+    case AnalyticBody::SATURN:
+      VsopKernel<kVsopSaturn>(jd_tdb, states);
+      break;
+    case AnalyticBody::URANUS:
+      VsopKernel<kVsopUranus>(jd_tdb, states);
+      break;
+    case AnalyticBody::NEPTUNE:
+      VsopKernel<kVsopNeptune>(jd_tdb, states);
+      break;
+    case AnalyticBody::PLUTO:
+      PlutoKernel(jd_tdb, states);
+      break;
+    case AnalyticBody::MOON:
+      MoonKernel(jd_tdb, states);
+      break;
+  }
+}
+
+LunarPosition AnalyticMoon(double jd_tdb) {
+  LunarPosition place;
+  LunarSeries(&jd_tdb, 1, &place);
+  return place;
+}
+
+}  // namespace engine
@@ -0,0 +1,332 @@
+#include "binary_catalog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+namespace {
+constexpr char kZcatMagic[4] = {'Z', 'C', 'A', 'T'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr size_t kColumnCount = static_cast<size_t>(ZcatColumn::COUNT);
+
+// Element size of each column, indexed by ZcatColumn
+constexpr size_t kElementSize[kColumnCount] = {
+    sizeof(double),   sizeof(double),   sizeof(double),   sizeof(double),
+    sizeof(double),   sizeof(double),   sizeof(float),    sizeof(float),
+    sizeof(int64_t),  sizeof(char),     sizeof(char),     sizeof(char),
+    sizeof(char),     sizeof(char),     sizeof(uint64_t), sizeof(uint64_t),
+    sizeof(uint64_t), sizeof(char),     sizeof(uint64_t), sizeof(SkyCap)};
+
+constexpr double kMasPerDegree = 3600.0 * 1000.0;
+
+uint64_t AlignUp(uint64_t value) {
+  return (value + kZcatAlignment - 1) / kZcatAlignment * kZcatAlignment;
+}
+
+// Appends a column's raw bytes to the output, padded to the next aligned
+// offset, and records where it went.
+class ColumnWriter {
+ public:
+  ColumnWriter(std::ofstream& out, ZcatHeader& header)
+      : out_(out), header_(header), position_(AlignUp(sizeof(ZcatHeader))) {}
+
+  template <typename T>
+  void Write(ZcatColumn column, const std::vector<T>& values) {
+    uint64_t bytes = values.size() * sizeof(T);
+    header_.columns[static_cast<size_t>(column)] = {position_, bytes};
+    out_.seekp(static_cast<std::streamoff>(position_));
+    out_.write(reinterpret_cast<const char*>(values.data()),
+               static_cast<std::streamsize>(bytes));
+    if (bytes > 0) written_ = position_ + bytes;
+    position_ = AlignUp(position_ + bytes);
+  }
+
+  // Aligned end of the file, and how much of it has actually been written
+  uint64_t end() const { return position_; }
+  uint64_t written() const { return written_; }
+
+ private:
+  std::ofstream& out_;
+  ZcatHeader& header_;
+  uint64_t position_;
+  uint64_t written_ = sizeof(ZcatHeader);
+};
+
+// Magnitude sort key: stars without a magnitude go after every other star
+float MagnitudeKey(const Star& star) {
+  return std::isnan(star.flux) ? std::numeric_limits<float>::infinity()
+                               : star.flux;
+}
+}  // namespace
+
+bool BinaryCatalog::Write(const std::filesystem::path& path,
+                          std::span<const Star> catalog, bool tiled) {
+  // Rows, tiles and catalog_index are 32-bit
+  if (catalog.size() > std::numeric_limits<uint32_t>::max()) {
+    std::cerr << "Error: Too many stars for binary catalog " << path
+              << std::endl;
+    return false;
+  }
+
+  // Written beside the target and renamed over it: an engine may have the
+  // old file mapped, or reload it as soon as it changes
+  auto temp_path = path;
+  temp_path += ".tmp";
+  std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    std::cerr << "Error: Could not write binary catalog " << path
+              << std::endl;
+    return false;
+  }
+
+  ZcatHeader header{};
+  std::memcpy(header.magic, kZcatMagic, sizeof(kZcatMagic));
+  header.version = kZcatVersion;
+  header.byte_order = kByteOrderMark;
+  header.column_count = kColumnCount;
+  header.tile_depth = tiled ? SkyIndex::kDefaultDepth : -1;
+  header.star_count = catalog.size();
+  for (const auto& star : catalog) {
+    header.max_proper_motion =
+        std::max(header.max_proper_motion,
+                 std::hypot(star.pmra, star.pmdec) / kMasPerDegree);
+  }
+
+  // Rows in file order, as positions in `catalog`
+  std::vector<uint32_t> rows(catalog.size());
+  std::iota(rows.begin(), rows.end(), 0u);
+  std::vector<uint64_t> tile_offsets;
+  std::vector<SkyCap> tile_caps;
+  if (tiled) {
+    std::vector<double> x(catalog.size()), y(catalog.size()),
+        z(catalog.size());
+    for (size_t i = 0; i < catalog.size(); ++i) {
+      auto v = SkyVector::FromRaDec(catalog[i].ra, catalog[i].dec);
+      x[i] = v.x;
+      y[i] = v.y;
+      z[i] = v.z;
+    }
+    SkyIndex index;
+    index.Build(x, y, z, header.tile_depth);
+    rows.assign(index.order().begin(), index.order().end());
+
+    uint32_t tiles = SkyIndex::TileCount(header.tile_depth);
+    tile_offsets.reserve(tiles + 1);
+    tile_caps.reserve(tiles);
+    for (uint32_t tile = 0; tile < tiles; ++tile) {
+      auto members = index.Members(tile);
+      std::stable_sort(rows.begin() + members.begin,
+                       rows.begin() + members.end,
+                       [&](uint32_t a, uint32_t b) {
+                         return MagnitudeKey(catalog[a]) <
+                                MagnitudeKey(catalog[b]);
+                       });
+      tile_offsets.push_back(members.begin);
+      tile_caps.push_back(index.Cap(header.tile_depth, tile));
+    }
+    tile_offsets.push_back(catalog.size());
+  }
+
+  ColumnWriter writer(out, header);
+  auto write_column = [&](ZcatColumn column, auto field) {
+    using T = decltype(field(catalog.front()));
+    std::vector<T> values;
+    values.reserve(catalog.size());
+    for (uint32_t row : rows) values.push_back(field(catalog[row]));
+    writer.Write(column, values);
+  };
+
+  write_column(ZcatColumn::RA, [](const Star& s) { return s.ra; });
+  write_column(ZcatColumn::DEC, [](const Star& s) { return s.dec; });
+  write_column(ZcatColumn::PMRA, [](const Star& s) { return s.pmra; });
+  write_column(ZcatColumn::PMDEC, [](const Star& s) { return s.pmdec; });
+  write_column(ZcatColumn::PARALLAX,
+               [](const Star& s) { return s.parallax; });
+  write_column(ZcatColumn::RADIAL_VELOCITY,
+               [](const Star& s) { return s.radial_velocity; });
+  write_column(ZcatColumn::FLUX, [](const Star& s) { return s.flux; });
+  write_column(ZcatColumn::FLUX_ERR,
+               [](const Star& s) { return s.flux_err; });
+  write_column(ZcatColumn::CATALOG_ID, [](const Star& s) {
+    return static_cast<int64_t>(s.catalog_id);
+  });
+  write_column(ZcatColumn::COO_QUAL, [](const Star& s) { return s.coo_qual; });
+  write_column(ZcatColumn::PM_QUAL, [](const Star& s) { return s.pm_qual; });
+  write_column(ZcatColumn::PLX_QUAL,
+               [](const Star& s) { return s.plx_qual; });
+  write_column(ZcatColumn::RVZ_QUAL,
+               [](const Star& s) { return s.rvz_qual; });
+  write_column(ZcatColumn::FLUX_QUAL,
+               [](const Star& s) { return s.flux_qual; });
+
+  // Strings go back to back into one pool, addressed by offset tables
+  std::vector<char> pool;
+  auto write_strings = [&](ZcatColumn column, auto field) {
+    std::vector<uint64_t> offsets;
+    offsets.reserve(catalog.size() + 1);
+    offsets.push_back(pool.size());
+    for (uint32_t row : rows) {
+      const std::string& value = field(catalog[row]);
+      pool.insert(pool.end(), value.begin(), value.end());
+      offsets.push_back(pool.size());
+    }
+    writer.Write(column, offsets);
+  };
+  write_strings(ZcatColumn::NAME_OFFSETS,
+                [](const Star& s) -> const std::string& { return s.name; });
+  write_strings(ZcatColumn::CATALOG_OFFSETS,
+                [](const Star& s) -> const std::string& { return s.catalog; });
+  write_strings(ZcatColumn::IDS_OFFSETS,
+                [](const Star& s) -> const std::string& { return s.ids; });
+  writer.Write(ZcatColumn::STRING_POOL, pool);
+  writer.Write(ZcatColumn::TILE_OFFSETS, tile_offsets);
+  writer.Write(ZcatColumn::TILE_CAPS, tile_caps);
+
+  header.file_size = writer.end();
+  if (header.file_size > writer.written()) {
+    // Pad the file out to its aligned size
+    out.seekp(static_cast<std::streamoff>(header.file_size - 1));
+    out.put('\0');
+  }
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.close();
+
+  if (!out.good()) {
+    std::cerr << "Error: Could not write binary catalog " << path
+              << std::endl;
+    std::filesystem::remove(temp_path);
+    return false;
+  }
+
+  // Readers either see the old catalog or the complete new one
+  std::error_code error;
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    std::cerr << "Error: Could not replace binary catalog " << path << " ("
+              << error.message() << ")" << std::endl;
+    std::filesystem::remove(temp_path, error);
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const BinaryCatalog> BinaryCatalog::Open(
+    const std::filesystem::path& path) {
+  auto file = MappedFile::Open(path);
+  if (!file) return nullptr;
+
+  auto reject = [&](const char* reason) {
+    std::cerr << "Error: " << path << " is not a usable binary catalog ("
+              << reason << ")" << std::endl;
+    return nullptr;
+  };
+
+  if (file->size() < sizeof(ZcatHeader)) return reject("truncated header");
+  const auto* header = reinterpret_cast<const ZcatHeader*>(file->data());
+  if (std::memcmp(header->magic, kZcatMagic, sizeof(kZcatMagic)) != 0) {
+    return reject("bad magic");
+  }
+  if (header->byte_order != kByteOrderMark) return reject("byte order");
+  if (header->version != kZcatVersion) return reject("unsupported version");
+  if (header->column_count != kColumnCount) return reject("column count");
+  if (header->file_size != file->size()) return reject("truncated file");
+  if (header->tile_depth > SkyIndex::kMaxDepth) return reject("tile depth");
+
+  // Every column must lie inside the file, be aligned, and hold exactly one
+  // entry per star (one more for offset tables).
+  const uint64_t count = header->star_count;
+  if (count > file->size() || count > std::numeric_limits<uint32_t>::max()) {
+    return reject("star count");
+  }
+  for (size_t c = 0; c < kColumnCount; ++c) {
+    const auto& extent = header->columns[c];
+    if (extent.offset % kZcatAlignment != 0 || extent.offset > file->size() ||
+        extent.bytes > file->size() - extent.offset) {
+      return reject("column out of range");
+    }
+    if (c == static_cast<size_t>(ZcatColumn::STRING_POOL)) continue;
+
+    uint64_t entries = count;
+    if (c >= static_cast<size_t>(ZcatColumn::NAME_OFFSETS)) ++entries;
+    if (c == static_cast<size_t>(ZcatColumn::TILE_OFFSETS)) {
+      entries = header->tile_depth < 0
+                    ? 0
+                    : SkyIndex::TileCount(header->tile_depth) + uint64_t{1};
+    } else if (c == static_cast<size_t>(ZcatColumn::TILE_CAPS)) {
+      entries = header->tile_depth < 0
+                    ? 0
+                    : SkyIndex::TileCount(header->tile_depth);
+    }
+    if (extent.bytes != entries * kElementSize[c]) {
+      return reject("column size");
+    }
+  }
+
+  auto catalog = std::shared_ptr<BinaryCatalog>(new BinaryCatalog());
+  catalog->file_ = file;
+  catalog->header_ = header;
+  catalog->star_count_ = count;
+  catalog->pool_ = reinterpret_cast<const char*>(
+      file->data() +
+      header->columns[static_cast<size_t>(ZcatColumn::STRING_POOL)].offset);
+
+  // String offsets must be non-decreasing and end inside the pool, so that
+  // every view handed out later is in bounds.
+  uint64_t pool_bytes =
+      header->columns[static_cast<size_t>(ZcatColumn::STRING_POOL)].bytes;
+  for (auto column : {ZcatColumn::NAME_OFFSETS, ZcatColumn::CATALOG_OFFSETS,
+                      ZcatColumn::IDS_OFFSETS}) {
+    auto offsets = catalog->Column<uint64_t>(column);
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+      if (offsets[i] > offsets[i + 1]) return reject("string offsets");
+    }
+    if (offsets.back() > pool_bytes) return reject("string offsets");
+  }
+
+  // Tile ranges must cover every row, in order
+  if (catalog->tiled()) {
+    auto offsets = catalog->tile_offsets();
+    if (offsets.front() != 0 || offsets.back() != count) {
+      return reject("tile offsets");
+    }
+    for (size_t t = 0; t + 1 < offsets.size(); ++t) {
+      if (offsets[t] > offsets[t + 1]) return reject("tile offsets");
+    }
+  }
+
+  return catalog;
+}
+
+Star BinaryCatalog::GetStar(size_t i) const {
+  return Star{
+      .name = std::string(name(i)),
+      .catalog = std::string(catalog(i)),
+      .catalog_id = static_cast<long>(catalog_id()[i]),
+      .ra = ra()[i],
+      .dec = dec()[i],
+      .coo_qual = quality(ZcatColumn::COO_QUAL)[i],
+      .pmra = pmra()[i],
+      .pmdec = pmdec()[i],
+      .pm_qual = quality(ZcatColumn::PM_QUAL)[i],
+      .parallax = parallax()[i],
+      .plx_qual = quality(ZcatColumn::PLX_QUAL)[i],
+      .radial_velocity = radial_velocity()[i],
+      .rvz_qual = quality(ZcatColumn::RVZ_QUAL)[i],
+      .flux = flux()[i],
+      .flux_err = flux_err()[i],
+      .flux_qual = quality(ZcatColumn::FLUX_QUAL)[i],
+      .ids = std::string(ids(i)),
+  };
+}
+
+}  // namespace engine
@@ -1,162 +1,579 @@
 #include "catalog_loader.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <nlohmann/json.hpp>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "mapped_file.hpp"
+
 namespace engine {
 
+namespace {
+// Parses the number after a catalog prefix ("HIP 32349"), or 0
+long ParseCatalogId(std::string_view digits) {
+  while (!digits.empty() && digits.front() == ' ') digits.remove_prefix(1);
+  long id = 0;
+  auto [end, error] =
+      std::from_chars(digits.data(), digits.data() + digits.size(), id);
+  return error == std::errc() ? id : 0;
+}
+
+// Picks a display name and catalog ID out of the '|' separated SIMBAD ids
+void ApplyIdentifiers(Star& star) {
+  std::string_view ids = star.ids;
+  while (!ids.empty()) {
+    size_t bar = ids.find('|');
+    std::string_view id_token = ids.substr(0, bar);
+    ids.remove_prefix(bar == std::string_view::npos ? ids.size() : bar + 1);
+
+    if (id_token.starts_with("NAME ") && star.name.empty()) {
+      star.name = id_token.substr(5);
+    } else if (id_token.starts_with("HIP ")) {
+      star.catalog = "HIP";
+      star.catalog_id = ParseCatalogId(id_token.substr(4));
+    } else if (star.catalog.empty() && id_token.starts_with("FK5 ")) {
+      star.catalog = "FK5";
+      star.catalog_id = ParseCatalogId(id_token.substr(4));
+    } else if (star.catalog.empty() && id_token.starts_with("GC ")) {
+      star.catalog = "GC";
+      star.catalog_id = ParseCatalogId(id_token.substr(3));
+    }
+  }
+}
+
+// Columns of a catalog CSV file, in order. Rows may end after `dec`; the
+// remaining fields keep their defaults.
+constexpr std::string_view kCsvColumns[] = {
+    "name", "catalog", "catalog_id", "ra", "dec", "coo_qual", "pmra",
+    "pmdec", "pm_qual", "parallax", "plx_qual", "radial_velocity",
+    "rvz_qual", "flux", "flux_err", "flux_qual", "ids"};
+constexpr size_t kCsvRequiredColumns = 5;
+
+// Bytes per parallel CSV chunk, before extending it to the next newline
+constexpr size_t kCsvChunkBytes = 1 << 20;
+
+// Malformed rows printed individually before just counting them
+constexpr size_t kMaxReportedRows = 10;
+
+// Parses a whole numeric field. Surrounding spaces are ignored and an empty
+// field reads as 0.
+template <typename T>
+bool ParseNumber(std::string_view field, T& value) {
+  while (!field.empty() && field.front() == ' ') field.remove_prefix(1);
+  while (!field.empty() && field.back() == ' ') field.remove_suffix(1);
+  if (field.empty()) {
+    value = T{};
+    return true;
+  }
+  if (field.front() == '+') field.remove_prefix(1);
+  auto [end, error] =
+      std::from_chars(field.data(), field.data() + field.size(), value);
+  return error == std::errc() && end == field.data() + field.size();
+}
+
+char ParseQuality(std::string_view field) {
+  return field.empty() ? ' ' : field.front();
+}
+
+// Stores one field. Returns false if a numeric field does not parse.
+bool SetCsvField(Star& star, size_t column, std::string_view field) {
+  switch (column) {
+    case 0:
+      star.name = field;
+      return true;
+    case 1:
+      star.catalog = field;
+      return true;
+    case 2:
+      return ParseNumber(field, star.catalog_id);
+    case 3:
+      return ParseNumber(field, star.ra);
+    case 4:
+      return ParseNumber(field, star.dec);
+    case 5:
+      star.coo_qual = ParseQuality(field);
+      return true;
+    case 6:
+      return ParseNumber(field, star.pmra);
+    case 7:
+      return ParseNumber(field, star.pmdec);
+    case 8:
+      star.pm_qual = ParseQuality(field);
+      return true;
+    case 9:
+      return ParseNumber(field, star.parallax);
+    case 10:
+      star.plx_qual = ParseQuality(field);
+      return true;
+    case 11:
+      return ParseNumber(field, star.radial_velocity);
+    case 12:
+      star.rvz_qual = ParseQuality(field);
+      return true;
+    case 13:
+      return ParseNumber(field, star.flux);
+    case 14:
+      return ParseNumber(field, star.flux_err);
+    case 15:
+      star.flux_qual = ParseQuality(field);
+      return true;
+    case 16:
+      star.ids = field;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Parses one CSV line into `star`. Fields may be double-quoted, with "" for
+// a literal quote, but cannot span lines. Returns an empty string on
+// success, or why the row was rejected.
+std::string ParseCsvRow(std::string_view line, Star& star,
+                        std::string& unquoted) {
+  star = Star{.coo_qual = ' ',
+              .pm_qual = ' ',
+              .plx_qual = ' ',
+              .rvz_qual = ' ',
+              .flux_qual = ' '};
+  size_t column = 0;
+  while (true) {
+    std::string_view field;
+    if (!line.empty() && line.front() == '"') {
+      unquoted.clear();
+      size_t i = 1;
+      bool closed = false;
+      while (i < line.size()) {
+        if (line[i] == '"') {
+          if (i + 1 < line.size() && line[i + 1] == '"') {
+            unquoted += '"';
+            i += 2;
+            continue;
+          }
+          closed = true;
+          ++i;
+          break;
+        }
+        unquoted += line[i++];
+      }
+      if (!closed) return "unterminated quote";
+      if (i < line.size() && line[i] != ',') return "text after closing quote";
+      field = unquoted;
+      line.remove_prefix(i);
+    } else {
+      size_t comma = line.find(',');
+      field = line.substr(0, comma);
+      line.remove_prefix(comma == std::string_view::npos ? line.size()
+                                                         : comma);
+    }
+
+    if (column >= std::size(kCsvColumns)) {
+      return "more than " + std::to_string(std::size(kCsvColumns)) +
+             " columns";
+    }
+    if (!SetCsvField(star, column, field)) {
+      return "invalid " + std::string(kCsvColumns[column]) + " '" +
+             std::string(field) + "'";
+    }
+    ++column;
+
+    if (line.empty()) break;
+    line.remove_prefix(1);  // The comma
+  }
+
+  if (column < kCsvRequiredColumns) {
+    return "expected at least " + std::to_string(kCsvRequiredColumns) +
+           " columns, found " + std::to_string(column);
+  }
+  return {};
+}
+
+// Stars and rejected rows of one chunk. Error line numbers are relative to
+// the chunk's first line (0-based) until the chunks are stitched together.
+struct CsvChunk {
+  std::vector<Star> stars;
+  std::vector<CatalogRowError> errors;
+  size_t lines = 0;
+};
+
+void ParseCsvChunk(std::string_view text, const CatalogFilter& filter,
+                   CsvChunk& chunk) {
+  std::string unquoted;
+  Star star;
+  while (!text.empty()) {
+    size_t newline = text.find('\n');
+    std::string_view line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                         : newline + 1);
+    size_t line_index = chunk.lines++;
+
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (line.empty()) continue;
+
+    std::string error = ParseCsvRow(line, star, unquoted);
+    if (error.empty()) {
+      if (filter.Accepts(star)) chunk.stars.push_back(std::move(star));
+    } else {
+      chunk.errors.push_back({line_index, std::move(error)});
+    }
+  }
+}
+
+// Streams a SIMBAD TAP export ({"data": [[...], ...]}) straight into Star
+// records, one row at a time, without building a DOM. Only the current row
+// is held besides the output, and rows the filter rejects are dropped as
+// soon as they close.
+//
+// Positional fields of each row:
+// 0: main_id, 1: ra, 2: dec, 3: coo_qual, 4: pmra, 5: pmdec, 6: pm_qual,
+// 7: plx, 8: plx_qual, 9: rv, 10: rv_qual, 11: flux, 12: flux_err,
+// 13: flux_qual, 14: ids
+class StarSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+ public:
+  StarSaxHandler(std::vector<Star>& catalog, const CatalogFilter& filter)
+      : catalog_(catalog), filter_(filter) {}
+
+  bool null() override { return Skip(); }
+  bool boolean(bool) override { return Skip(); }
+  bool number_integer(number_integer_t value) override {
+    return Number(static_cast<double>(value));
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    return Number(static_cast<double>(value));
+  }
+  bool number_float(number_float_t value, const string_t&) override {
+    return Number(value);
+  }
+  bool string(string_t& value) override;
+  bool binary(binary_t&) override { return Skip(); }
+
+  bool key(string_t& key) override {
+    if (depth_ == 1) data_key_ = key == "data";
+    return true;
+  }
+  bool start_object(std::size_t) override {
+    Skip();
+    ++depth_;
+    return true;
+  }
+  bool end_object() override {
+    --depth_;
+    return true;
+  }
+  bool start_array(std::size_t) override;
+  bool end_array() override;
+
+  bool parse_error(std::size_t, const std::string&,
+                   const nlohmann::detail::exception& e) override {
+    std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
+    return false;
+  }
+
+ private:
+  static constexpr size_t kColumns = 15;
+
+  bool InRow() const { return in_row_ && depth_ == data_depth_ + 1; }
+
+  // Anything that is not a field of interest still takes up a column
+  bool Skip() {
+    if (InRow()) ++column_;
+    return true;
+  }
+
+  bool Number(double value);
+
+  std::vector<Star>& catalog_;
+  const CatalogFilter& filter_;
+  size_t depth_ = 0;       // Open objects and arrays
+  size_t data_depth_ = 0;  // Depth inside the "data" array, 0 outside it
+  bool data_key_ = false;  // The next top-level value is "data"
+  bool in_row_ = false;
+  size_t column_ = 0;
+  Star star_;
+  std::string main_id_;
+};
+
+bool StarSaxHandler::start_array(std::size_t) {
+  Skip();
+  ++depth_;
+  if (data_depth_ == 0) {
+    if (depth_ == 2 && data_key_) data_depth_ = depth_;
+  } else if (depth_ == data_depth_ + 1) {
+    in_row_ = true;
+    column_ = 0;
+    star_ = Star{.coo_qual = ' ',
+                 .pm_qual = ' ',
+                 .plx_qual = ' ',
+                 .rvz_qual = ' ',
+                 .flux_qual = ' '};
+    main_id_ = "Unknown";
+  }
+  return true;
+}
+
+bool StarSaxHandler::end_array() {
+  if (InRow()) {
+    in_row_ = false;
+    if (column_ >= kColumns && filter_.Accepts(star_)) {
+      ApplyIdentifiers(star_);
+      if (star_.name.empty()) star_.name = std::move(main_id_);
+      catalog_.push_back(std::move(star_));
+    }
+  } else if (data_depth_ != 0 && depth_ == data_depth_) {
+    data_depth_ = 0;
+  }
+  --depth_;
+  return true;
+}
+
+bool StarSaxHandler::Number(double value) {
+  if (!InRow()) return true;
+  switch (column_++) {
+    case 1:
+      star_.ra = value;
+      break;
+    case 2:
+      star_.dec = value;
+      break;
+    case 4:
+      star_.pmra = value;
+      break;
+    case 5:
+      star_.pmdec = value;
+      break;
+    case 7:
+      star_.parallax = value;
+      break;
+    case 9:
+      star_.radial_velocity = value;
+      break;
+    case 11:
+      star_.flux = static_cast<float>(value);
+      break;
+    case 12:
+      star_.flux_err = static_cast<float>(value);
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+bool StarSaxHandler::string(string_t& value) {
+  if (!InRow()) return true;
+  char qual = value.empty() ? ' ' : value[0];
+  switch (column_++) {
+    case 0:
+      main_id_ = std::move(value);
+      break;
+    case 3:
+      star_.coo_qual = qual;
+      break;
+    case 6:
+      star_.pm_qual = qual;
+      break;
+    case 8:
+      star_.plx_qual = qual;
+      break;
+    case 10:
+      star_.rvz_qual = qual;
+      break;
+    case 13:
+      star_.flux_qual = qual;
+      break;
+    case 14:
+      star_.ids = std::move(value);
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+constexpr size_t kHashChunkBytes = 1 << 20;
+
+// 64-bit hash of a byte range, a word at a time (xxHash64-style rounds).
+// Not cryptographic; it only has to tell catalog files apart.
+uint64_t HashBytes(const std::byte* data, size_t size, uint64_t seed) {
+  constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+  uint64_t hash = seed ^ (size * kPrime1);
+  auto mix = [&](uint64_t word) {
+    hash ^= std::rotl(word * kPrime2, 31) * kPrime1;
+    hash = std::rotl(hash, 27) * kPrime1 + 0x85EBCA77C2B2AE63ull;
+  };
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    mix(word);
+  }
+  if (i < size) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + i, size - i);
+    mix(word);
+  }
+
+  // Final avalanche
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= 0x165667B19E3779F9ull;
+  hash ^= hash >> 32;
+  return hash;
+}
+}  // namespace
+
 std::vector<Star> CatalogLoader::LoadStarDataFromCSV(
-    const std::filesystem::path& path) {
+    const std::filesystem::path& path, const CatalogFilter& filter,
+    std::vector<CatalogRowError>* bad_rows, ThreadPool& pool) {
   std::vector<Star> catalog;
-  std::ifstream file(path);
-  if (!file.is_open()) {
+  auto file = MappedFile::Open(path);
+  if (!file) {
     std::cerr << "Error: Could not open star catalog " << path << std::endl;
     return catalog;
   }
 
-  std::string line;
-  // Skip header
-  std::getline(file, line);
+  std::string_view text(reinterpret_cast<const char*>(file->data()),
+                        file->size());
+
+  // Skip header, then cut the rest into newline-aligned chunks
+  size_t start = std::min(text.find('\n'), text.size());
+  if (start < text.size()) ++start;
+  std::vector<std::string_view> chunks;
+  while (start < text.size()) {
+    size_t end = std::min(start + kCsvChunkBytes, text.size());
+    end = std::min(text.find('\n', end), text.size());
+    if (end < text.size()) ++end;
+    chunks.push_back(text.substr(start, end - start));
+    start = end;
+  }
 
-  while (std::getline(file, line)) {
-    std::stringstream ss(line);
-    std::string field;
-    Star star;
+  std::vector<CsvChunk> parsed(chunks.size());
+  pool.ParallelFor(chunks.size(), 1, [&](size_t c) {
+    ParseCsvChunk(chunks[c], filter, parsed[c]);
+  });
 
-    std::getline(ss, star.name, ',');
-    std::getline(ss, star.catalog, ',');
-    std::getline(ss, field, ',');
-    star.catalog_id = std::stol(field);
-    std::getline(ss, field, ',');
-    star.ra = std::stod(field);
-    std::getline(ss, field, ',');
-    star.dec = std::stod(field);
-    // ... parse other fields if needed ...
+  // Stitch the chunks together in file order. Line numbers are 1-based and
+  // the header is line 1.
+  size_t total = 0;
+  for (const auto& chunk : parsed) total += chunk.stars.size();
+  catalog.reserve(total);
 
-    catalog.push_back(star);
+  std::vector<CatalogRowError> errors;
+  size_t first_line = 2;
+  for (auto& chunk : parsed) {
+    std::move(chunk.stars.begin(), chunk.stars.end(),
+              std::back_inserter(catalog));
+    for (auto& error : chunk.errors) {
+      error.line += first_line;
+      errors.push_back(std::move(error));
+    }
+    first_line += chunk.lines;
   }
 
+  if (!errors.empty()) {
+    for (size_t i = 0; i < std::min(errors.size(), kMaxReportedRows); ++i) {
+      std::cerr << "Warning: " << path.string() << ":" << errors[i].line
+                << ": " << errors[i].reason << std::endl;
+    }
+    std::cerr << "Warning: Skipped " << errors.size() << " malformed row(s) in "
+              << path << std::endl;
+  }
+  if (bad_rows) *bad_rows = std::move(errors);
+
   return catalog;
 }
 
 std::vector<Star> CatalogLoader::LoadStarDataFromJSON(
-    const std::filesystem::path& path) {
+    const std::filesystem::path& path, const CatalogFilter& filter) {
   std::vector<Star> catalog;
-  std::ifstream file(path);
-  if (!file.is_open()) {
+  auto file = MappedFile::Open(path);
+  if (!file) {
     std::cerr << "Error: Could not open star catalog " << path << std::endl;
     return catalog;
   }
 
   try {
-    nlohmann::json json;
-    file >> json;
-
-    if (!json.contains("data") || !json["data"].is_array()) {
-      return catalog;
+    const char* begin = reinterpret_cast<const char*>(file->data());
+    StarSaxHandler handler(catalog, filter);
+    if (!nlohmann::json::sax_parse(begin, begin + file->size(), &handler)) {
+      catalog.clear();
     }
+  } catch (const nlohmann::json::exception& e) {
+    std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
+    catalog.clear();
+  }
 
-    catalog.reserve(json["data"].size());
-
-    for (const auto& item : json["data"]) {
-      if (!item.is_array() || item.size() < 15) {
-        continue;
-      }
+  catalog.shrink_to_fit();
+  return catalog;
+}
 
-      Star star;
-      // Positional fields from JSON
-      // 0: main_id, 1: ra, 2: dec, 3: coo_qual, 4: pmra, 5: pmdec, 6: pm_qual,
-      // 7: plx, 8: plx_qual, 9: rv, 10: rv_qual, 11: flux, 12: flux_err,
-      // 13: flux_qual, 14: ids
-      star.ra = item[1].is_number() ? item[1].get<double>() : 0.0;
-      star.dec = item[2].is_number() ? item[2].get<double>() : 0.0;
-      star.coo_qual =
-          (item[3].is_string() && !item[3].get<std::string>().empty())
-              ? item[3].get<std::string>()[0]
-              : ' ';
-      star.pmra = item[4].is_number() ? item[4].get<double>() : 0.0;
-      star.pmdec = item[5].is_number() ? item[5].get<double>() : 0.0;
-      star.pm_qual =
-          (item[6].is_string() && !item[6].get<std::string>().empty())
-              ? item[6].get<std::string>()[0]
-              : ' ';
-      star.parallax = item[7].is_number() ? item[7].get<double>() : 0.0;
-      star.plx_qual =
-          (item[8].is_string() && !item[8].get<std::string>().empty())
-              ? item[8].get<std::string>()[0]
-              : ' ';
-      star.radial_velocity = item[9].is_number() ? item[9].get<double>() : 0.0;
-      star.rvz_qual =
-          (item[10].is_string() && !item[10].get<std::string>().empty())
-              ? item[10].get<std::string>()[0]
-              : ' ';
-      star.flux = item[11].is_number() ? item[11].get<float>() : 0.0f;
-      star.flux_err = item[12].is_number() ? item[12].get<float>() : 0.0f;
-      star.flux_qual =
-          (item[13].is_string() && !item[13].get<std::string>().empty())
-              ? item[13].get<std::string>()[0]
-              : ' ';
-      star.ids = item[14].is_string() ? item[14].get<std::string>() : "";
-
-      // Parse IDs for better name and Catalog ID
-      if (!star.ids.empty()) {
-        std::stringstream ss(star.ids);
-        std::string id_token;
-        while (std::getline(ss, id_token, '|')) {
-          if (id_token.starts_with("NAME ") && star.name.empty()) {
-            star.name = id_token.substr(5);
-          } else if (id_token.starts_with("HIP ")) {
-            star.catalog = "HIP";
-            try {
-              star.catalog_id = std::stol(id_token.substr(4));
-            } catch (...) {
-              star.catalog_id = 0;
-            }
-          } else if (star.catalog.empty() && id_token.starts_with("FK5 ")) {
-            star.catalog = "FK5";
-            try {
-              star.catalog_id = std::stol(id_token.substr(4));
-            } catch (...) {
-              star.catalog_id = 0;
-            }
-          } else if (star.catalog.empty() && id_token.starts_with("GC ")) {
-            star.catalog = "GC";
-            try {
-              star.catalog_id = std::stol(id_token.substr(3));
-            } catch (...) {
-              star.catalog_id = 0;
-            }
-          }
-        }
-      }
+std::shared_ptr<const BinaryCatalog> CatalogLoader::OpenBinaryCatalog(
+    const std::filesystem::path& path) {
+  return BinaryCatalog::Open(path);
+}
 
-      if (star.name.empty()) {
-        star.name =
-            item[0].is_string() ? item[0].get<std::string>() : "Unknown";
-      }
+bool CatalogLoader::ConvertToBinaryCatalog(const std::filesystem::path& input,
+                                           const std::filesystem::path& output,
+                                           const CatalogFilter& filter,
+                                           bool tiled) {
+  std::vector<Star> catalog;
+  if (input.extension() == ".json") {
+    catalog = LoadStarDataFromJSON(input, filter);
+  } else if (input.extension() == ".csv") {
+    catalog = LoadStarDataFromCSV(input, filter);
+  } else {
+    std::cerr << "Error: Unknown catalog format " << input << std::endl;
+    return false;
+  }
 
-      catalog.push_back(star);
-    }
-  } catch (const nlohmann::json::exception& e) {
-    std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
+  if (catalog.empty()) {
+    std::cerr << "Error: No stars read from " << input << std::endl;
+    return false;
   }
+  return BinaryCatalog::Write(output, catalog, tiled);
+}
 
-  return catalog;
+std::optional<uint64_t> CatalogLoader::HashCatalogFile(
+    const std::filesystem::path& path, ThreadPool& pool) {
+  auto file = MappedFile::Open(path);
+  if (!file) return std::nullopt;
+
+  // Chunk hashes are independent, then hashed together in file order
+  const size_t size = file->size();
+  const size_t chunks = (size + kHashChunkBytes - 1) / kHashChunkBytes;
+  std::vector<uint64_t> hashes(chunks);
+  pool.ParallelFor(chunks, 1, [&](size_t c) {
+    size_t begin = c * kHashChunkBytes;
+    hashes[c] = HashBytes(file->data() + begin,
+                          std::min(kHashChunkBytes, size - begin), c);
+  });
+  return HashBytes(reinterpret_cast<const std::byte*>(hashes.data()),
+                   hashes.size() * sizeof(uint64_t), size);
 }
 
 std::shared_ptr<t_calcephbin> CatalogLoader::LoadFromEphemeris(
-    const std::filesystem::path& path) {
+    const std::filesystem::path& path, bool prefetch) {
   t_calcephbin* handle = calceph_open(path.string().c_str());
   if (!handle) {
     std::cerr << "Error: Could not open ephemeris file " << path << std::endl;
     return nullptr;
   }
+  if (prefetch && !calceph_prefetch(handle)) {
+    std::cerr << "Warning: Could not prefetch ephemeris file " << path
+              << "; solar system bodies will be computed serially"
+              << std::endl;
+  }
 
   return std::shared_ptr<t_calcephbin>(handle, [](t_calcephbin* h) {
     if (h) calceph_close(h);
@@ -0,0 +1,39 @@
+#include "chebyshev.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace engine {
+
+double ChebyshevSeries::Node(size_t k, size_t count, double start,
+                             double end) {
+  double x = std::cos(std::numbers::pi * (static_cast<double>(k) + 0.5) /
+                      static_cast<double>(count));
+  return 0.5 * (start + end) + 0.5 * (end - start) * x;
+}
+
+ChebyshevSeries ChebyshevSeries::Fit(std::span<const double> samples,
+                                     double start, double end) {
+  ChebyshevSeries series;
+  series.start_ = start;
+  series.end_ = end;
+  series.size_ = std::min(samples.size(), kMaxCoefficients);
+
+  // Discrete orthogonality of the T_j at the nodes gives each coefficient
+  // directly; c_0 is halved so that evaluation is a plain sum.
+  const size_t n = series.size_;
+  for (size_t j = 0; j < n; ++j) {
+    double sum = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+      sum += samples[k] * std::cos(std::numbers::pi * static_cast<double>(j) *
+                                   (static_cast<double>(k) + 0.5) /
+                                   static_cast<double>(n));
+    }
+    series.coefficients_[j] = 2.0 * sum / static_cast<double>(n);
+  }
+  if (n > 0) series.coefficients_[0] *= 0.5;
+  return series;
+}
+
+}  // namespace engine
@@ -4,11 +4,14 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
-#include <execution>
 #include <filesystem>
 #include <format>
+#include <fstream>
 #include <iostream>
 #include <mutex>
+#include <numbers>
+#include <numeric>
+#include <optional>
 #include <ranges>
 
 extern "C" {
@@ -16,110 +19,839 @@ extern "C" {
 #include <novas.h>
 }
 
+#include "analytic_ephemeris.hpp"
+#include "binary_catalog.hpp"
 #include "constants.hpp"
+#include "ephemeris_preloader.hpp"
 #include "julian.hpp"
+#include "mapped_file.hpp"
+#include "planet_cache.hpp"
+#include "result_pipeline.hpp"
+#include "string_arena.hpp"
 
 namespace engine {
 
-struct AstrometryEngine::PrebuiltCatalog {
-  std::vector<cat_entry> star_entries;
-  std::vector<object> stars;
-  std::vector<object> planets;
+// Star data is stored column-wise: the transform loop only streams the
+// coordinate columns, while names and identifiers live in a separate cold
+// table that is touched only for stars that survive the filters.
+struct StarColumns {
+  std::vector<double> ra;               // ICRS Right Ascension (hours)
+  std::vector<double> dec;              // ICRS Declination (degrees)
+  std::vector<double> pm_ra;            // Proper motion in RA (mas/yr)
+  std::vector<double> pm_dec;           // Proper motion in DEC (mas/yr)
+  std::vector<double> parallax;         // Parallax (mas)
+  std::vector<double> radial_velocity;  // Radial velocity (km/s)
+  std::vector<float> magnitude;         // Visual magnitude
+
+  // Derived columns for AccuracyMode::FAST: the ICRS unit vector at the
+  // catalog epoch (J2000) and its rate of change from proper motion (rad/yr).
+  std::vector<double> unit_x;
+  std::vector<double> unit_y;
+  std::vector<double> unit_z;
+  std::vector<double> motion_x;
+  std::vector<double> motion_y;
+  std::vector<double> motion_z;
+
+  size_t size() const { return ra.size(); }
+
+  void clear() {
+    ra.clear();
+    dec.clear();
+    pm_ra.clear();
+    pm_dec.clear();
+    parallax.clear();
+    radial_velocity.clear();
+    magnitude.clear();
+    unit_x.clear();
+    unit_y.clear();
+    unit_z.clear();
+    motion_x.clear();
+    motion_y.clear();
+    motion_z.clear();
+  }
+
+  void resize(size_t count) {
+    ra.resize(count);
+    dec.resize(count);
+    pm_ra.resize(count);
+    pm_dec.resize(count);
+    parallax.resize(count);
+    radial_velocity.resize(count);
+    magnitude.resize(count);
+    unit_x.resize(count);
+    unit_y.resize(count);
+    unit_z.resize(count);
+    motion_x.resize(count);
+    motion_y.resize(count);
+    motion_z.resize(count);
+  }
 };
 
-AstrometryEngine::AstrometryEngine()
-    : prebuilt_(std::make_unique<PrebuiltCatalog>()) {}
+// Fixed-point star columns for CatalogStorage::COMPACT, in the same
+// sky-tile order as StarColumns. Angles are fractions of a turn.
+struct CompactStarColumns {
+  static constexpr double kAngleUnitsPerDeg = 4294967296.0 / 360.0;
+  static constexpr double kPmUnitsPerMas = 1000.0;       // uas/yr
+  static constexpr double kParallaxUnitsPerMas = 50.0;   // 0.02 mas
+  static constexpr double kVelocityUnitsPerKms = 10.0;   // 0.1 km/s
+  static constexpr double kMagnitudeUnitsPerMag = 1000.0;
+
+  // Magnitude code of a star without a magnitude, read back as NaN so that
+  // filters and sorts treat it as the full columns do
+  static constexpr int16_t kNoMagnitude = std::numeric_limits<int16_t>::max();
+
+  std::vector<uint32_t> ra;
+  std::vector<int32_t> dec;
+  std::vector<int32_t> pm_ra;  // Already scaled by cos(dec)
+  std::vector<int32_t> pm_dec;
+  std::vector<uint16_t> parallax;
+  std::vector<int16_t> radial_velocity;
+  std::vector<int16_t> magnitude;
+
+  size_t size() const { return ra.size(); }
+
+  void clear() {
+    ra.clear();
+    dec.clear();
+    pm_ra.clear();
+    pm_dec.clear();
+    parallax.clear();
+    radial_velocity.clear();
+    magnitude.clear();
+  }
 
-AstrometryEngine::~AstrometryEngine() = default;
+  void resize(size_t count) {
+    ra.resize(count);
+    dec.resize(count);
+    pm_ra.resize(count);
+    pm_dec.resize(count);
+    parallax.resize(count);
+    radial_velocity.resize(count);
+    magnitude.resize(count);
+  }
+
+  // Rounds `value * scale` to the column type, clamping out-of-range
+  // values; NaN becomes 0.
+  template <typename T>
+  static T Quantize(double value, double scale) {
+    double scaled = std::round(value * scale);
+    if (!(scaled == scaled)) return 0;
+    return static_cast<T>(
+        std::clamp(scaled, static_cast<double>(std::numeric_limits<T>::min()),
+                   static_cast<double>(std::numeric_limits<T>::max())));
+  }
 
-void AstrometryEngine::SetCatalog(std::span<const Star> catalog) {
-  star_names_.clear();
-  magnitudes_.clear();
-  prebuilt_->stars.clear();
-  prebuilt_->star_entries.clear();
+  void Store(size_t i, double ra_deg, double dec_deg, double pmra_mas,
+             double pmdec_mas, double parallax_mas, double rv_kms,
+             float mag) {
+    double turns = ra_deg / 360.0;
+    turns -= std::floor(turns);
+    ra[i] = static_cast<uint32_t>(
+        static_cast<uint64_t>(std::llround(turns * 4294967296.0)) &
+        0xFFFFFFFFu);
+    dec[i] = Quantize<int32_t>(dec_deg, kAngleUnitsPerDeg);
+    pm_ra[i] = Quantize<int32_t>(pmra_mas, kPmUnitsPerMas);
+    pm_dec[i] = Quantize<int32_t>(pmdec_mas, kPmUnitsPerMas);
+    parallax[i] = Quantize<uint16_t>(parallax_mas, kParallaxUnitsPerMas);
+    radial_velocity[i] = Quantize<int16_t>(rv_kms, kVelocityUnitsPerKms);
+    magnitude[i] =
+        std::isnan(mag)
+            ? kNoMagnitude
+            : std::min<int16_t>(Quantize<int16_t>(mag, kMagnitudeUnitsPerMag),
+                                kNoMagnitude - 1);
+  }
 
-  star_names_.reserve(catalog.size());
-  magnitudes_.reserve(catalog.size());
-  prebuilt_->star_entries.reserve(catalog.size());
-  prebuilt_->stars.reserve(catalog.size());
+  double RaDegrees(size_t i) const { return ra[i] / kAngleUnitsPerDeg; }
+  double DecDegrees(size_t i) const { return dec[i] / kAngleUnitsPerDeg; }
+  double PmRa(size_t i) const { return pm_ra[i] / kPmUnitsPerMas; }
+  double PmDec(size_t i) const { return pm_dec[i] / kPmUnitsPerMas; }
+  double Parallax(size_t i) const {
+    return parallax[i] / kParallaxUnitsPerMas;
+  }
+  double RadialVelocity(size_t i) const {
+    return radial_velocity[i] / kVelocityUnitsPerKms;
+  }
+  float Magnitude(size_t i) const {
+    if (magnitude[i] == kNoMagnitude) {
+      return std::numeric_limits<float>::quiet_NaN();
+    }
+    return static_cast<float>(magnitude[i] / kMagnitudeUnitsPerMag);
+  }
+};
 
-  for (const auto& star : catalog) {
-    cat_entry catalog_entry;
+// Columns of a tiled .zcat mapping for CatalogStorage::MAPPED, read in
+// place. A star's row in the file is also its catalog_index.
+struct MappedStarColumns {
+  std::shared_ptr<const BinaryCatalog> catalog;
+  CatalogFilter filter;  // Applied per star at query time
+  std::span<const double> ra;  // Degrees
+  std::span<const double> dec;
+  std::span<const double> pm_ra;
+  std::span<const double> pm_dec;
+  std::span<const double> parallax;
+  std::span<const double> radial_velocity;
+  std::span<const float> magnitude;
+  std::span<const char> coo_qual;
+  std::span<const char> pm_qual;
+  std::span<const char> plx_qual;
+
+  MappedStarColumns() = default;
+  MappedStarColumns(std::shared_ptr<const BinaryCatalog> file,
+                    const CatalogFilter& star_filter)
+      : catalog(std::move(file)),
+        filter(star_filter),
+        ra(catalog->ra()),
+        dec(catalog->dec()),
+        pm_ra(catalog->pmra()),
+        pm_dec(catalog->pmdec()),
+        parallax(catalog->parallax()),
+        radial_velocity(catalog->radial_velocity()),
+        magnitude(catalog->flux()),
+        coo_qual(catalog->quality(ZcatColumn::COO_QUAL)),
+        pm_qual(catalog->quality(ZcatColumn::PM_QUAL)),
+        plx_qual(catalog->quality(ZcatColumn::PLX_QUAL)) {}
+
+  size_t size() const { return ra.size(); }
+
+  // Rows [begin, end) of a tile, cut after the last star no fainter than
+  // `max_magnitude`. Tiles are sorted brightest first, with stars lacking a
+  // magnitude last, so only a limit of infinity keeps those.
+  SkyRange Brightest(uint32_t begin, uint32_t end,
+                     float max_magnitude) const {
+    if (max_magnitude == std::numeric_limits<float>::infinity()) {
+      return {begin, end};
+    }
+    auto first = magnitude.begin() + begin;
+    auto last = std::partition_point(
+        first, magnitude.begin() + end,
+        [&](float mag) { return mag <= max_magnitude; });
+    return {begin, begin + static_cast<uint32_t>(last - first)};
+  }
+};
 
-    // Truncate strings to fit NOVAS buffers (names are 51 chars max)
-    std::string safe_name = star.name.substr(0, 50);
-    std::string safe_cat = star.catalog.substr(0, 3);
+struct StarMetadata {
+  // Views into PrebuiltCatalog::strings
+  std::vector<std::string_view> names;
+  std::vector<std::string_view> catalogs;
+  std::vector<long> catalog_ids;
+  // Position of each star in the catalog passed to SetCatalog; the columns
+  // themselves are stored in sky-tile order.
+  std::vector<uint32_t> catalog_index;
+
+  void clear() {
+    names.clear();
+    catalogs.clear();
+    catalog_ids.clear();
+    catalog_index.clear();
+  }
 
-    // Define ICRS coordinates
-    make_cat_entry(safe_name.c_str(), safe_cat.c_str(), star.catalog_id,
-                   star.ra * kDegToHours, star.dec, star.pmra, star.pmdec,
-                   star.parallax, star.radial_velocity, &catalog_entry);
+  void resize(size_t count) {
+    names.resize(count);
+    catalogs.resize(count);
+    catalog_ids.resize(count);
+    catalog_index.resize(count);
+  }
+};
 
-    prebuilt_->star_entries.push_back(catalog_entry);
+namespace {
+// Latitude change (degrees) tolerated before the per-observer visibility
+// table is rebuilt.
+constexpr double kVisibilityLatitudeTolerance = 0.5;
+
+// Margin (degrees) for effects the cheap visibility tests leave out:
+// nutation (17"), parallax (< 1") and light deflection (< 2").
+constexpr double kUnmodeledMarginDeg = 0.02;
+
+// Largest precession rate in declination (degrees per year).
+constexpr double kMaxPrecessionDegPerYear = 20.1 / 3600.0;
+
+// Returns a catalog object with empty coordinates, used as a per-thread
+// scratch object that the transform loop fills from the star columns.
+object MakeStarTemplate() {
+  cat_entry entry;
+  make_cat_entry("", "", 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, &entry);
+  object star_object;
+  make_cat_object(&entry, &star_object);
+  return star_object;
+}
 
-    object star_object;
-    // Note: make_cat_object stores the pointer to the entry, so we must point
-    // to the persistent vector
-    make_cat_object(&prebuilt_->star_entries.back(), &star_object);
+// Barycentric state of the observer in one frame, shared by every body
+// evaluated in it.
+struct ObserverState {
+  double jd_tdb[2];  // Split Julian date (TDB)
+  double pos[3];     // AU, ICRS
+  double vel[3];     // AU/day
+  novas_accuracy accuracy;
+};
 
-    star_names_.push_back(star.name);
-    magnitudes_.push_back(star.flux);
-    prebuilt_->stars.push_back(star_object);
+ObserverState MakeObserverState(const novas_frame& frame) {
+  ObserverState state{};
+  long ijd = 0;
+  state.jd_tdb[1] = novas_get_split_time(&frame.time, NOVAS_TDB, &ijd);
+  state.jd_tdb[0] = static_cast<double>(ijd);
+  for (int k = 0; k < 3; ++k) {
+    state.pos[k] = frame.obs_pos[k];
+    state.vel[k] = frame.obs_vel[k];
   }
+  state.accuracy = frame.accuracy;
+  return state;
 }
 
-void AstrometryEngine::BuildPlanetsCatalog() const {
-  struct PlanetInfo {
-    novas_planet id;
-    const char* name;
-  };
-  static constexpr PlanetInfo kPlanets[] = {
-      {NOVAS_SUN, "SUN"},         {NOVAS_MERCURY, "MERCURY"},
-      {NOVAS_VENUS, "VENUS"},     {NOVAS_EARTH, "EARTH"},
-      {NOVAS_MARS, "MARS"},       {NOVAS_JUPITER, "JUPITER"},
-      {NOVAS_SATURN, "SATURN"},   {NOVAS_URANUS, "URANUS"},
-      {NOVAS_NEPTUNE, "NEPTUNE"}, {NOVAS_PLUTO, "PLUTO"},
-      {NOVAS_MOON, "MOON"}};
+// Light-time solutions: a Newton step smaller than this (days, ~86 us)
+// leaves an error of well under a nanosecond, even for Pluto.
+constexpr double kLightTimeTolerance = 1e-9;
+constexpr int kMaxLightTimeIterations = 8;
 
-  prebuilt_->planets.clear();
-  prebuilt_->planets.reserve(std::size(kPlanets));
+// Timings of ephemeris lookups.
+struct LookupTimes {
+  uint64_t reads = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+};
 
-  for (const auto& planet : kPlanets) {
-    object planet_object;
-    make_planet(planet.id, &planet_object);
-    // Ensure the name is set in the object struct and truncated safely
-    std::strncpy(planet_object.name, planet.name,
-                 sizeof(planet_object.name) - 1);
-    planet_object.name[sizeof(planet_object.name) - 1] = '\0';
-    prebuilt_->planets.push_back(planet_object);
+// Ephemeris lookups are timed by a planet provider wrapped around the one
+// InitializeNovas chose, so that the Earth and Sun reads inside
+// novas_make_frame count as well as those of the bodies. Each read goes to
+// the LookupScope active on the reading thread, if any.
+std::atomic<novas_planet_provider> g_planet_provider{nullptr};
+std::atomic<novas_planet_provider_hp> g_planet_provider_hp{nullptr};
+thread_local LookupTimes* t_lookup_times = nullptr;
+
+// Collects the lookups made on this thread during its lifetime.
+class LookupScope {
+ public:
+  explicit LookupScope(LookupTimes& times) : previous_(t_lookup_times) {
+    t_lookup_times = &times;
   }
+  ~LookupScope() { t_lookup_times = previous_; }
+
+  LookupScope(const LookupScope&) = delete;
+  LookupScope& operator=(const LookupScope&) = delete;
+
+ private:
+  LookupTimes* previous_;
+};
+
+template <typename Read>
+short TimeLookup(Read&& read) {
+  if (!t_lookup_times) return read();
+  auto started = std::chrono::steady_clock::now();
+  short status = read();
+  auto ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - started)
+          .count());
+  ++t_lookup_times->reads;
+  t_lookup_times->total_ns += ns;
+  t_lookup_times->max_ns = std::max(t_lookup_times->max_ns, ns);
+  return status;
 }
 
-void AstrometryEngine::SetEphemeris(std::shared_ptr<t_calcephbin> ephemeris) {
-  ephemeris_ = std::move(ephemeris);
-  initialized_ = false;  // Force re-initialization of NOVAS
+short TimedPlanet(double jd_tdb, novas_planet body, novas_origin origin,
+                  double* position, double* velocity) {
+  auto provider = g_planet_provider.load(std::memory_order_acquire);
+  return TimeLookup(
+      [&] { return provider(jd_tdb, body, origin, position, velocity); });
 }
 
-void AstrometryEngine::InitializeNovas() const {
-  std::lock_guard<std::mutex> lock(initialization_mutex_);
-  if (initialized_) return;
+short TimedPlanetHp(const double jd_tdb[2], novas_planet body,
+                    novas_origin origin, double* position,
+                    double* velocity) {
+  auto provider = g_planet_provider_hp.load(std::memory_order_acquire);
+  return TimeLookup(
+      [&] { return provider(jd_tdb, body, origin, position, velocity); });
+}
 
-  if (ephemeris_) {
-    auto result = novas_use_calceph(ephemeris_.get());
-    if (result < 0) {
-      accuracy_ = NOVAS_REDUCED_ACCURACY;
-    } else {
-      accuracy_ = NOVAS_FULL_ACCURACY;
+// Installs `provider` and `provider_hp` behind the timing wrappers.
+void InstallPlanetProviders(novas_planet_provider provider,
+                            novas_planet_provider_hp provider_hp) {
+  g_planet_provider.store(provider, std::memory_order_release);
+  g_planet_provider_hp.store(provider_hp, std::memory_order_release);
+  set_planet_provider(TimedPlanet);
+  set_planet_provider_hp(TimedPlanetHp);
+}
+
+// A body's barycentric state at a light-time guess, looked up beforehand.
+struct RetardedState {
+  double light_time = 0.0;  // Days
+  BodyState state;
+};
+
+// Apparent CIRS place of a solar system body in `frame`. The body is seen
+// where it was `light_time` days ago, with |p(t - lt) - o(t)| = c lt;
+// Newton's method on that equation, started from the body's previous
+// solution, needs one ephemeris lookup per tick (a cold start takes two or
+// three). With `start`, the first step uses its guess and state instead of
+// a lookup. `light_time` is updated with the new solution.
+ApparentPlace PlanetPlace(const object& planet, const novas_frame& frame,
+                          const ObserverState& observer,
+                          std::atomic<double>& light_time,
+                          const RetardedState* start = nullptr) {
+  const double c_au_per_day = NOVAS_C * 86400.0 / NOVAS_AU;
+  double lt = start ? start->light_time
+                    : light_time.load(std::memory_order_relaxed);
+  double pos[3], vel[3], rel[3];
+  bool converged = false;
+  for (int i = 0; i < kMaxLightTimeIterations && !converged; ++i) {
+    double jd_tdb[2] = {observer.jd_tdb[0], observer.jd_tdb[1] - lt};
+    if (i == 0 && start) {
+      std::copy(start->state.position.begin(), start->state.position.end(),
+                pos);
+      std::copy(start->state.velocity.begin(), start->state.velocity.end(),
+                vel);
+    } else if (ephemeris(jd_tdb, &planet, NOVAS_BARYCENTER, observer.accuracy,
+                         pos, vel) != 0) {
+      return {};
     }
-  } else {
-    accuracy_ = NOVAS_REDUCED_ACCURACY;
+    double r2 = 0.0, rel_dot_vel = 0.0;
+    for (int k = 0; k < 3; ++k) {
+      rel[k] = pos[k] - observer.pos[k];
+      r2 += rel[k] * rel[k];
+      rel_dot_vel += rel[k] * vel[k];
+    }
+    double r = std::sqrt(r2);
+    double step = (r - c_au_per_day * lt) / (c_au_per_day + rel_dot_vel / r);
+    lt += step;
+    // Position at the corrected time, to first order
+    for (int k = 0; k < 3; ++k) rel[k] -= vel[k] * step;
+    converged = std::abs(step) < kLightTimeTolerance;
   }
-  initialized_ = true;
+  if (!converged) return {};
+  light_time.store(lt, std::memory_order_relaxed);
 
-  BuildPlanetsCatalog();
+  // Deflection, aberration and the rotation to CIRS
+  sky_pos position = {0};
+  if (novas_geom_to_app(&frame, rel, NOVAS_CIRS, &position) != 0) {
+    return {};
+  }
+  return ApparentPlace{.ra = position.ra,
+                       .dec = position.dec,
+                       .distance = position.dis,
+                       .valid = true};
+}
+
+// Calls body(i) for every i in [0, count): on `pool`, one index per task,
+// or in order on the calling thread if `pool` is null. Bodies, like time
+// samples, take an ephemeris lookup each, so they only go parallel when
+// the ephemeris can be read from several threads at once.
+template <typename Body>
+void ForEachBody(ThreadPool* pool, size_t count, Body&& body) {
+  if (pool) {
+    pool->ParallelFor(count, 1, body);
+    return;
+  }
+  for (size_t i = 0; i < count; ++i) body(i);
+}
+
+// The solar system bodies, built once. They do not depend on the catalog or
+// the ephemeris, and result names point into them for the life of the
+// process.
+const std::vector<object>& PlanetCatalog() {
+  static const std::vector<object> planets = [] {
+    struct PlanetInfo {
+      novas_planet id;
+      const char* name;
+    };
+    static constexpr PlanetInfo kPlanets[] = {
+        {NOVAS_SUN, "SUN"},         {NOVAS_MERCURY, "MERCURY"},
+        {NOVAS_VENUS, "VENUS"},     {NOVAS_EARTH, "EARTH"},
+        {NOVAS_MARS, "MARS"},       {NOVAS_JUPITER, "JUPITER"},
+        {NOVAS_SATURN, "SATURN"},   {NOVAS_URANUS, "URANUS"},
+        {NOVAS_NEPTUNE, "NEPTUNE"}, {NOVAS_PLUTO, "PLUTO"},
+        {NOVAS_MOON, "MOON"}};
+
+    std::vector<object> list;
+    list.reserve(std::size(kPlanets));
+    for (const auto& planet : kPlanets) {
+      object planet_object;
+      make_planet(planet.id, &planet_object);
+      // Ensure the name is set in the object struct and truncated safely
+      std::strncpy(planet_object.name, planet.name,
+                   sizeof(planet_object.name) - 1);
+      planet_object.name[sizeof(planet_object.name) - 1] = '\0';
+      list.push_back(planet_object);
+    }
+    return list;
+  }();
+  return planets;
+}
+
+// The analytic body for a NOVAS planet number, if there is one.
+std::optional<AnalyticBody> AnalyticBodyOf(long number) {
+  // Indexed by novas_planet, whose values are fixed by NOVAS
+  static constexpr AnalyticBody kBodies[] = {
+      AnalyticBody::SUN,  // Solar system barycenter
+      AnalyticBody::MERCURY, AnalyticBody::VENUS,   AnalyticBody::EARTH,
+      AnalyticBody::MARS,    AnalyticBody::JUPITER, AnalyticBody::SATURN,
+      AnalyticBody::URANUS,  AnalyticBody::NEPTUNE, AnalyticBody::PLUTO,
+      AnalyticBody::SUN,     AnalyticBody::MOON};
+  if (number < 0 || static_cast<size_t>(number) >= std::size(kBodies)) {
+    return std::nullopt;
+  }
+  return kBodies[number];
+}
+
+// NOVAS planet provider backed by the analytic theory. The Sun stands in
+// for the solar system barycenter (they are within 0.01 AU), so barycentric
+// and heliocentric requests get the same state; directions from the
+// observer are unaffected.
+short AnalyticPlanet(double jd_tdb, novas_planet body, novas_origin origin,
+                     double* position, double* velocity) {
+  const auto analytic = AnalyticBodyOf(body);
+  if (!analytic ||
+      (origin != NOVAS_BARYCENTER && origin != NOVAS_HELIOCENTER)) {
+    return 1;
+  }
+
+  BodyState state;
+  AnalyticStates(*analytic, std::span<const double>(&jd_tdb, 1),
+                 std::span<BodyState>(&state, 1));
+  std::copy(state.position.begin(), state.position.end(), position);
+  std::copy(state.velocity.begin(), state.velocity.end(), velocity);
+  return 0;
+}
+
+short AnalyticPlanetHp(const double jd_tdb[2], novas_planet body,
+                       novas_origin origin, double* position,
+                       double* velocity) {
+  return AnalyticPlanet(jd_tdb[0] + jd_tdb[1], body, origin, position,
+                        velocity);
+}
+
+// Builds the NOVAS observer frame for an observer and a UTC instant.
+// Returns the novas_make_frame status.
+int MakeFrame(const Observer& obs,
+              std::chrono::sys_time<std::chrono::milliseconds> time,
+              int accuracy, novas_frame* frame) {
+  observer location;
+  make_gps_observer(obs.latitude, obs.longitude, obs.altitude, &location);
+
+  novas_timespec t_spec;
+  auto jd = GetJulianDayParts(time);
+  novas_set_split_time(NOVAS_UTC, jd.day_number, jd.fraction, kLeapSeconds,
+                       kDUT1, &t_spec);
+
+  return novas_make_frame(static_cast<novas_accuracy>(accuracy), &location,
+                          &t_spec, kPolarOffsetX, kPolarOffsetY, frame);
+}
+
+// Largest number of stars in one unit of parallel work. Small enough for the
+// fast path's scratch arrays to live on the stack, large enough to amortize
+// the scalar survivor pass.
+constexpr uint32_t kChunkSize = 512;
+
+// Upper bound on atmospheric refraction (degrees). Stars whose geometric
+// elevation is further than this below the requested band are culled before
+// the refraction model is evaluated.
+constexpr double kMaxRefractionDeg = 1.0;
+
+// Everything needed to take an ICRS catalog direction to the local horizon
+// for one observation time, folded into a single rotation plus a first-order
+// aberration term.
+struct HorizonTransform {
+  // Rows are the local north, east and zenith directions expressed in ICRS.
+  double rotation[3][3];
+  // Observer barycentric velocity in units of c.
+  double beta[3];
+  // Julian years (TT) since the catalog epoch J2000, for proper motion.
+  double years;
+  // Julian date (TT), passed to the refraction model.
+  double jd_tt;
+};
+
+// Builds the ICRS -> horizon transform for a NOVAS frame. The rotation is
+// probed by pushing the three GCRS basis directions through
+// novas_app_to_hor, so precession, nutation, frame bias, Earth rotation,
+// polar motion and the observer's latitude/longitude are all taken exactly
+// from the frame.
+HorizonTransform MakeHorizonTransform(const novas_frame& frame) {
+  HorizonTransform transform{};
+
+  // Basis directions as (RA hours, Dec degrees)
+  static constexpr double kBasis[3][2] = {{0.0, 0.0}, {6.0, 0.0}, {0.0, 90.0}};
+  for (int j = 0; j < 3; ++j) {
+    double az = 0, el = 0;
+    novas_app_to_hor(&frame, NOVAS_GCRS, kBasis[j][0], kBasis[j][1], nullptr,
+                     &az, &el);
+    double az_rad = az * kDegToRad, el_rad = el * kDegToRad;
+    transform.rotation[0][j] = std::cos(el_rad) * std::cos(az_rad);
+    transform.rotation[1][j] = std::cos(el_rad) * std::sin(az_rad);
+    transform.rotation[2][j] = std::sin(el_rad);
+  }
+
+  const double c_au_per_day = NOVAS_C * 86400.0 / NOVAS_AU;
+  for (int k = 0; k < 3; ++k) {
+    transform.beta[k] = frame.obs_vel[k] / c_au_per_day;
+  }
+
+  transform.jd_tt = novas_get_time(&frame.time, NOVAS_TT);
+  transform.years = (transform.jd_tt - NOVAS_JD_J2000) / 365.25;
+  return transform;
+}
+
+// Local (north, east, up) components for a star in the fast path.
+struct HorizonVector {
+  double north;
+  double east;
+  double up;
+};
+
+// ICRS unit vector of a star at the catalog epoch (J2000) and its rate of
+// change from proper motion (rad/yr), from the motion along the local east
+// (p) and north (q) directions.
+struct StarVectors {
+  double unit[3];
+  double motion[3];
+};
+
+inline StarVectors MakeStarVectors(double ra_deg, double dec_deg,
+                                   double pmra_mas, double pmdec_mas) {
+  double ra_rad = ra_deg * kDegToRad;
+  double dec_rad = dec_deg * kDegToRad;
+  double cos_ra = std::cos(ra_rad), sin_ra = std::sin(ra_rad);
+  double cos_dec = std::cos(dec_rad), sin_dec = std::sin(dec_rad);
+  double pm_east = pmra_mas * kMasToRad;  // Already scaled by cos(dec)
+  double pm_north = pmdec_mas * kMasToRad;
+
+  return StarVectors{
+      .unit = {cos_dec * cos_ra, cos_dec * sin_ra, sin_dec},
+      .motion = {-pm_east * sin_ra - pm_north * sin_dec * cos_ra,
+                 pm_east * cos_ra - pm_north * sin_dec * sin_ra,
+                 pm_north * cos_dec},
+  };
+}
+
+// Applies first-order annual aberration and the horizon rotation to a
+// catalog direction already moved to the observation epoch.
+inline HorizonVector RotateToHorizon(double x, double y, double z,
+                                     const HorizonTransform& t) {
+  // u' = u + beta - (u . beta) u
+  double u_dot_beta = x * t.beta[0] + y * t.beta[1] + z * t.beta[2];
+  double px = x + t.beta[0] - u_dot_beta * x;
+  double py = y + t.beta[1] - u_dot_beta * y;
+  double pz = z + t.beta[2] - u_dot_beta * z;
+
+  const auto& m = t.rotation;
+  return HorizonVector{
+      .north = m[0][0] * px + m[0][1] * py + m[0][2] * pz,
+      .east = m[1][0] * px + m[1][1] * py + m[1][2] * pz,
+      .up = m[2][0] * px + m[2][1] * py + m[2][2] * pz,
+  };
+}
+
+// Applies proper motion, first-order annual aberration and the horizon
+// rotation to one star. Branch-free so that loops over it vectorize.
+inline HorizonVector ProjectToHorizon(const StarColumns& columns,
+                                      const HorizonTransform& t, size_t i) {
+  return RotateToHorizon(columns.unit_x[i] + t.years * columns.motion_x[i],
+                         columns.unit_y[i] + t.years * columns.motion_y[i],
+                         columns.unit_z[i] + t.years * columns.motion_z[i], t);
+}
+
+// Same for compact storage, rebuilding the vectors from the fixed-point
+// coordinates.
+inline HorizonVector ProjectToHorizon(const CompactStarColumns& columns,
+                                      const HorizonTransform& t, size_t i) {
+  auto v = MakeStarVectors(columns.RaDegrees(i), columns.DecDegrees(i),
+                           columns.PmRa(i), columns.PmDec(i));
+  return RotateToHorizon(v.unit[0] + t.years * v.motion[0],
+                         v.unit[1] + t.years * v.motion[1],
+                         v.unit[2] + t.years * v.motion[2], t);
+}
+
+// Catalog coordinates of one star in the units of NOVAS cat_entry, read
+// from either storage.
+struct CatalogCoordinates {
+  double ra;  // Hours
+  double dec;
+  double pm_ra;
+  double pm_dec;
+  double parallax;
+  double radial_velocity;
+};
+
+inline HorizonVector ProjectToHorizon(const MappedStarColumns& columns,
+                                      const HorizonTransform& t, size_t i) {
+  auto v = MakeStarVectors(columns.ra[i], columns.dec[i], columns.pm_ra[i],
+                           columns.pm_dec[i]);
+  return RotateToHorizon(v.unit[0] + t.years * v.motion[0],
+                         v.unit[1] + t.years * v.motion[1],
+                         v.unit[2] + t.years * v.motion[2], t);
+}
+
+inline CatalogCoordinates CoordinatesOf(const StarColumns& columns,
+                                        size_t i) {
+  return {columns.ra[i],     columns.dec[i],      columns.pm_ra[i],
+          columns.pm_dec[i], columns.parallax[i], columns.radial_velocity[i]};
+}
+
+inline CatalogCoordinates CoordinatesOf(const CompactStarColumns& columns,
+                                        size_t i) {
+  return {columns.RaDegrees(i) * kDegToHours,
+          columns.DecDegrees(i),
+          columns.PmRa(i),
+          columns.PmDec(i),
+          columns.Parallax(i),
+          columns.RadialVelocity(i)};
+}
+
+inline CatalogCoordinates CoordinatesOf(const MappedStarColumns& columns,
+                                        size_t i) {
+  return {columns.ra[i] * kDegToHours, columns.dec[i],
+          columns.pm_ra[i],            columns.pm_dec[i],
+          columns.parallax[i],         columns.radial_velocity[i]};
+}
+
+inline float MagnitudeOf(const StarColumns& columns, size_t i) {
+  return columns.magnitude[i];
+}
+
+inline float MagnitudeOf(const CompactStarColumns& columns, size_t i) {
+  return columns.Magnitude(i);
+}
+
+inline float MagnitudeOf(const MappedStarColumns& columns, size_t i) {
+  return columns.magnitude[i];
+}
+
+inline double DeclinationOf(const StarColumns& columns, size_t i) {
+  return columns.dec[i];
+}
+
+inline double DeclinationOf(const CompactStarColumns& columns, size_t i) {
+  return columns.DecDegrees(i);
+}
+
+inline double DeclinationOf(const MappedStarColumns& columns, size_t i) {
+  return columns.dec[i];
+}
+
+inline SkyVector UnitVectorOf(const StarColumns& columns, size_t i) {
+  return {columns.unit_x[i], columns.unit_y[i], columns.unit_z[i]};
+}
+
+inline SkyVector UnitVectorOf(const CompactStarColumns& columns, size_t i) {
+  return SkyVector::FromRaDec(columns.RaDegrees(i), columns.DecDegrees(i));
+}
+
+inline SkyVector UnitVectorOf(const MappedStarColumns& columns, size_t i) {
+  return SkyVector::FromRaDec(columns.ra[i], columns.dec[i]);
+}
+
+// Stars held in memory were filtered, and their names and catalog positions
+// moved to StarMetadata, when the catalog was built. Mapped stars carry
+// their own.
+template <typename Columns>
+bool KeepsStar(const Columns&, size_t) {
+  return true;
+}
+
+inline bool KeepsStar(const MappedStarColumns& columns, size_t i) {
+  return columns.filter.Accepts(columns.magnitude[i], columns.dec[i],
+                                columns.coo_qual[i], columns.pm_qual[i],
+                                columns.plx_qual[i]);
+}
+
+template <typename Columns>
+std::string_view NameOf(const Columns&, const StarMetadata& info, size_t i) {
+  return info.names[i];
+}
+
+inline std::string_view NameOf(const MappedStarColumns& columns,
+                               const StarMetadata&, size_t i) {
+  return columns.catalog->name(i);
+}
+
+template <typename Columns>
+size_t CatalogIndexOf(const Columns&, const StarMetadata& info, size_t i) {
+  return info.catalog_index[i];
+}
+
+inline size_t CatalogIndexOf(const MappedStarColumns&, const StarMetadata&,
+                             size_t i) {
+  return i;
+}
+
+// Converts a horizon vector to geometric elevation and azimuth (degrees).
+inline void HorizonVectorToAngles(const HorizonVector& v, double* az,
+                                  double* el) {
+  double r = std::sqrt(v.north * v.north + v.east * v.east + v.up * v.up);
+  *el = std::asin(std::clamp(v.up / r, -1.0, 1.0)) / kDegToRad;
+  *az = std::atan2(v.east, v.north) / kDegToRad;
+  if (*az < 0.0) *az += 360.0;
+}
+
+// Horizon-relative region of interest, used to select sky tiles.
+struct HorizonWindow {
+  double min_zenith;   // Zenith distance band (radians)
+  double max_zenith;
+  double min_azimuth;  // Azimuth window (degrees)
+  double max_azimuth;
+  double margin;  // Added to every tile radius (radians)
+};
+
+// Classifies a sky tile against the horizon window for the current tick.
+SkyOverlap ClassifyTile(const SkyCap& cap, const HorizonTransform& t,
+                        const HorizonWindow& w) {
+  const auto& m = t.rotation;
+  const auto& c = cap.center;
+  double north = m[0][0] * c.x + m[0][1] * c.y + m[0][2] * c.z;
+  double east = m[1][0] * c.x + m[1][1] * c.y + m[1][2] * c.z;
+  double up = m[2][0] * c.x + m[2][1] * c.y + m[2][2] * c.z;
+
+  double zenith = std::acos(std::clamp(up, -1.0, 1.0));
+  double radius = cap.radius + w.margin;
+  if (zenith - radius > w.max_zenith || zenith + radius < w.min_zenith) {
+    return SkyOverlap::NONE;
+  }
+  auto overlap =
+      (zenith + radius <= w.max_zenith && zenith - radius >= w.min_zenith)
+          ? SkyOverlap::FULL
+          : SkyOverlap::PARTIAL;
+
+  if (w.min_azimuth <= 0.0 && w.max_azimuth >= 360.0) return overlap;
+
+  // A cap reaching the zenith or nadir spans every azimuth
+  if (radius >= zenith || radius >= std::numbers::pi - zenith) {
+    return SkyOverlap::PARTIAL;
+  }
+  double half_width = std::asin(std::sin(radius) / std::sin(zenith));
+  double center_az = std::atan2(east, north);
+  double lo = (center_az - half_width) / kDegToRad;
+  double hi = (center_az + half_width) / kDegToRad;
+
+  // The cap's azimuth interval may wrap, so compare it against the window
+  // shifted by a full turn either way.
+  bool touches = false, inside = false;
+  for (double shift : {-360.0, 0.0, 360.0}) {
+    double a = w.min_azimuth + shift, b = w.max_azimuth + shift;
+    touches |= (hi >= a && lo <= b);
+    inside |= (lo >= a && hi <= b);
+  }
+  if (!touches) return SkyOverlap::NONE;
+  return inside ? overlap : SkyOverlap::PARTIAL;
+}
+
+// Splits member ranges so that no work item exceeds max_size members.
+void SplitRanges(std::span<const SkyRange> ranges, uint32_t max_size,
+                 std::vector<SkyRange>& out) {
+  for (const auto& range : ranges) {
+    for (uint32_t begin = range.begin; begin < range.end; begin += max_size) {
+      out.push_back({begin, std::min(range.end, begin + max_size)});
+    }
+  }
+}
+
+// Rate of change of elevation (degrees per minute) from the diurnal motion.
+// With H the local hour angle, d(el)/dt = -w cos(lat) cos(dec) sin(H) / cos(el)
+// and the horizon triangle gives cos(dec) sin(H) = -cos(el) sin(az), so the
+// rate reduces to w cos(lat) sin(az). It is positive exactly when the hour
+// angle is negative, i.e. the object is east of the meridian and rising.
+inline double ElevationRate(double latitude_deg, double azimuth_deg) {
+  return kSiderealRateDegPerMin * std::cos(latitude_deg * kDegToRad) *
+         std::sin(azimuth_deg * kDegToRad);
 }
 
-namespace {
 bool CaseInsensitiveContains(std::string_view haystack,
                              std::string_view needle_lower) {
   if (needle_lower.empty()) return true;
@@ -132,197 +864,1009 @@ bool CaseInsensitiveContains(std::string_view haystack,
 }
 }  // namespace
 
-std::vector<CelestialResult> AstrometryEngine::CalculateZenithProximity(
-    const Observer& obs, const FilterCriteria& filter, const SortCriteria& sort,
-    std::chrono::system_clock::time_point time) const {
-  ResultBuffer buffer;
-  CalculateZenithProximity(buffer, obs, filter, sort, time);
-  return std::move(buffer.star_results);
+struct AstrometryEngine::PrebuiltCatalog {
+  // Only one of these is filled, depending on CatalogStorage. MAPPED
+  // leaves everything below but max_proper_motion empty.
+  StarColumns stars;
+  CompactStarColumns compact_stars;
+  MappedStarColumns mapped_stars;
+  CatalogStorage storage = CatalogStorage::FULL;
+  StarMetadata star_info;
+  SkyIndex sky_index;
+  // Position in the caller's catalog of every kept star, ascending, and the
+  // star's '|' separated identifiers, both in that order.
+  std::vector<uint32_t> kept;
+  std::vector<std::string_view> identifiers;
+  // Owns the memory the star names, catalog codes and identifiers point
+  // into: a StringArena for Star input, or the mapped file for a binary
+  // catalog.
+  std::shared_ptr<const void> strings;
+  // Largest total proper motion in the catalog (degrees per year), used to
+  // widen the margins of the cheap visibility tests.
+  double max_proper_motion = 0.0;
+  // Filter the catalog was built with, recorded in snapshots
+  CatalogFilter filter;
+
+  size_t size() const {
+    return storage == CatalogStorage::MAPPED ? mapped_stars.size()
+                                             : star_info.catalog_index.size();
+  }
+
+  // Calls fn(columns) with whichever storage holds the stars
+  template <typename Fn>
+  decltype(auto) Visit(Fn&& fn) const {
+    if (storage == CatalogStorage::COMPACT) return fn(compact_stars);
+    if (storage == CatalogStorage::MAPPED) return fn(mapped_stars);
+    return fn(stars);
+  }
+};
+
+// Per-observer visibility classification. For a fixed latitude each star's
+// elevation is bounded by its upper and lower culmination: a star whose
+// highest elevation is below the horizon never rises, one whose lowest
+// elevation is above it is circumpolar, and the rest rise and set. Keeping
+// both bounds lets the same table reject stars that can never enter an
+// arbitrary FilterCriteria elevation band.
+struct AstrometryEngine::VisibilityTable {
+  std::weak_ptr<const PrebuiltCatalog> catalog;  // Catalog it was built for
+  double latitude = 0.0;
+  std::vector<float> highest_elevation;  // Upper culmination (degrees)
+  std::vector<float> lowest_elevation;   // Lower culmination (degrees)
+};
+
+// Observer frame built for one (observer, time, NOVAS accuracy) key. The
+// time is kept in whole milliseconds, and the frame is built for exactly that
+// instant, so every hit returns the same frame a miss would have built.
+struct AstrometryEngine::CachedFrame {
+  Observer observer;
+  int64_t time_ms = 0;
+  int accuracy = 0;
+  novas_frame frame;
+
+  bool Matches(const Observer& obs, int64_t ms, int acc) const {
+    return observer.latitude == obs.latitude &&
+           observer.longitude == obs.longitude &&
+           observer.altitude == obs.altitude && time_ms == ms &&
+           accuracy == acc;
+  }
+};
+
+AstrometryEngine::AstrometryEngine()
+    : prebuilt_(std::make_shared<const PrebuiltCatalog>()) {
+  planet_cache_ = std::make_unique<PlanetCache>(
+      PlanetCatalog().size(),
+      [this](const Observer& obs, std::span<const int64_t> times_ms,
+             std::span<ApparentPlace> places) {
+        SamplePlanets(obs, times_ms, places);
+      });
 }
 
-void AstrometryEngine::CalculateZenithProximity(
-    ResultBuffer& buffer, const Observer& obs, const FilterCriteria& filter,
-    const SortCriteria& sort,
-    std::chrono::system_clock::time_point time) const {
-  if (!initialized_) {
-    InitializeNovas();
+void AstrometryEngine::SamplePlanets(const Observer& obs,
+                                     std::span<const int64_t> times_ms,
+                                     std::span<ApparentPlace> places) const {
+  const auto& planets = PlanetCatalog();
+  ThreadPool* pool = parallel_ephemeris_ ? &Pool() : nullptr;
+
+  std::vector<novas_frame> frames(times_ms.size());
+  std::vector<ObserverState> observers(times_ms.size());
+  std::vector<char> framed(times_ms.size(), 0);
+  ForEachBody(pool, times_ms.size(), [&](size_t t) {
+    auto time = std::chrono::sys_time<std::chrono::milliseconds>(
+        std::chrono::milliseconds(times_ms[t]));
+    LookupTimes times;
+    {
+      LookupScope scope(times);
+      framed[t] = MakeFrame(obs, time, accuracy_, &frames[t]) == 0;
+    }
+    RecordEphemerisReads(times.reads, times.total_ns, times.max_ns);
+    if (framed[t]) observers[t] = MakeObserverState(frames[t]);
+  });
+
+  // The analytic theory evaluates a body at every node in one call, at the
+  // body's last light time; each solution then starts from that state
+  std::vector<std::optional<RetardedState>> retarded;
+  if (solar_system_mode_ == SolarSystemMode::ANALYTIC) {
+    retarded.resize(times_ms.size() * planets.size());
+    ForEachBody(pool, planets.size(), [&](size_t p) {
+      const auto body = AnalyticBodyOf(planets[p].number);
+      if (!body) return;
+      const double lt = light_times_[p].load(std::memory_order_relaxed);
+      std::vector<double> jd_tdb(times_ms.size());
+      std::vector<BodyState> states(times_ms.size());
+      for (size_t t = 0; t < times_ms.size(); ++t) {
+        jd_tdb[t] = observers[t].jd_tdb[0] + (observers[t].jd_tdb[1] - lt);
+      }
+      LookupTimes times;
+      {
+        LookupScope scope(times);
+        TimeLookup([&] {
+          AnalyticStates(*body, jd_tdb, states);
+          return short{0};
+        });
+      }
+      RecordEphemerisReads(times.reads, times.total_ns, times.max_ns);
+      for (size_t t = 0; t < times_ms.size(); ++t) {
+        retarded[t * planets.size() + p] = RetardedState{lt, states[t]};
+      }
+    });
   }
 
-  buffer.star_results.clear();
-  if (!prebuilt_ || prebuilt_->stars.empty()) {
-    return;
+  size_t count = std::min(places.size(), times_ms.size() * planets.size());
+  ForEachBody(pool, count, [&](size_t i) {
+    size_t t = i / planets.size(), p = i % planets.size();
+    const RetardedState* start =
+        i < retarded.size() && retarded[i] ? &*retarded[i] : nullptr;
+    LookupTimes times;
+    {
+      LookupScope scope(times);
+      places[i] = framed[t] ? PlanetPlace(planets[p], frames[t], observers[t],
+                                          light_times_[p], start)
+                            : ApparentPlace{};
+    }
+    RecordEphemerisReads(times.reads, times.total_ns, times.max_ns);
+  });
+}
+
+void AstrometryEngine::SetPlanetCacheWindow(std::chrono::milliseconds window) {
+  if (window > kMaxPlanetCacheWindow) {
+    std::cerr << "Warning: Planet cache window of " << window.count()
+              << " ms clamped to " << kMaxPlanetCacheWindow.count() << " ms"
+              << std::endl;
   }
+  planet_cache_->SetWindow(window);
+}
 
-  observer location;
-  novas_timespec t_spec;
-  novas_frame frame;
+uint64_t AstrometryEngine::GetPlanetFitCount() const {
+  return planet_cache_->fit_count();
+}
 
-  // Observer location
-  make_gps_observer(obs.latitude, obs.longitude, obs.altitude, &location);
+AstrometryEngine::~AstrometryEngine() = default;
 
-  // Set time of observation
-  auto jd = GetJulianDayParts(time);
-  novas_set_split_time(NOVAS_UTC, jd.day_number, jd.fraction, kLeapSeconds,
-                       kDUT1, &t_spec);
+std::shared_ptr<const AstrometryEngine::PrebuiltCatalog>
+AstrometryEngine::Catalog() const {
+  return prebuilt_.load(std::memory_order_acquire);
+}
+
+void AstrometryEngine::Publish(std::shared_ptr<const PrebuiltCatalog> catalog) {
+  prebuilt_.store(std::move(catalog), std::memory_order_release);
+
+  // The table of the old catalog is of no further use; calculations still
+  // on it build their own
+  std::lock_guard<std::mutex> lock(visibility_mutex_);
+  visibility_.reset();
+}
 
-  // Observer frame
-  auto frame_status =
-      novas_make_frame(static_cast<novas_accuracy>(accuracy_), &location,
-                       &t_spec, kPolarOffsetX, kPolarOffsetY, &frame);
+// The fields of one star the engine keeps, whatever the catalog source.
+struct AstrometryEngine::StarRecord {
+  double ra;               // Degrees
+  double dec;              // Degrees
+  double pmra;             // mas/yr
+  double pmdec;            // mas/yr
+  double parallax;         // mas
+  double radial_velocity;  // km/s
+  float magnitude;
+  std::string_view name;
+  std::string_view catalog;
+  std::string_view ids;
+  long catalog_id;
+};
 
-  if (frame_status != 0) {
+void AstrometryEngine::SetCatalog(std::span<const Star> catalog,
+                                  const CatalogFilter& filter) {
+  std::vector<uint32_t> kept;
+  kept.reserve(catalog.size());
+  for (size_t i = 0; i < catalog.size(); ++i) {
+    if (filter.Accepts(catalog[i])) kept.push_back(static_cast<uint32_t>(i));
+  }
+  auto next = std::make_shared<PrebuiltCatalog>();
+  next->filter = filter;
+
+  // Names and identifiers are packed into one arena allocation, laid out
+  // by prefix sum and copied in parallel. Catalog codes take a handful of
+  // distinct values and are interned.
+  auto arena = std::make_shared<StringArena>();
+  std::vector<size_t> offsets(2 * kept.size() + 1, 0);
+  for (size_t j = 0; j < kept.size(); ++j) {
+    const auto& star = catalog[kept[j]];
+    offsets[2 * j + 1] = star.name.size();
+    offsets[2 * j + 2] = star.ids.size();
+  }
+  std::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+  char* text = arena->Allocate(offsets.back());
+  Pool().ParallelFor(kept.size(), grain_, [&](size_t j) {
+    const auto& star = catalog[kept[j]];
+    star.name.copy(text + offsets[2 * j], star.name.size());
+    star.ids.copy(text + offsets[2 * j + 1], star.ids.size());
+  });
+  auto view = [&](size_t k) {
+    return std::string_view(text + offsets[k], offsets[k + 1] - offsets[k]);
+  };
+
+  std::vector<std::string_view> codes(kept.size());
+  std::string_view last_code;
+  for (size_t j = 0; j < kept.size(); ++j) {
+    const std::string& code = catalog[kept[j]].catalog;
+    if (j == 0 || code != last_code) last_code = arena->Intern(code);
+    codes[j] = last_code;
+  }
+
+  BuildCatalog(
+      *next, kept,
+      [&](size_t j) {
+        const auto& star = catalog[kept[j]];
+        return StarRecord{
+            .ra = star.ra,
+            .dec = star.dec,
+            .pmra = star.pmra,
+            .pmdec = star.pmdec,
+            .parallax = star.parallax,
+            .radial_velocity = star.radial_velocity,
+            .magnitude = star.flux,
+            .name = view(2 * j),
+            .catalog = codes[j],
+            .ids = view(2 * j + 1),
+            .catalog_id = star.catalog_id,
+        };
+      },
+      std::move(arena));
+  Publish(std::move(next));
+}
+
+void AstrometryEngine::SetCatalog(std::shared_ptr<const BinaryCatalog> catalog,
+                                  const CatalogFilter& filter) {
+  if (!catalog) {
+    SetCatalog(std::span<const Star>{});
     return;
   }
 
-  // Prepare a future frame to determine if objects are rising or setting
-  novas_timespec t_spec_future;
-  novas_frame frame_future;
-  auto jd_future = GetJulianDayParts(time + std::chrono::minutes(1));
-  novas_set_split_time(NOVAS_UTC, jd_future.day_number, jd_future.fraction,
-                       kLeapSeconds, kDUT1, &t_spec_future);
-  auto frame_future_status = novas_make_frame(
-      static_cast<novas_accuracy>(accuracy_), &location, &t_spec_future,
-      kPolarOffsetX, kPolarOffsetY, &frame_future);
-
-  std::string filter_lower = filter.name_filter;
-  if (filter.active && !filter_lower.empty()) {
-    std::ranges::transform(filter_lower, filter_lower.begin(),
-                           [](unsigned char c) { return std::tolower(c); });
-  }
-
-  // Use a thread-local or pre-allocated vector for intermediate results to
-  // avoid heap churn. For now, we still use a local vector but we can optimize
-  // further if needed.
-  std::vector<std::optional<CelestialResult>> all_results(
-      prebuilt_->stars.size());
-  auto indices = std::views::iota(size_t{0}, prebuilt_->stars.size());
-
-  std::for_each(
-      std::execution::par, indices.begin(), indices.end(), [&](size_t i) {
-        // Quick name filter check before expensive calculations
-        if (filter.active && !filter_lower.empty()) {
-          if (!CaseInsensitiveContains(star_names_[i], filter_lower)) return;
-        }
+  if (storage_ == CatalogStorage::MAPPED) {
+    if (catalog->tiled()) {
+      SetMappedCatalog(std::move(catalog), filter);
+      return;
+    }
+    std::cerr << "Warning: Binary catalog is not tiled; loading it into "
+                 "memory instead of mapping it"
+              << std::endl;
+  }
+
+  const auto& file = *catalog;
+  auto ra = file.ra(), dec = file.dec(), pmra = file.pmra(),
+       pmdec = file.pmdec(), parallax = file.parallax(),
+       radial_velocity = file.radial_velocity();
+  auto flux = file.flux();
+  auto catalog_id = file.catalog_id();
+  auto coo_qual = file.quality(ZcatColumn::COO_QUAL),
+       pm_qual = file.quality(ZcatColumn::PM_QUAL),
+       plx_qual = file.quality(ZcatColumn::PLX_QUAL);
+
+  std::vector<uint32_t> kept;
+  kept.reserve(file.size());
+  for (size_t i = 0; i < file.size(); ++i) {
+    if (filter.Accepts(flux[i], dec[i], coo_qual[i], pm_qual[i],
+                       plx_qual[i])) {
+      kept.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  auto next = std::make_shared<PrebuiltCatalog>();
+  next->filter = filter;
+
+  BuildCatalog(
+      *next, kept,
+      [&](size_t j) {
+        size_t i = kept[j];
+        return StarRecord{
+            .ra = ra[i],
+            .dec = dec[i],
+            .pmra = pmra[i],
+            .pmdec = pmdec[i],
+            .parallax = parallax[i],
+            .radial_velocity = radial_velocity[i],
+            .magnitude = flux[i],
+            .name = file.name(i),
+            .catalog = file.catalog(i),
+            .ids = file.ids(i),
+            .catalog_id = static_cast<long>(catalog_id[i]),
+        };
+      },
+      catalog);
+  Publish(std::move(next));
+}
 
-        novas_frame frame_local = frame;
-        sky_pos star_position = {0};
-        double az = 0, el = 0;
+void AstrometryEngine::SetMappedCatalog(
+    std::shared_ptr<const BinaryCatalog> catalog,
+    const CatalogFilter& filter) {
+  auto next = std::make_shared<PrebuiltCatalog>();
+  next->max_proper_motion = catalog->max_proper_motion();
+  next->strings = catalog;
+  next->filter = filter;
+  next->mapped_stars = MappedStarColumns(std::move(catalog), filter);
+  next->storage = CatalogStorage::MAPPED;
+  Publish(std::move(next));
+}
 
-        // Apparent coordinates in system
-        auto status = novas_sky_pos(&prebuilt_->stars[i], &frame_local,
-                                    NOVAS_CIRS, &star_position);
+template <typename Source>
+void AstrometryEngine::BuildCatalog(PrebuiltCatalog& catalog,
+                                    std::span<const uint32_t> kept,
+                                    const Source& source,
+                                    std::shared_ptr<const void> strings) {
+  const size_t count = kept.size();
+  const bool compact = storage_ == CatalogStorage::COMPACT;
+  auto& columns = catalog.stars;
+  auto& compact_columns = catalog.compact_stars;
+  auto& info = catalog.star_info;
+  ThreadPool& pool = Pool();
+
+  if (compact) {
+    compact_columns.resize(count);
+  } else {
+    columns.resize(count);
+  }
+  info.resize(count);
+  catalog.storage = compact ? CatalogStorage::COMPACT : CatalogStorage::FULL;
+  catalog.kept.assign(kept.begin(), kept.end());
+  catalog.identifiers.assign(count, {});
+  catalog.max_proper_motion = 0.0;
+
+  // Bucket the stars into sky tiles, then lay the columns out in tile order
+  // so that every tile is one contiguous range.
+  {
+    std::vector<double> x(count), y(count), z(count);
+    pool.ParallelFor(count, grain_, [&](size_t j) {
+      auto star = source(j);
+      auto v = SkyVector::FromRaDec(star.ra, star.dec);
+      x[j] = v.x;
+      y[j] = v.y;
+      z[j] = v.z;
+      catalog.identifiers[j] = star.ids;
+    });
+    catalog.sky_index.Build(x, y, z);
+  }
+  auto order = catalog.sky_index.order();
+
+  // Every output slot is written by exactly one block; each block also
+  // reduces its own proper-motion maximum.
+  size_t blocks = (count + grain_ - 1) / grain_;
+  std::vector<double> block_max_motion(blocks, 0.0);
+  pool.ParallelFor(blocks, 1, [&](size_t b) {
+    size_t end = std::min(count, (b + 1) * grain_);
+    double max_motion = 0.0;
+    for (size_t i = b * grain_; i < end; ++i) {
+      const StarRecord star = source(order[i]);
+      max_motion = std::max(
+          max_motion, std::hypot(star.pmra, star.pmdec) * kMasToRad /
+                          kDegToRad);
+
+      if (compact) {
+        compact_columns.Store(i, star.ra, star.dec, star.pmra, star.pmdec,
+                              star.parallax, star.radial_velocity,
+                              star.magnitude);
+      } else {
+        // ICRS coordinates in the units expected by NOVAS cat_entry
+        columns.ra[i] = star.ra * kDegToHours;
+        columns.dec[i] = star.dec;
+        columns.pm_ra[i] = star.pmra;
+        columns.pm_dec[i] = star.pmdec;
+        columns.parallax[i] = star.parallax;
+        columns.radial_velocity[i] = star.radial_velocity;
+        columns.magnitude[i] = star.magnitude;
+
+        // Unit vector and its proper-motion derivative, precomputed for the
+        // fast transform path
+        auto v = MakeStarVectors(star.ra, star.dec, star.pmra, star.pmdec);
+        columns.unit_x[i] = v.unit[0];
+        columns.unit_y[i] = v.unit[1];
+        columns.unit_z[i] = v.unit[2];
+        columns.motion_x[i] = v.motion[0];
+        columns.motion_y[i] = v.motion[1];
+        columns.motion_z[i] = v.motion[2];
+      }
+
+      info.names[i] = star.name;
+      info.catalogs[i] = star.catalog;
+      info.catalog_ids[i] = star.catalog_id;
+      info.catalog_index[i] = kept[order[i]];
+    }
+    block_max_motion[b] = max_motion;
+  });
+  for (double max_motion : block_max_motion) {
+    catalog.max_proper_motion =
+        std::max(catalog.max_proper_motion, max_motion);
+  }
 
-        if (status != 0) {
-          return;
-        }
+  catalog.strings = std::move(strings);
+}
 
-        // Get local horizontal coordinates
-        novas_app_to_hor(&frame_local, NOVAS_CIRS, star_position.ra,
-                         star_position.dec, novas_standard_refraction, &az,
-                         &el);
-
-        // Filter by elevation and azimuth
-        if (filter.active) {
-          if (el < filter.min_elevation || el > filter.max_elevation) return;
-          if (az < filter.min_azimuth || az > filter.max_azimuth) return;
-        } else {
-          // Default: Filter out objects below the horizon
-          if (el < 0) return;
-        }
+namespace {
+constexpr char kSnapshotMagic[4] = {'Z', 'S', 'N', 'P'};
+constexpr uint32_t kSnapshotByteOrder = 0x01020304;
+constexpr uint64_t kSnapshotAlignment = 64;
 
-        // Determine if the star is rising by comparing to the future frame
-        bool rising = false;
-        if (frame_future_status == 0) {
-          novas_frame frame_future_local = frame_future;
-          double az_f = 0, el_f = 0;
-          novas_app_to_hor(&frame_future_local, NOVAS_CIRS, star_position.ra,
-                           star_position.dec, novas_standard_refraction, &az_f,
-                           &el_f);
-          rising = (el_f > el);
-        }
+// Numeric columns, sky index parts, string offset tables and string pool
+constexpr size_t kSnapshotSections = 13 + 7 + 3 + 3 + 3 + 1;
 
-        all_results[i] = CelestialResult{
-            .name = star_names_[i],
-            .elevation = el,
-            .azimuth = az,
-            .zenith_dist = 90.0 - el,
-            .magnitude = magnitudes_[i],
-            .is_rising = rising,
-        };
-      });
+struct SnapshotExtent {
+  uint64_t offset;  // From the start of the file, kSnapshotAlignment aligned
+  uint64_t bytes;
+};
+
+// Fixed header of an engine snapshot, in the writer's native byte order.
+// Everything that must match for the snapshot to be reused is recorded
+// here: source key, layout version, platform, storage and catalog filter.
+struct SnapshotHeader {
+  char magic[4];        // "ZSNP"
+  uint32_t version;     // AstrometryEngine::kSnapshotVersion
+  uint32_t byte_order;  // 0x01020304 as written
+  uint32_t long_size;   // sizeof(long), the width of catalog_ids
+  uint64_t source_key;
+  uint64_t file_size;
+  uint64_t star_count;
+  uint32_t storage;  // CatalogStorage
+  int32_t sky_depth;
+  double max_proper_motion;
+  CatalogFilter filter;
+  uint32_t section_count;
+  uint32_t reserved;
+  SnapshotExtent sections[kSnapshotSections];
+};
+
+uint64_t AlignSnapshot(uint64_t value) {
+  return (value + kSnapshotAlignment - 1) / kSnapshotAlignment *
+         kSnapshotAlignment;
+}
+
+// Calls fn(column, expected_size) for every numeric column of a prebuilt
+// catalog, in snapshot order. Columns of the storage not in use are empty.
+template <typename Catalog, typename Fn>
+void ForEachSnapshotColumn(Catalog& catalog, size_t count, Fn&& fn) {
+  size_t full = catalog.storage == CatalogStorage::FULL ? count : 0;
+  size_t compact = catalog.storage == CatalogStorage::COMPACT ? count : 0;
+
+  auto& stars = catalog.stars;
+  for (auto* column : {&stars.ra, &stars.dec, &stars.pm_ra, &stars.pm_dec,
+                       &stars.parallax, &stars.radial_velocity, &stars.unit_x,
+                       &stars.unit_y, &stars.unit_z, &stars.motion_x,
+                       &stars.motion_y, &stars.motion_z}) {
+    fn(*column, full);
+  }
+  fn(stars.magnitude, full);
+
+  auto& packed = catalog.compact_stars;
+  fn(packed.ra, compact);
+  for (auto* column : {&packed.dec, &packed.pm_ra, &packed.pm_dec}) {
+    fn(*column, compact);
+  }
+  fn(packed.parallax, compact);
+  fn(packed.radial_velocity, compact);
+  fn(packed.magnitude, compact);
+
+  fn(catalog.star_info.catalog_ids, count);
+  fn(catalog.star_info.catalog_index, count);
+  fn(catalog.kept, count);
+}
+
+// Appends sections to a snapshot file, each padded to the next aligned
+// offset, and records where they went.
+class SnapshotWriter {
+ public:
+  SnapshotWriter(std::ofstream& out, SnapshotHeader& header)
+      : out_(out), header_(header) {}
+
+  template <typename T>
+  void Write(std::span<const T> values) {
+    uint64_t bytes = values.size_bytes();
+    header_.sections[next_++] = {position_, bytes};
+    out_.seekp(static_cast<std::streamoff>(position_));
+    out_.write(reinterpret_cast<const char*>(values.data()),
+               static_cast<std::streamsize>(bytes));
+    if (bytes > 0) written_ = position_ + bytes;
+    position_ = AlignSnapshot(position_ + bytes);
+  }
+
+  uint64_t end() const { return position_; }
+  uint64_t written() const { return written_; }
 
-  // Collect results into the provided buffer
-  for (auto& res_opt : all_results) {
-    if (res_opt) {
-      buffer.star_results.push_back(*res_opt);
+ private:
+  std::ofstream& out_;
+  SnapshotHeader& header_;
+  size_t next_ = 0;
+  uint64_t position_ = AlignSnapshot(sizeof(SnapshotHeader));
+  uint64_t written_ = sizeof(SnapshotHeader);
+};
+
+// Reads the sections of a mapped snapshot back in order. Any section out
+// of bounds or of the wrong size clears ok() and reads as empty.
+class SnapshotReader {
+ public:
+  SnapshotReader(const MappedFile& file, const SnapshotHeader& header)
+      : file_(file), header_(header) {}
+
+  template <typename T>
+  std::span<const T> Read(std::optional<size_t> expected) {
+    const auto& extent = header_.sections[next_++];
+    if (extent.offset % kSnapshotAlignment != 0 ||
+        extent.offset > file_.size() ||
+        extent.bytes > file_.size() - extent.offset ||
+        extent.bytes % sizeof(T) != 0 ||
+        (expected && extent.bytes != *expected * sizeof(T))) {
+      ok_ = false;
+      return {};
     }
+    return {reinterpret_cast<const T*>(file_.data() + extent.offset),
+            static_cast<size_t>(extent.bytes / sizeof(T))};
   }
 
-  // Sorting
-  if (sort.column != SortColumn::NONE) {
-    std::stable_sort(
-        buffer.star_results.begin(), buffer.star_results.end(),
-        [&](const CelestialResult& a, const CelestialResult& b) {
-          auto get_val = [&](const CelestialResult& res) {
-            switch (sort.column) {
-              case SortColumn::NAME:
-                return 0.0;  // Special case for string
-              case SortColumn::ELEVATION:
-                return res.elevation;
-              case SortColumn::AZIMUTH:
-                return res.azimuth;
-              case SortColumn::MAGNITUDE:
-                return static_cast<double>(res.magnitude);
-              case SortColumn::STATE:
-                return static_cast<double>(res.is_rising);
-              default:
-                return 0.0;
-            }
-          };
+  template <typename T>
+  void Read(std::vector<T>& column, size_t expected) {
+    auto values = Read<T>(std::optional<size_t>(expected));
+    column.assign(values.begin(), values.end());
+  }
 
-          if (sort.column == SortColumn::NAME) {
-            return sort.ascending ? (a.name < b.name) : (b.name < a.name);
-          }
+  bool ok() const { return ok_; }
 
-          double val_a = get_val(a);
-          double val_b = get_val(b);
-          return sort.ascending ? (val_a < val_b) : (val_b < val_a);
-        });
+ private:
+  const MappedFile& file_;
+  const SnapshotHeader& header_;
+  size_t next_ = 0;
+  bool ok_ = true;
+};
+}  // namespace
+
+bool AstrometryEngine::SaveSnapshot(const std::filesystem::path& path,
+                                    uint64_t source_key) const {
+  auto catalog = Catalog();
+  if (catalog->storage == CatalogStorage::MAPPED) {
+    std::cerr << "Error: A mapped catalog has no snapshot to save"
+              << std::endl;
+    return false;
   }
 
-  // Apply offset and limit
-  if (filter.star_offset > 0 || filter.star_limit > 0) {
-    if (filter.star_offset >= buffer.star_results.size()) {
-      buffer.star_results.clear();
-      return;
+  auto temp_path = path;
+  temp_path += ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      std::cerr << "Error: Could not write engine snapshot " << path
+                << std::endl;
+      return false;
     }
-    auto start = buffer.star_results.begin() + filter.star_offset;
-    auto end = buffer.star_results.end();
-    if (filter.star_limit > 0 &&
-        filter.star_limit < static_cast<size_t>(std::distance(
-                                start, buffer.star_results.end()))) {
-      end = start + filter.star_limit;
+
+    const size_t count = catalog->size();
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.byte_order = kSnapshotByteOrder;
+    header.long_size = sizeof(long);
+    header.source_key = source_key;
+    header.star_count = count;
+    header.storage = static_cast<uint32_t>(catalog->storage);
+    header.sky_depth = catalog->sky_index.depth();
+    header.max_proper_motion = catalog->max_proper_motion;
+    header.filter = catalog->filter;
+    header.section_count = kSnapshotSections;
+
+    SnapshotWriter writer(out, header);
+    ForEachSnapshotColumn(*catalog, count, [&](const auto& column, size_t) {
+      writer.Write(std::span(column));
+    });
+
+    auto caps = catalog->sky_index.caps();
+    writer.Write(catalog->sky_index.order());
+    writer.Write(catalog->sky_index.offsets());
+    writer.Write(std::span<const SkyCap>(caps));
+
+    // Strings go back to back into one pool, addressed by offset tables
+    std::vector<char> pool;
+    for (const auto* views :
+         {&catalog->star_info.names, &catalog->star_info.catalogs,
+          &catalog->identifiers}) {
+      std::vector<uint64_t> offsets;
+      offsets.reserve(views->size() + 1);
+      offsets.push_back(pool.size());
+      for (std::string_view view : *views) {
+        pool.insert(pool.end(), view.begin(), view.end());
+        offsets.push_back(pool.size());
+      }
+      writer.Write(std::span<const uint64_t>(offsets));
     }
+    writer.Write(std::span<const char>(pool));
 
-    // Move the relevant slice to the front and resize
-    if (start != buffer.star_results.begin()) {
-      std::move(start, end, buffer.star_results.begin());
+    header.file_size = writer.end();
+    if (header.file_size > writer.written()) {
+      // Pad the file out to its aligned size
+      out.seekp(static_cast<std::streamoff>(header.file_size - 1));
+      out.put('\0');
+    }
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out.good()) {
+      std::cerr << "Error: Could not write engine snapshot " << path
+                << std::endl;
+      out.close();
+      std::filesystem::remove(temp_path);
+      return false;
     }
-    buffer.star_results.erase(
-        buffer.star_results.begin() + std::distance(start, end),
-        buffer.star_results.end());
   }
+
+  // Readers either see the old snapshot or the complete new one
+  std::error_code error;
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    std::cerr << "Error: Could not replace engine snapshot " << path << " ("
+              << error.message() << ")" << std::endl;
+    std::filesystem::remove(temp_path, error);
+    return false;
+  }
+  return true;
 }
 
-std::vector<SolarBody> AstrometryEngine::CalculateSolarSystem(
+bool AstrometryEngine::LoadSnapshot(const std::filesystem::path& path,
+                                    uint64_t source_key,
+                                    const CatalogFilter& filter) {
+  std::error_code error;
+  if (!std::filesystem::exists(path, error)) return false;
+  auto file = MappedFile::Open(path);
+  if (!file) return false;
+
+  auto reject = [&](const char* reason) {
+    std::cerr << "Note: Rebuilding the catalog, engine snapshot " << path
+              << " is not usable (" << reason << ")" << std::endl;
+    return false;
+  };
+
+  if (file->size() < sizeof(SnapshotHeader)) return reject("truncated");
+  const auto* header = reinterpret_cast<const SnapshotHeader*>(file->data());
+  if (std::memcmp(header->magic, kSnapshotMagic, sizeof(kSnapshotMagic)) !=
+      0) {
+    return reject("bad magic");
+  }
+  if (header->byte_order != kSnapshotByteOrder ||
+      header->long_size != sizeof(long)) {
+    return reject("other platform");
+  }
+  if (header->version != kSnapshotVersion) return reject("other version");
+  if (header->file_size != file->size()) return reject("truncated");
+  if (header->section_count != kSnapshotSections) return reject("layout");
+  if (header->source_key != source_key) return reject("catalog changed");
+  if (header->storage != static_cast<uint32_t>(storage_) ||
+      storage_ == CatalogStorage::MAPPED) {
+    return reject("other storage");
+  }
+  if (!(header->filter == filter)) return reject("other filter");
+
+  const size_t count = header->star_count;
+  if (count > file->size()) return reject("star count");
+
+  auto next = std::make_shared<PrebuiltCatalog>();
+  next->storage = storage_;
+  next->max_proper_motion = header->max_proper_motion;
+  next->filter = filter;
+
+  SnapshotReader reader(*file, *header);
+  ForEachSnapshotColumn(*next, count, [&](auto& column, size_t expected) {
+    reader.Read(column, expected);
+  });
+
+  auto order = reader.Read<uint32_t>(count);
+  auto tile_offsets = reader.Read<uint32_t>(std::nullopt);
+  auto caps = reader.Read<SkyCap>(std::nullopt);
+  if (!reader.ok() ||
+      !next->sky_index.Restore(header->sky_depth, order, tile_offsets, caps)) {
+    return reject("damaged");
+  }
+
+  auto names = reader.Read<uint64_t>(count + 1);
+  auto catalogs = reader.Read<uint64_t>(count + 1);
+  auto identifiers = reader.Read<uint64_t>(count + 1);
+  auto pool = reader.Read<char>(std::nullopt);
+  if (!reader.ok()) return reject("damaged");
+
+  // Every view must stay inside the pool, and kept must stay sorted for
+  // GetIdentifiers
+  for (auto offsets : {names, catalogs, identifiers}) {
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+      if (offsets[i] > offsets[i + 1]) return reject("damaged");
+    }
+    if (offsets.back() > pool.size()) return reject("damaged");
+  }
+  for (size_t i = 0; i + 1 < next->kept.size(); ++i) {
+    if (next->kept[i] >= next->kept[i + 1]) return reject("damaged");
+  }
+
+  auto view = [&](std::span<const uint64_t> offsets, size_t i) {
+    return std::string_view(pool.data() + offsets[i],
+                            offsets[i + 1] - offsets[i]);
+  };
+  next->star_info.names.resize(count);
+  next->star_info.catalogs.resize(count);
+  next->identifiers.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    next->star_info.names[i] = view(names, i);
+    next->star_info.catalogs[i] = view(catalogs, i);
+    next->identifiers[i] = view(identifiers, i);
+  }
+  next->strings = std::move(file);
+
+  Publish(std::move(next));
+  return true;
+}
+
+std::shared_ptr<const std::vector<std::string_view>>
+AstrometryEngine::GetIdentifiers(size_t catalog_index) const {
+  // The views share ownership of the snapshot they point into
+  struct Pinned {
+    std::shared_ptr<const PrebuiltCatalog> catalog;
+    std::vector<std::string_view> ids;
+  };
+  auto pinned = std::make_shared<Pinned>();
+  pinned->catalog = Catalog();
+  const auto& catalog = pinned->catalog;
+  auto& ids = pinned->ids;
+  std::shared_ptr<const std::vector<std::string_view>> result(pinned, &ids);
+  std::string_view list;
+  if (catalog->storage == CatalogStorage::MAPPED) {
+    const auto& columns = catalog->mapped_stars;
+    if (catalog_index >= columns.size() || !KeepsStar(columns, catalog_index)) {
+      return result;
+    }
+    list = columns.catalog->ids(catalog_index);
+  } else {
+    const auto& kept = catalog->kept;
+    auto it = std::lower_bound(kept.begin(), kept.end(), catalog_index);
+    if (it == kept.end() || *it != catalog_index) return result;
+    list = catalog->identifiers[it - kept.begin()];
+  }
+
+  while (!list.empty()) {
+    size_t bar = list.find('|');
+    ids.push_back(list.substr(0, bar));
+    list.remove_prefix(bar == std::string_view::npos ? list.size() : bar + 1);
+  }
+  return result;
+}
+
+size_t AstrometryEngine::GetStarCount() const { return Catalog()->size(); }
+
+std::shared_ptr<const SkyIndex> AstrometryEngine::GetSkyIndex() const {
+  auto catalog = Catalog();
+  return std::shared_ptr<const SkyIndex>(catalog, &catalog->sky_index);
+}
+
+std::vector<size_t> AstrometryEngine::ConeSearch(double ra_deg, double dec_deg,
+                                                 double radius_deg) const {
+  auto axis = SkyVector::FromRaDec(ra_deg, dec_deg);
+  double min_dot = std::cos(radius_deg * kDegToRad);
+
+  auto catalog = Catalog();
+  std::vector<SkyRange> ranges;
+  if (catalog->storage == CatalogStorage::MAPPED) {
+    const auto& file = *catalog->mapped_stars.catalog;
+    auto offsets = file.tile_offsets();
+    auto caps = file.tile_caps();
+    for (size_t tile = 0; tile < caps.size(); ++tile) {
+      const SkyCap& cap = caps[tile];
+      if (cap.radius < 0.0 ||
+          std::acos(std::clamp(axis.Dot(cap.center), -1.0, 1.0)) >
+              cap.radius + radius_deg * kDegToRad) {
+        continue;
+      }
+      ranges.push_back({static_cast<uint32_t>(offsets[tile]),
+                        static_cast<uint32_t>(offsets[tile + 1])});
+    }
+  } else {
+    catalog->sky_index.QueryAnnulus(axis, 0.0, radius_deg * kDegToRad,
+                                      ranges);
+  }
+
+  std::vector<size_t> matches;
+  catalog->Visit([&](const auto& columns) {
+    for (const auto& range : ranges) {
+      for (uint32_t i = range.begin; i < range.end; ++i) {
+        if (axis.Dot(UnitVectorOf(columns, i)) >= min_dot &&
+            KeepsStar(columns, i)) {
+          matches.push_back(
+              CatalogIndexOf(columns, catalog->star_info, i));
+        }
+      }
+    }
+  });
+  std::sort(matches.begin(), matches.end());
+  return matches;
+}
+
+std::shared_ptr<const AstrometryEngine::VisibilityTable>
+AstrometryEngine::GetVisibilityTable(
+    const std::shared_ptr<const PrebuiltCatalog>& catalog,
+    double latitude) const {
+  {
+    std::lock_guard<std::mutex> lock(visibility_mutex_);
+    if (visibility_ && visibility_->catalog.lock() == catalog &&
+        std::abs(visibility_->latitude - latitude) <=
+            kVisibilityLatitudeTolerance) {
+      return visibility_;
+    }
+  }
+
+  // Built outside the lock, so calculations with a current table never wait
+  // for it; callers that miss at the same time each build one
+  const size_t count = catalog->size();
+  auto table = std::make_shared<VisibilityTable>();
+  table->catalog = catalog;
+  table->latitude = latitude;
+  table->highest_elevation.resize(count);
+  table->lowest_elevation.resize(count);
+  catalog->Visit([&](const auto& columns) {
+    Pool().ParallelFor(count, grain_, [&](size_t i) {
+      double dec = DeclinationOf(columns, i);
+      table->highest_elevation[i] =
+          static_cast<float>(90.0 - std::abs(latitude - dec));
+      table->lowest_elevation[i] =
+          static_cast<float>(std::abs(latitude + dec) - 90.0);
+    });
+  });
+
+  // A calculation still on a replaced catalog keeps its table to itself
+  if (catalog != Catalog()) return table;
+  std::shared_ptr<const VisibilityTable> published = std::move(table);
+  std::lock_guard<std::mutex> lock(visibility_mutex_);
+  visibility_.swap(published);
+  return visibility_;
+}
+
+std::shared_ptr<const AstrometryEngine::CachedFrame> AstrometryEngine::GetFrame(
+    const Observer& obs, std::chrono::system_clock::time_point time) const {
+  // Frames and solar system bodies read the ephemeris around this time
+  if (preloader_) preloader_->Advance(time);
+
+  auto time_ms = std::chrono::floor<std::chrono::milliseconds>(time);
+  int64_t key_ms = time_ms.time_since_epoch().count();
+  int accuracy = accuracy_;
+
+  {
+    std::lock_guard<std::mutex> lock(frame_mutex_);
+    for (const auto& cached : frames_) {
+      if (cached && cached->Matches(obs, key_ms, accuracy)) return cached;
+    }
+  }
+
+  // Build outside the lock: frame construction evaluates the nutation series
+  // and concurrent callers asking for other keys should not wait on it.
+  auto cached = std::make_shared<CachedFrame>();
+  cached->observer = obs;
+  cached->time_ms = key_ms;
+  cached->accuracy = accuracy;
+  LookupTimes times;
+  int status = 0;
+  {
+    LookupScope scope(times);
+    status = MakeFrame(obs, time_ms, accuracy, &cached->frame);
+  }
+  RecordEphemerisReads(times.reads, times.total_ns, times.max_ns);
+  if (status != 0) return nullptr;
+
+  std::lock_guard<std::mutex> lock(frame_mutex_);
+  frames_[next_frame_slot_] = cached;
+  next_frame_slot_ = (next_frame_slot_ + 1) % frames_.size();
+  return cached;
+}
+
+void AstrometryEngine::SetThreadPool(std::shared_ptr<ThreadPool> pool,
+                                     size_t grain) {
+  pool_ = std::move(pool);
+  grain_ = std::max<size_t>(1, grain);
+}
+
+ThreadPool& AstrometryEngine::Pool() const {
+  return pool_ ? *pool_ : ThreadPool::Default();
+}
+
+void AstrometryEngine::SetAccuracyMode(AccuracyMode mode) {
+  accuracy_mode_ = mode;
+}
+
+void AstrometryEngine::SetEphemeris(std::shared_ptr<t_calcephbin> ephemeris) {
+  ephemeris_ = std::move(ephemeris);
+  initialized_ = false;  // Force re-initialization of NOVAS
+}
+
+void AstrometryEngine::SetSolarSystemMode(SolarSystemMode mode) {
+  solar_system_mode_ = mode;
+  initialized_ = false;  // The planet provider changes
+}
+
+void AstrometryEngine::RecordEphemerisReads(uint64_t reads, uint64_t total_ns,
+                                            uint64_t max_ns) const {
+  if (reads == 0) return;
+  ephemeris_reads_.fetch_add(reads, std::memory_order_relaxed);
+  ephemeris_read_ns_.fetch_add(total_ns, std::memory_order_relaxed);
+  uint64_t current = ephemeris_read_max_ns_.load(std::memory_order_relaxed);
+  while (current < max_ns &&
+         !ephemeris_read_max_ns_.compare_exchange_weak(
+             current, max_ns, std::memory_order_relaxed)) {
+  }
+}
+
+EphemerisReadStats AstrometryEngine::TakeEphemerisReadStats() const {
+  EphemerisReadStats stats;
+  stats.reads = ephemeris_reads_.exchange(0, std::memory_order_relaxed);
+  uint64_t total_ns =
+      ephemeris_read_ns_.exchange(0, std::memory_order_relaxed);
+  uint64_t max_ns =
+      ephemeris_read_max_ns_.exchange(0, std::memory_order_relaxed);
+  if (stats.reads > 0) {
+    stats.mean_us = static_cast<double>(total_ns) / 1000.0 /
+                    static_cast<double>(stats.reads);
+    stats.max_us = static_cast<double>(max_ns) / 1000.0;
+  }
+  return stats;
+}
+
+void AstrometryEngine::InitializeNovas() const {
+  std::lock_guard<std::mutex> lock(initialization_mutex_);
+  if (initialized_) return;
+
+  const bool analytic = solar_system_mode_ == SolarSystemMode::ANALYTIC;
+  if (analytic) {
+    InstallPlanetProviders(AnalyticPlanet, AnalyticPlanetHp);
+    accuracy_ = NOVAS_REDUCED_ACCURACY;
+  } else if (ephemeris_ && novas_use_calceph(ephemeris_.get()) >= 0) {
+    // Wrap the providers CALCEPH just installed
+    InstallPlanetProviders(get_planet_provider(), get_planet_provider_hp());
+    accuracy_ = NOVAS_FULL_ACCURACY;
+  } else {
+    // NOVAS's own Sun and Earth model, in case an analytic engine replaced it
+    InstallPlanetProviders(earth_sun_calc, earth_sun_calc_hp);
+    accuracy_ = NOVAS_REDUCED_ACCURACY;
+  }
+  // A prefetched CALCEPH handle may be read from several threads at once;
+  // without one NOVAS uses analytic models
+  parallel_ephemeris_ = analytic || !ephemeris_ ||
+                        calceph_isthreadsafe(ephemeris_.get()) == 1;
+  initialized_ = true;
+
+  // Frames depend on the ephemeris provider that was just installed
+  {
+    std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+    frames_.fill(nullptr);
+  }
+  planet_cache_->Clear();
+}
+
+std::vector<CelestialResult> AstrometryEngine::CalculateZenithProximity(
     const Observer& obs, const FilterCriteria& filter, const SortCriteria& sort,
     std::chrono::system_clock::time_point time) const {
   ResultBuffer buffer;
-  CalculateSolarSystem(buffer, obs, filter, sort, time);
-  return std::move(buffer.solar_results);
+  CalculateZenithProximity(buffer, obs, filter, sort, time);
+  return std::move(buffer.star_results);
 }
 
-void AstrometryEngine::CalculateSolarSystem(
+void AstrometryEngine::CalculateSky(
+    ResultBuffer& buffer, const Observer& obs, const SkyQuery& query,
+    std::chrono::system_clock::time_point time) const {
+  if (!initialized_) {
+    InitializeNovas();
+  }
+
+  buffer.clear();
+  auto cached_frame = GetFrame(obs, time);
+  if (!cached_frame) {
+    return;
+  }
+
+  // The handful of planets run as one pool task while the star batch fans
+  // out over the chunks; each pass writes only its own result vector.
+  Pool().Invoke(
+      [&] {
+        ComputeStars(buffer, Catalog(), obs, query.filter, query.star_sort,
+                     *cached_frame);
+      },
+      [&] {
+        ComputeSolarSystem(buffer.solar_results, obs, query.filter,
+                           query.solar_sort, *cached_frame);
+      });
+}
+
+void AstrometryEngine::CalculateZenithProximity(
     ResultBuffer& buffer, const Observer& obs, const FilterCriteria& filter,
     const SortCriteria& sort,
     std::chrono::system_clock::time_point time) const {
@@ -330,151 +1874,352 @@ void AstrometryEngine::CalculateSolarSystem(
     InitializeNovas();
   }
 
-  buffer.solar_results.clear();
-  if (!prebuilt_ || prebuilt_->planets.empty()) {
+  buffer.star_results.clear();
+  if (auto cached_frame = GetFrame(obs, time)) {
+    ComputeStars(buffer, Catalog(), obs, filter, sort, *cached_frame);
+  }
+}
+
+void AstrometryEngine::ComputeStars(
+    ResultBuffer& buffer, std::shared_ptr<const PrebuiltCatalog> catalog,
+    const Observer& obs, const FilterCriteria& filter,
+    const SortCriteria& sort, const CachedFrame& cached_frame) const {
+  buffer.star_results.clear();
+  if (catalog->size() == 0) {
     return;
   }
 
-  observer location;
-  novas_timespec t_spec;
-  novas_frame frame;
+  const novas_frame& frame = cached_frame.frame;
+  std::string filter_lower = LowercaseNameFilter(filter);
+
+  const auto& info = catalog->star_info;
+  const bool mapped = catalog->storage == CatalogStorage::MAPPED;
+
+  auto transform = MakeHorizonTransform(frame);
+
+  // Cheap visibility tests. The projected zenith component ignores
+  // refraction and a few arcseconds of unmodeled effects; the culmination
+  // bounds additionally ignore precession and proper motion since J2000 and
+  // the latitude tolerance of the cached table. Both only reject stars that
+  // miss the requested elevation band by more than their margin.
+  double band_min = filter.active ? filter.min_elevation : 0.0;
+  double band_max = filter.active ? filter.max_elevation : 90.0;
+  double margin = kMaxRefractionDeg + kUnmodeledMarginDeg;
+  double min_up = std::sin(std::max(band_min - margin, -90.0) * kDegToRad);
+  double max_up = std::sin(std::min(band_max + margin, 90.0) * kDegToRad);
+
+  double drift = std::abs(transform.years) *
+                 (kMaxPrecessionDegPerYear + catalog->max_proper_motion);
+  double culmination_margin = margin + kVisibilityLatitudeTolerance + drift;
+  double reach_min = band_min - culmination_margin;
+  double reach_max = band_max + culmination_margin;
+  float max_magnitude = filter.active
+                            ? filter.max_magnitude
+                            : std::numeric_limits<float>::infinity();
+
+  // The culmination table covers every star, which would read the whole
+  // declination column of a mapped catalog; those rely on the tile and
+  // zenith tests alone.
+  std::shared_ptr<const VisibilityTable> visibility;
+  if (!mapped) visibility = GetVisibilityTable(catalog, obs.latitude);
+
+  // Select the sky tiles that may hold stars inside the elevation band and
+  // azimuth window, as contiguous runs of the tile-ordered columns. The
+  // tile radius is widened by the same margin, plus proper motion since
+  // J2000 (precession is part of the horizon rotation).
+  HorizonWindow window{
+      .min_zenith = (90.0 - band_max) * kDegToRad,
+      .max_zenith = (90.0 - band_min) * kDegToRad,
+      .min_azimuth = filter.active ? filter.min_azimuth : 0.0,
+      .max_azimuth = filter.active ? filter.max_azimuth : 360.0,
+      .margin = (margin + std::abs(transform.years) *
+                              catalog->max_proper_motion) *
+                kDegToRad,
+  };
+  auto& scratch = buffer.scratch;
+  scratch.tiles.clear();
+  if (mapped) {
+    // Leaf tiles straight from the file, each cut at the magnitude limit
+    const auto& columns = catalog->mapped_stars;
+    auto offsets = columns.catalog->tile_offsets();
+    auto caps = columns.catalog->tile_caps();
+    float limit = std::min(max_magnitude, columns.filter.max_magnitude);
+    for (size_t tile = 0; tile < caps.size(); ++tile) {
+      if (caps[tile].radius < 0.0 ||
+          ClassifyTile(caps[tile], transform, window) == SkyOverlap::NONE) {
+        continue;
+      }
+      auto range = columns.Brightest(static_cast<uint32_t>(offsets[tile]),
+                                     static_cast<uint32_t>(offsets[tile + 1]),
+                                     limit);
+      if (range.begin == range.end) continue;
+      if (!scratch.tiles.empty() && scratch.tiles.back().end == range.begin) {
+        scratch.tiles.back().end = range.end;
+      } else {
+        scratch.tiles.push_back(range);
+      }
+    }
+  } else {
+    catalog->sky_index.QueryRegion(
+        [&](const SkyCap& cap) {
+          return ClassifyTile(cap, transform, window);
+        },
+        scratch.tiles);
+  }
+  scratch.chunks.clear();
+  SplitRanges(scratch.tiles, kChunkSize, scratch.chunks);
+  const auto& chunks = scratch.chunks;
+
+  // Every chunk writes its survivors compactly from its own slot range in
+  // `survivors`, so workers never share a slot and need no atomics. The
+  // counts are turned into output offsets afterwards.
+  auto& starts = scratch.chunk_starts;
+  starts.resize(chunks.size());
+  size_t selected = 0;
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    starts[c] = selected;
+    selected += chunks[c].end - chunks[c].begin;
+  }
+  if (scratch.survivors.size() < selected) {
+    scratch.survivors.resize(selected);
+  }
+  scratch.chunk_offsets.resize(chunks.size() + 1);
+  auto& survivors = scratch.survivors;
+  auto& kept = scratch.chunk_offsets;
+
+  ThreadPool& pool = Pool();
+  size_t chunk_grain = std::max<size_t>(1, grain_ / kChunkSize);
+
+  // Every storage shares the loops; the accessors pick the columns
+  catalog->Visit([&](const auto& columns) {
+    if (accuracy_mode_ == AccuracyMode::FAST) {
+      const on_surface* site = &frame.observer.on_surf;
+
+      pool.ParallelFor(chunks.size(), chunk_grain, [&](size_t c) {
+        size_t begin = chunks[c].begin;
+        size_t end = chunks[c].end;
+        size_t count = 0;
+
+        // Tight pass over the chunk: rotation and aberration only
+        HorizonVector projected[kChunkSize];
+        for (size_t i = begin; i < end; ++i) {
+          projected[i - begin] = ProjectToHorizon(columns, transform, i);
+        }
 
-  // Observer location
-  make_gps_observer(obs.latitude, obs.longitude, obs.altitude, &location);
+        // Scalar pass over the survivors
+        for (size_t i = begin; i < end; ++i) {
+          const auto& v = projected[i - begin];
+          if (v.up < min_up || v.up > max_up) continue;
+          if (MagnitudeOf(columns, i) > max_magnitude ||
+              !KeepsStar(columns, i)) {
+            continue;
+          }
 
-  // Set time of observance
-  auto jd = GetJulianDayParts(time);
-  novas_set_split_time(NOVAS_UTC, jd.day_number, jd.fraction, kLeapSeconds,
-                       kDUT1, &t_spec);
+          std::string_view name = NameOf(columns, info, i);
+          if (!filter_lower.empty() &&
+              !CaseInsensitiveContains(name, filter_lower)) {
+            continue;
+          }
 
-  // Observer frame
-  auto frame_status =
-      novas_make_frame(static_cast<novas_accuracy>(accuracy_), &location,
-                       &t_spec, kPolarOffsetX, kPolarOffsetY, &frame);
+          double az = 0, el = 0;
+          HorizonVectorToAngles(v, &az, &el);
+          el += novas_standard_refraction(transform.jd_tt, site,
+                                          NOVAS_REFRACT_ASTROMETRIC, el);
+
+          if (!PassesBand(filter, el, az)) continue;
+
+          double rate = ElevationRate(obs.latitude, az);
+          survivors[starts[c] + count++] = CelestialResult{
+              .name = name,
+              .elevation = el,
+              .azimuth = az,
+              .zenith_dist = 90.0 - el,
+              .magnitude = MagnitudeOf(columns, i),
+              .is_rising = rate > 0.0,
+              .elevation_rate = rate,
+              .catalog_index = CatalogIndexOf(columns, info, i),
+          };
+        }
+        kept[c] = count;
+      });
+    } else {
+      pool.ParallelFor(chunks.size(), chunk_grain, [&](size_t c) {
+        size_t count = 0;
+        for (size_t i = chunks[c].begin; i < chunks[c].end; ++i) {
+          // Quick magnitude and name checks before expensive calculations
+          if (MagnitudeOf(columns, i) > max_magnitude ||
+              !KeepsStar(columns, i)) {
+            continue;
+          }
+          std::string_view name = NameOf(columns, info, i);
+          if (!filter_lower.empty() &&
+              !CaseInsensitiveContains(name, filter_lower)) {
+            continue;
+          }
 
-  if (frame_status != 0) {
-    return;
-  }
+          // Skip stars that cannot reach the band at this latitude, then
+          // those the hour-angle pre-test places outside it right now.
+          if (visibility && (visibility->highest_elevation[i] < reach_min ||
+                             visibility->lowest_elevation[i] > reach_max)) {
+            continue;
+          }
+          double up = ProjectToHorizon(columns, transform, i).up;
+          if (up < min_up || up > max_up) continue;
+
+          // Each worker keeps one NOVAS object and patches in the star's
+          // coordinates, so only the hot columns are read per star.
+          thread_local object star_object = MakeStarTemplate();
+          auto coordinates = CoordinatesOf(columns, i);
+          star_object.star.ra = coordinates.ra;
+          star_object.star.dec = coordinates.dec;
+          star_object.star.promora = coordinates.pm_ra;
+          star_object.star.promodec = coordinates.pm_dec;
+          star_object.star.parallax = coordinates.parallax;
+          star_object.star.radialvelocity = coordinates.radial_velocity;
+
+          novas_frame frame_local = frame;
+          sky_pos star_position = {0};
+          double az = 0, el = 0;
+
+          // Apparent coordinates in system
+          auto status = novas_sky_pos(&star_object, &frame_local, NOVAS_CIRS,
+                                      &star_position);
+
+          if (status != 0) {
+            continue;
+          }
+
+          // Get local horizontal coordinates
+          novas_app_to_hor(&frame_local, NOVAS_CIRS, star_position.ra,
+                           star_position.dec, novas_standard_refraction, &az,
+                           &el);
+
+          if (!PassesBand(filter, el, az)) continue;
+
+          double rate = ElevationRate(obs.latitude, az);
+          survivors[starts[c] + count++] = CelestialResult{
+              .name = name,
+              .elevation = el,
+              .azimuth = az,
+              .zenith_dist = 90.0 - el,
+              .magnitude = MagnitudeOf(columns, i),
+              .is_rising = rate > 0.0,
+              .elevation_rate = rate,
+              .catalog_index = CatalogIndexOf(columns, info, i),
+          };
+        }
+        kept[c] = count;
+      });
+    }
+  });
+
+  // Exclusive prefix sum of the survivor counts gives each chunk's offset in
+  // the output, then every chunk copies its survivors into place in parallel.
+  kept.back() = 0;
+  std::exclusive_scan(kept.begin(), kept.end(), kept.begin(), size_t{0});
+  buffer.star_results.resize(kept.back());
+  pool.ParallelFor(chunks.size(), chunk_grain, [&](size_t c) {
+    auto first = survivors.begin() + starts[c];
+    std::copy(first, first + (kept[c + 1] - kept[c]),
+              buffer.star_results.begin() + kept[c]);
+  });
+
+  // Sorting and pagination. The columns are stored in sky-tile order, so
+  // ties (and SortColumn::NONE) fall back to the original catalog order,
+  // which also makes the top-K selection for paginated queries
+  // deterministic.
+  SortAndPaginate(buffer.star_results, sort, filter.star_offset,
+                  filter.star_limit, pool);
+  buffer.catalog = std::move(catalog);
+}
 
-  // Prepare a future frame to determine if objects are rising or setting
-  novas_timespec t_spec_future;
-  novas_frame frame_future;
-  auto jd_future = GetJulianDayParts(time + std::chrono::seconds(1));
-  novas_set_split_time(NOVAS_UTC, jd_future.day_number, jd_future.fraction,
-                       kLeapSeconds, kDUT1, &t_spec_future);
-  auto frame_future_status = novas_make_frame(
-      static_cast<novas_accuracy>(accuracy_), &location, &t_spec_future,
-      kPolarOffsetX, kPolarOffsetY, &frame_future);
+std::vector<SolarBody> AstrometryEngine::CalculateSolarSystem(
+    const Observer& obs, const FilterCriteria& filter, const SortCriteria& sort,
+    std::chrono::system_clock::time_point time) const {
+  ResultBuffer buffer;
+  CalculateSolarSystem(buffer, obs, filter, sort, time);
+  return std::move(buffer.solar_results);
+}
 
-  std::string filter_lower = filter.name_filter;
-  if (filter.active && !filter_lower.empty()) {
-    std::ranges::transform(filter_lower, filter_lower.begin(),
-                           [](unsigned char c) { return std::tolower(c); });
+void AstrometryEngine::CalculateSolarSystem(
+    ResultBuffer& buffer, const Observer& obs, const FilterCriteria& filter,
+    const SortCriteria& sort,
+    std::chrono::system_clock::time_point time) const {
+  if (!initialized_) {
+    InitializeNovas();
   }
 
-  for (const auto& planet_obj : prebuilt_->planets) {
-    // Quick name filter check
-    if (filter.active && !filter_lower.empty()) {
-      if (!CaseInsensitiveContains(planet_obj.name, filter_lower)) continue;
-    }
+  buffer.solar_results.clear();
+  if (auto cached_frame = GetFrame(obs, time)) {
+    ComputeSolarSystem(buffer.solar_results, obs, filter, sort, *cached_frame);
+  }
+}
+
+void AstrometryEngine::ComputeSolarSystem(
+    std::vector<SolarBody>& results, const Observer& obs,
+    const FilterCriteria& filter, const SortCriteria& sort,
+    const CachedFrame& cached_frame) const {
+  results.clear();
+
+  const novas_frame& frame = cached_frame.frame;
+  std::string filter_lower = LowercaseNameFilter(filter);
+
+  const auto& planets = PlanetCatalog();
+  auto wanted = [&](size_t p) {
+    return filter_lower.empty() ||
+           CaseInsensitiveContains(planets[p].name, filter_lower);
+  };
 
-    sky_pos planet_position = {0};
-    // Apparent coordinates in system
-    auto status =
-        novas_sky_pos(&planet_obj, &frame, NOVAS_CIRS, &planet_position);
+  // Apparent places, from the Chebyshev fits with a cache window, else
+  // from the ephemeris, one body per task when it allows concurrent reads
+  std::array<ApparentPlace, kMaxSolarBodies> places;
+  if (planet_cache_->window().count() > 0) {
+    planet_cache_->Evaluate(obs, cached_frame.time_ms, places);
+  } else {
+    const ObserverState observer = MakeObserverState(frame);
+    ForEachBody(parallel_ephemeris_ ? &Pool() : nullptr, planets.size(),
+                [&](size_t p) {
+                  if (!wanted(p)) {
+                    places[p] = ApparentPlace{};
+                    return;
+                  }
+                  LookupTimes times;
+                  {
+                    LookupScope scope(times);
+                    places[p] = PlanetPlace(planets[p], frame, observer,
+                                            light_times_[p]);
+                  }
+                  RecordEphemerisReads(times.reads, times.total_ns,
+                                       times.max_ns);
+                });
+  }
 
-    if (status != 0) continue;
+  for (size_t p = 0; p < planets.size(); ++p) {
+    const auto& planet_obj = planets[p];
+    if (!wanted(p) || !places[p].valid) continue;
 
     // Get local horizontal coordinates
     double az = 0, el = 0;
-    novas_app_to_hor(&frame, NOVAS_CIRS, planet_position.ra,
-                     planet_position.dec, novas_standard_refraction, &az, &el);
+    novas_app_to_hor(&frame, NOVAS_CIRS, places[p].ra, places[p].dec,
+                     novas_standard_refraction, &az, &el);
 
-    // Filter by elevation and azimuth
-    if (filter.active) {
-      if (el < filter.min_elevation || el > filter.max_elevation) continue;
-      if (az < filter.min_azimuth || az > filter.max_azimuth) continue;
-    } else {
-      // Default: Filter out objects below the horizon
-      if (el < 0) continue;
-    }
-
-    // Determine if the planet is rising by comparing to the future frame
-    bool rising = false;
-    if (frame_future_status == 0) {
-      double az_f = 0, el_f = 0;
-      novas_app_to_hor(&frame_future, NOVAS_CIRS, planet_position.ra,
-                       planet_position.dec, novas_standard_refraction, &az_f,
-                       &el_f);
-      rising = (el_f > el);
-    }
+    if (!PassesBand(filter, el, az)) continue;
 
-    buffer.solar_results.emplace_back(SolarBody{
+    double rate = ElevationRate(obs.latitude, az);
+    results.emplace_back(SolarBody{
         .name = planet_obj.name,
         .elevation = el,
         .azimuth = az,
         .zenith_dist = 90.0 - el,
-        .distance_au = planet_position.dis,
-        .is_rising = rising,
+        .distance_au = places[p].distance,
+        .is_rising = rate > 0.0,
+        .elevation_rate = rate,
+        .catalog_index = p,
     });
   }
 
-  // Sorting
-  if (sort.column != SortColumn::NONE) {
-    std::stable_sort(
-        buffer.solar_results.begin(), buffer.solar_results.end(),
-        [&](const SolarBody& a, const SolarBody& b) {
-          auto get_val = [&](const SolarBody& res) {
-            switch (sort.column) {
-              case SortColumn::NAME:
-                return 0.0;
-              case SortColumn::ELEVATION:
-                return res.elevation;
-              case SortColumn::AZIMUTH:
-                return res.azimuth;
-              case SortColumn::ZENITH:
-                return res.zenith_dist;
-              case SortColumn::DISTANCE:
-                return res.distance_au;
-              case SortColumn::STATE:
-                return static_cast<double>(res.is_rising);
-              default:
-                return 0.0;
-            }
-          };
-
-          if (sort.column == SortColumn::NAME) {
-            return sort.ascending ? (a.name < b.name) : (b.name < a.name);
-          }
-
-          double val_a = get_val(a);
-          double val_b = get_val(b);
-          return sort.ascending ? (val_a < val_b) : (val_b < val_a);
-        });
-  }
-
-  // Apply offset and limit
-  if (filter.solar_offset > 0 || filter.solar_limit > 0) {
-    if (filter.solar_offset >= buffer.solar_results.size()) {
-      buffer.solar_results.clear();
-      return;
-    }
-    auto start = buffer.solar_results.begin() + filter.solar_offset;
-    auto end = buffer.solar_results.end();
-    if (filter.solar_limit > 0 &&
-        filter.solar_limit < static_cast<size_t>(std::distance(
-                                 start, buffer.solar_results.end()))) {
-      end = start + filter.solar_limit;
-    }
-
-    // Move the relevant slice to the front and resize
-    if (start != buffer.solar_results.begin()) {
-      std::move(start, end, buffer.solar_results.begin());
-    }
-    buffer.solar_results.erase(
-        buffer.solar_results.begin() + std::distance(start, end),
-        buffer.solar_results.end());
-  }
+  SortAndPaginate(results, sort, filter.solar_offset, filter.solar_limit,
+                  Pool());
 }
 
 }  // namespace engine
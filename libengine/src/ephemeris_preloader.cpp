@@ -0,0 +1,288 @@
+#include "ephemeris_preloader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "constants.hpp"
+
+namespace engine {
+
+namespace {
+
+// DAF layout (NAIF "Double precision Array File"): 1024-byte records of
+// 8-byte words. The file record names the first summary record; summary
+// records form a linked list of segment descriptors.
+constexpr size_t kRecordBytes = 1024;
+constexpr size_t kWordBytes = 8;
+constexpr int kSpkDoubles = 2;   // ND: start and end epoch
+constexpr int kSpkIntegers = 6;  // NI: target, center, frame, type, begin, end
+
+// Touching one byte per page brings the page into memory. The sum of the
+// bytes read goes to g_page_sink so that the reads are not optimized away.
+constexpr size_t kPageBytes = 4096;
+std::atomic<unsigned> g_page_sink{0};
+
+// Seconds from the Unix epoch to J2000 (2000-01-01 12:00 UTC), and TDB-UTC
+// as TT-UTC (TDB differs from TT by under 2 ms, far below a record length).
+constexpr double kUnixJ2000 = 946728000.0;
+constexpr double kTdbMinusUtc = kLeapSeconds + 32.184;
+
+template <typename T>
+T ReadValue(const std::byte* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+double ToEphemerisTime(std::chrono::system_clock::time_point time) {
+  double unix_s =
+      std::chrono::duration<double>(time.time_since_epoch()).count();
+  return unix_s - kUnixJ2000 + kTdbMinusUtc;
+}
+
+}  // namespace
+
+std::shared_ptr<EphemerisPreloader> EphemerisPreloader::Open(
+    const std::filesystem::path& path, std::chrono::hours span) {
+  auto file = MappedFile::Open(path);
+  if (!file) return nullptr;
+
+  const std::byte* data = file->data();
+  const size_t size = file->size();
+  if (size < kRecordBytes ||
+      (std::memcmp(data, "DAF/SPK ", 8) != 0 &&
+       std::memcmp(data, "NAIF/DAF", 8) != 0)) {
+    std::cerr << "Warning: " << path
+              << " is not an SPK ephemeris; it will not be preloaded"
+              << std::endl;
+    return nullptr;
+  }
+  if (std::endian::native != std::endian::little ||
+      std::memcmp(data + 88, "LTL-IEEE", 8) != 0) {
+    std::cerr << "Warning: " << path
+              << " is not a little-endian SPK file; it will not be preloaded"
+              << std::endl;
+    return nullptr;
+  }
+  if (ReadValue<int32_t>(data + 8) != kSpkDoubles ||
+      ReadValue<int32_t>(data + 12) != kSpkIntegers) {
+    std::cerr << "Warning: Unexpected SPK summary format in " << path
+              << std::endl;
+    return nullptr;
+  }
+
+  std::shared_ptr<EphemerisPreloader> preloader(new EphemerisPreloader());
+  preloader->file_ = file;
+  preloader->span_ = std::max(span, std::chrono::hours(1));
+
+  // Each summary is ND doubles followed by NI integers packed two per word
+  constexpr size_t kSummaryWords = kSpkDoubles + (kSpkIntegers + 1) / 2;
+  const uint64_t file_words = size / kWordBytes;
+  int32_t record = ReadValue<int32_t>(data + 76);  // FWARD
+  for (size_t visited = 0; record > 0; ++visited) {
+    size_t offset = static_cast<size_t>(record - 1) * kRecordBytes;
+    if (offset + kRecordBytes > size || visited > size / kRecordBytes) break;
+    const std::byte* summary_record = data + offset;
+    auto next = static_cast<int32_t>(ReadValue<double>(summary_record));
+    auto count = static_cast<size_t>(ReadValue<double>(summary_record + 16));
+    count = std::min(count, (kRecordBytes / kWordBytes - 3) / kSummaryWords);
+
+    for (size_t i = 0; i < count; ++i) {
+      const std::byte* summary =
+          summary_record + (3 + i * kSummaryWords) * kWordBytes;
+      const std::byte* integers = summary + kSpkDoubles * kWordBytes;
+      Segment segment;
+      segment.start_et = ReadValue<double>(summary);
+      segment.end_et = ReadValue<double>(summary + kWordBytes);
+      int32_t type = ReadValue<int32_t>(integers + 12);
+      int32_t begin = ReadValue<int32_t>(integers + 16);
+      int32_t end = ReadValue<int32_t>(integers + 20);
+      if (begin < 1 || end < begin || static_cast<uint64_t>(end) > file_words) {
+        continue;
+      }
+      segment.begin_word = static_cast<uint64_t>(begin);
+      segment.end_word = static_cast<uint64_t>(end);
+
+      // Types 2 and 3 end with INIT, INTLEN, RSIZE and N
+      if ((type == 2 || type == 3) && end - begin >= 4) {
+        const std::byte* trailer = data + (segment.end_word - 4) * kWordBytes;
+        double interval = ReadValue<double>(trailer + kWordBytes);
+        double record_words = ReadValue<double>(trailer + 2 * kWordBytes);
+        double records = ReadValue<double>(trailer + 3 * kWordBytes);
+        if (interval > 0.0 && record_words >= 1.0 && records >= 1.0) {
+          segment.init = ReadValue<double>(trailer);
+          segment.interval = interval;
+          segment.record_words = static_cast<uint64_t>(record_words);
+          segment.records = static_cast<uint64_t>(records);
+        }
+      }
+      preloader->segments_.push_back(segment);
+    }
+    record = next;
+  }
+
+  if (preloader->segments_.empty()) {
+    std::cerr << "Warning: No segments found in " << path << std::endl;
+    return nullptr;
+  }
+  return preloader;
+}
+
+EphemerisPreloader::~EphemerisPreloader() {
+  if (next_.valid()) next_.wait();
+}
+
+EphemerisPreloader::LoadResult EphemerisPreloader::Load(double start_et,
+                                                        double end_et) const {
+  auto started = std::chrono::steady_clock::now();
+  LoadResult result{.start_et = start_et, .end_et = end_et};
+
+  for (const auto& segment : segments_) {
+    if (segment.end_et < start_et || segment.start_et >= end_et) continue;
+
+    uint64_t first = segment.begin_word - 1;  // 0-based, inclusive
+    uint64_t last = segment.end_word;         // 0-based, exclusive
+    if (segment.interval > 0.0) {
+      auto index = [&](double et) {
+        double k = std::floor((et - segment.init) / segment.interval);
+        return static_cast<uint64_t>(
+            std::clamp(k, 0.0, static_cast<double>(segment.records - 1)));
+      };
+      first += index(start_et) * segment.record_words;
+      last = std::min(last, segment.begin_word - 1 +
+                                (index(end_et) + 1) * segment.record_words);
+    }
+
+    size_t begin = static_cast<size_t>(first) * kWordBytes;
+    size_t end = static_cast<size_t>(last) * kWordBytes;
+    if (end <= begin) continue;
+    result.ranges.emplace_back(begin, end - begin);
+    result.bytes += end - begin;
+  }
+
+  // Reading first brings the pages in with the file's own read-ahead
+  Touch(result.ranges);
+  for (const auto& [offset, bytes] : result.ranges) {
+    if (!file_->Lock(offset, bytes)) result.locked = false;
+  }
+
+  result.ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - started)
+                  .count();
+  return result;
+}
+
+void EphemerisPreloader::Touch(
+    const std::vector<std::pair<size_t, size_t>>& ranges) const {
+  const std::byte* data = file_->data();
+  unsigned checksum = 0;
+  for (const auto& [begin, bytes] : ranges) {
+    for (size_t offset = begin; offset < begin + bytes;
+         offset = (offset / kPageBytes + 1) * kPageBytes) {
+      checksum += static_cast<unsigned>(data[offset]);
+    }
+  }
+  g_page_sink.fetch_add(checksum, std::memory_order_relaxed);
+}
+
+void EphemerisPreloader::Apply(LoadResult result, bool stalled) {
+  ++stats_.loads;
+  stats_.bytes = result.bytes;
+  stats_.last_load_ms = result.ms;
+  stats_.stalled = stalled;
+  if (!result.locked && !warned_) {
+    std::cerr << "Warning: Could not lock the preloaded ephemeris in memory;"
+              << " it will be re-read every tick instead" << std::endl;
+    warned_ = true;
+  }
+
+  // A load adjoining the resident span extends it, and replaces the oldest
+  // span once there are two; any other load replaces them all
+  bool adjoining = loaded_end_et_ > loaded_start_et_ &&
+                   result.start_et <= loaded_end_et_ &&
+                   result.end_et >= loaded_start_et_;
+  std::vector<LoadResult> released;
+  if (!adjoining) {
+    released = std::move(resident_);
+    resident_.clear();
+  } else if (resident_.size() >= 2) {
+    released.push_back(std::move(resident_.front()));
+    resident_.erase(resident_.begin());
+  }
+  resident_.push_back(std::move(result));
+  for (const auto& span : released) {
+    for (const auto& [offset, bytes] : span.ranges) {
+      file_->Unlock(offset, bytes);
+    }
+  }
+  // Locks do not nest, so pages shared with a released span are locked
+  // again
+  if (!released.empty()) {
+    for (const auto& span : resident_) {
+      for (const auto& [offset, bytes] : span.ranges) {
+        file_->Lock(offset, bytes);
+      }
+    }
+  }
+
+  loaded_start_et_ = resident_.front().start_et;
+  loaded_end_et_ = resident_.front().end_et;
+  stats_.resident_bytes = 0;
+  for (const auto& span : resident_) {
+    loaded_start_et_ = std::min(loaded_start_et_, span.start_et);
+    loaded_end_et_ = std::max(loaded_end_et_, span.end_et);
+    stats_.resident_bytes += span.bytes;
+  }
+}
+
+void EphemerisPreloader::Preload(std::chrono::system_clock::time_point time) {
+  const double span_s = std::chrono::duration<double>(span_).count();
+  double et = ToEphemerisTime(time);
+  auto result = Load(et - span_s / 2.0, et + span_s / 2.0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  Apply(result, /*stalled=*/false);
+}
+
+void EphemerisPreloader::Advance(std::chrono::system_clock::time_point time) {
+  const double span_s = std::chrono::duration<double>(span_).count();
+  const double et = ToEphemerisTime(time);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto covered = [&] { return et >= loaded_start_et_ && et < loaded_end_et_; };
+  if (next_.valid() &&
+      next_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    Apply(next_.get(), /*stalled=*/false);
+  }
+  if (!covered() && next_.valid()) {
+    // Overtook the background load; it may still cover this time
+    Apply(next_.get(), /*stalled=*/true);
+  }
+  if (!covered()) {
+    // A jump: read around the new time before it is used
+    Apply(Load(et - span_s / 2.0, et + span_s / 2.0), /*stalled=*/true);
+    return;
+  }
+
+  // Pages that could not be locked stay recently used
+  for (const auto& span : resident_) {
+    if (!span.locked) Touch(span.ranges);
+  }
+
+  if (et >= loaded_end_et_ - span_s / 4.0 && !next_.valid()) {
+    double start = loaded_end_et_;
+    next_ = std::async(std::launch::async, [this, start, span_s] {
+      return Load(start, start + span_s);
+    });
+  }
+}
+
+EphemerisPreloader::Stats EphemerisPreloader::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace engine
@@ -0,0 +1,115 @@
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+
+std::shared_ptr<const MappedFile> MappedFile::Open(
+    const std::filesystem::path& path) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+
+#if defined(_WIN32)
+  HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    std::cerr << "Error: Could not open " << path << std::endl;
+    return nullptr;
+  }
+  file->file_ = handle;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size)) return nullptr;
+  file->size_ = static_cast<size_t>(size.QuadPart);
+  if (file->size_ == 0) return file;
+
+  HANDLE mapping =
+      CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    std::cerr << "Error: Could not map " << path << std::endl;
+    return nullptr;
+  }
+  file->mapping_ = mapping;
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    std::cerr << "Error: Could not map " << path << std::endl;
+    return nullptr;
+  }
+  file->data_ = static_cast<const std::byte*>(view);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Error: Could not open " << path << std::endl;
+    return nullptr;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  file->size_ = static_cast<size_t>(info.st_size);
+  if (file->size_ == 0) {
+    ::close(fd);
+    return file;
+  }
+
+  // The mapping keeps its own reference to the file
+  void* view = ::mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    std::cerr << "Error: Could not map " << path << std::endl;
+    file->size_ = 0;
+    return nullptr;
+  }
+  file->data_ = static_cast<const std::byte*>(view);
+#endif
+
+  return file;
+}
+
+bool MappedFile::Lock(size_t offset, size_t bytes) const {
+  if (offset >= size_ || bytes == 0) return true;
+  bytes = std::min(bytes, size_ - offset);
+#if defined(_WIN32)
+  return VirtualLock(const_cast<std::byte*>(data_ + offset), bytes) != 0;
+#else
+  return ::mlock(data_ + offset, bytes) == 0;
+#endif
+}
+
+void MappedFile::Unlock(size_t offset, size_t bytes) const {
+  if (offset >= size_ || bytes == 0) return;
+  bytes = std::min(bytes, size_ - offset);
+#if defined(_WIN32)
+  VirtualUnlock(const_cast<std::byte*>(data_ + offset), bytes);
+#else
+  ::munlock(data_ + offset, bytes);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  if (file_) CloseHandle(file_);
+#else
+  if (data_) ::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+}
+
+}  // namespace engine
@@ -0,0 +1,169 @@
+#include "planet_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine {
+
+bool PlanetCache::Fit::Covers(const Observer& obs, int64_t time_ms) const {
+  return time_ms >= start_ms && time_ms <= end_ms &&
+         std::abs(obs.latitude - observer.latitude) <= kObserverTolerance &&
+         std::abs(obs.longitude - observer.longitude) <= kObserverTolerance &&
+         std::abs(obs.altitude - observer.altitude) <= kAltitudeTolerance;
+}
+
+PlanetCache::PlanetCache(size_t body_count, Sampler sampler)
+    : body_count_(body_count), sampler_(std::move(sampler)) {}
+
+PlanetCache::~PlanetCache() {
+  if (next_.valid()) next_.wait();
+}
+
+void PlanetCache::SetWindow(std::chrono::milliseconds window) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  window_ = std::clamp(window, std::chrono::milliseconds(0), kMaxWindow);
+  ++generation_;
+  current_.reset();
+  upcoming_.reset();
+}
+
+std::chrono::milliseconds PlanetCache::window() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return window_;
+}
+
+void PlanetCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  current_.reset();
+  upcoming_.reset();
+}
+
+std::shared_ptr<const PlanetCache::Fit> PlanetCache::MakeFit(
+    const Observer& obs, int64_t start_ms, int64_t window_ms,
+    uint64_t generation) const {
+  auto fit = std::make_shared<Fit>();
+  fit->observer = obs;
+  fit->start_ms = start_ms;
+  fit->end_ms = start_ms + window_ms;
+  fit->generation = generation;
+  fit->series.resize(body_count_);
+  fit->valid.assign(body_count_, true);
+
+  // Fits run in seconds from the start of the window
+  const double span_s = static_cast<double>(window_ms) / 1000.0;
+  std::vector<std::array<double, kNodes>> ra(body_count_), dec(body_count_),
+      distance(body_count_);
+  std::array<int64_t, kNodes> times;
+  std::array<double, kNodes> lag_s;  // Sampled time minus the node
+  for (size_t k = 0; k < kNodes; ++k) {
+    double t = ChebyshevSeries::Node(k, kNodes, 0.0, span_s);
+    times[k] = start_ms + std::llround(t * 1000.0);
+    lag_s[k] = static_cast<double>(times[k] - start_ms) / 1000.0 - t;
+  }
+  std::vector<ApparentPlace> places(kNodes * body_count_);
+  {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    sampler_(obs, times, places);
+  }
+  for (size_t k = 0; k < kNodes; ++k) {
+    for (size_t b = 0; b < body_count_; ++b) {
+      const auto& place = places[k * body_count_ + b];
+      if (!place.valid) fit->valid[b] = false;
+      ra[b][k] = place.ra;
+      dec[b][k] = place.dec;
+      distance[b][k] = place.distance;
+    }
+  }
+
+  for (size_t b = 0; b < body_count_; ++b) {
+    // Nodes are adjacent in time, so undoing the 24h wrap between
+    // neighbours makes the right ascension continuous
+    for (size_t k = 1; k < kNodes; ++k) {
+      ra[b][k] -= 24.0 * std::round((ra[b][k] - ra[b][k - 1]) / 24.0);
+    }
+    for (size_t c = 0; c < 3; ++c) {
+      auto& samples = c == 0 ? ra[b] : c == 1 ? dec[b] : distance[b];
+      // Samples are taken on whole milliseconds, up to half of one off
+      // their nodes, which is 0.4 mas of the Moon's motion. The slope of a
+      // first fit moves them back onto the nodes.
+      auto first = ChebyshevSeries::Fit(samples, 0.0, span_s);
+      const double h = span_s * 1e-3;  // Keeps t +- h inside the window
+      for (size_t k = 0; k < kNodes; ++k) {
+        double t = ChebyshevSeries::Node(k, kNodes, 0.0, span_s);
+        samples[k] -= (first(t + h) - first(t - h)) / (2.0 * h) * lag_s[k];
+      }
+      fit->series[b][c] = ChebyshevSeries::Fit(samples, 0.0, span_s);
+    }
+  }
+  ++fit_count_;
+  return fit;
+}
+
+void PlanetCache::Evaluate(const Observer& obs, int64_t time_ms,
+                           std::span<ApparentPlace> places) {
+  std::shared_ptr<const Fit> fit;
+  int64_t window_ms = 0;
+  uint64_t generation = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_ms = window_.count();
+    generation = generation_;
+
+    // Collect a finished background fit, and switch to it once the time
+    // reaches it. Past the current fit, wait for one still running rather
+    // than repeat its work.
+    bool covered = current_ && current_->Covers(obs, time_ms);
+    if (next_.valid() &&
+        (!covered || next_.wait_for(std::chrono::seconds(0)) ==
+                         std::future_status::ready)) {
+      auto next = next_.get();
+      if (next->generation == generation_) upcoming_ = std::move(next);
+    }
+    if (!(current_ && current_->Covers(obs, time_ms)) && upcoming_ &&
+        upcoming_->Covers(obs, time_ms)) {
+      current_ = std::move(upcoming_);
+    }
+    if (current_ && current_->Covers(obs, time_ms)) fit = current_;
+  }
+  if (window_ms <= 0) {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    sampler_(obs, std::span<const int64_t>(&time_ms, 1), places);
+    return;
+  }
+
+  if (!fit) {
+    // Outside every fit: a time jump, a sweep or a new observer
+    fit = MakeFit(obs, time_ms, window_ms, generation);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation == generation_) current_ = fit;
+  }
+
+  // Fit the next window before this one runs out
+  if (time_ms >= fit->end_ms - window_ms / 4) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool fitted = upcoming_ && upcoming_->start_ms == fit->end_ms;
+    if (!next_.valid() && !fitted && fit->generation == generation_) {
+      next_ = std::async(std::launch::async, [this, fit, window_ms] {
+        return MakeFit(fit->observer, fit->end_ms, window_ms,
+                       fit->generation);
+      });
+    }
+  }
+
+  const double t = static_cast<double>(time_ms - fit->start_ms) / 1000.0;
+  for (size_t b = 0; b < body_count_ && b < places.size(); ++b) {
+    if (!fit->valid[b]) {
+      places[b] = ApparentPlace{};
+      continue;
+    }
+    const auto& series = fit->series[b];
+    double ra = std::fmod(series[0](t), 24.0);
+    places[b] = ApparentPlace{.ra = ra < 0.0 ? ra + 24.0 : ra,
+                              .dec = series[1](t),
+                              .distance = series[2](t),
+                              .valid = true};
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,114 @@
+#ifndef ZENITH_FINDER_LIBENGINE_SRC_PLANET_CACHE_HPP_
+#define ZENITH_FINDER_LIBENGINE_SRC_PLANET_CACHE_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "chebyshev.hpp"
+#include "engine.hpp"
+
+namespace engine {
+
+// Apparent place of one solar system body for one observer.
+struct ApparentPlace {
+  double ra = 0.0;        // CIRS right ascension, hours
+  double dec = 0.0;       // CIRS declination, degrees
+  double distance = 0.0;  // AU
+  bool valid = false;     // False if the body could not be computed
+};
+
+// Chebyshev fits of the apparent places of a fixed set of bodies, for one
+// observer, over a window of time. A fit samples every body at kNodes
+// instants; evaluating it for any instant in the window then costs a few
+// multiply-adds per coordinate instead of a full ephemeris evaluation with
+// light-time iteration. The fit for the next window is built in the
+// background during the last quarter of the current one.
+//
+// Places are topocentric: the Moon's parallax alone is up to a degree, so
+// a fit is only used for observers within kObserverTolerance of the one it
+// was made for.
+class PlanetCache {
+ public:
+  // Fills places[t * body_count + b] with body b for the observer at
+  // times_ms[t] (Unix time, milliseconds). A fit asks for all its nodes in
+  // one call, so the sampler may compute them in parallel.
+  using Sampler =
+      std::function<void(const Observer& obs, std::span<const int64_t> times_ms,
+                         std::span<ApparentPlace> places)>;
+
+  // Samples per fit. Degree 9 keeps the Moon well under a milliarcsecond
+  // over windows up to kMaxWindow.
+  static constexpr size_t kNodes = 10;
+  static constexpr std::chrono::milliseconds kMaxWindow =
+      AstrometryEngine::kMaxPlanetCacheWindow;
+
+  // Largest observer move (degrees of latitude or longitude, or meters of
+  // altitude) that reuses a fit.
+  static constexpr double kObserverTolerance = 1e-4;
+  static constexpr double kAltitudeTolerance = 10.0;
+
+  PlanetCache(size_t body_count, Sampler sampler);
+
+  // Waits for a background fit.
+  ~PlanetCache();
+
+  PlanetCache(const PlanetCache&) = delete;
+  PlanetCache& operator=(const PlanetCache&) = delete;
+
+  // Length of each fitted window, clamped to [0, kMaxWindow]; zero
+  // disables the cache. Drops the fits.
+  void SetWindow(std::chrono::milliseconds window);
+  std::chrono::milliseconds window() const;
+
+  // Fits made so far, including background ones
+  uint64_t fit_count() const { return fit_count_.load(); }
+
+  // Drops every fit, e.g. because the sampler's ephemeris changed.
+  void Clear();
+
+  // Places of every body for `obs` at `time_ms`, from the fit covering that
+  // instant. Without one, a fit starting at `time_ms` is made first. With
+  // the cache disabled the sampler is called directly.
+  void Evaluate(const Observer& obs, int64_t time_ms,
+                std::span<ApparentPlace> places);
+
+ private:
+  struct Fit {
+    Observer observer;
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    uint64_t generation = 0;
+    std::vector<std::array<ChebyshevSeries, 3>> series;  // RA, Dec, distance
+    std::vector<bool> valid;
+
+    bool Covers(const Observer& obs, int64_t time_ms) const;
+  };
+
+  std::shared_ptr<const Fit> MakeFit(const Observer& obs, int64_t start_ms,
+                                     int64_t window_ms,
+                                     uint64_t generation) const;
+
+  const size_t body_count_;
+  const Sampler sampler_;
+  mutable std::mutex sample_mutex_;  // One sampler call at a time
+  mutable std::atomic<uint64_t> fit_count_{0};
+
+  mutable std::mutex mutex_;  // Guards everything below
+  std::chrono::milliseconds window_{0};
+  uint64_t generation_ = 0;  // Bumped by Clear; older fits are discarded
+  std::shared_ptr<const Fit> current_;
+  std::shared_ptr<const Fit> upcoming_;           // Fitted, not reached yet
+  std::future<std::shared_ptr<const Fit>> next_;  // Being fitted
+};
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_SRC_PLANET_CACHE_HPP_
@@ -0,0 +1,225 @@
+#ifndef ZENITH_FINDER_LIBENGINE_SRC_RESULT_PIPELINE_HPP_
+#define ZENITH_FINDER_LIBENGINE_SRC_RESULT_PIPELINE_HPP_
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "engine.hpp"
+#include "thread_pool.hpp"
+
+namespace engine {
+
+// Smallest slice of results worth handing to its own worker when sorting or
+// selecting the top entries of a page.
+constexpr size_t kMinSelectChunk = 4096;
+
+// Sorts `items` under `less` on the pool: slices are sorted concurrently and
+// then merged pairwise, each round of merges running concurrently.
+template <typename T, typename Less>
+void ParallelSort(std::vector<T>& items, Less less, ThreadPool& pool) {
+  size_t count = items.size();
+  size_t slice_count =
+      std::clamp<size_t>(count / kMinSelectChunk, 1, pool.size());
+  if (slice_count == 1) {
+    std::sort(items.begin(), items.end(), less);
+    return;
+  }
+
+  size_t slice = (count + slice_count - 1) / slice_count;
+  pool.ParallelFor(slice_count, 1, [&](size_t s) {
+    auto begin = items.begin() + s * slice;
+    auto end = items.begin() + std::min(count, (s + 1) * slice);
+    std::sort(begin, end, less);
+  });
+
+  for (size_t width = slice; width < count; width *= 2) {
+    size_t pairs = (count + 2 * width - 1) / (2 * width);
+    pool.ParallelFor(pairs, 1, [&](size_t p) {
+      size_t first = p * 2 * width;
+      size_t middle = std::min(count, first + width);
+      size_t last = std::min(count, first + 2 * width);
+      if (middle < last) {
+        std::inplace_merge(items.begin() + first, items.begin() + middle,
+                           items.begin() + last, less);
+      }
+    });
+  }
+}
+
+// Reorders `items` so that its first k entries are the k smallest under
+// `less`, in order, and drops the rest. `less` must be a strict total order
+// (break ties explicitly) so the selection is deterministic.
+//
+// Large inputs are split into per-worker slices that each keep their own
+// best k with nth_element; the survivors are gathered and selected again.
+template <typename T, typename Less>
+void SelectTop(std::vector<T>& items, size_t k, Less less, ThreadPool& pool) {
+  size_t count = items.size();
+  if (k >= count) {
+    ParallelSort(items, less, pool);
+    return;
+  }
+
+  size_t slice_count = std::clamp<size_t>(
+      count / std::max(4 * k, kMinSelectChunk), 1, pool.size());
+
+  if (slice_count > 1) {
+    size_t slice = (count + slice_count - 1) / slice_count;
+    pool.ParallelFor(slice_count, 1, [&](size_t s) {
+      auto begin = items.begin() + s * slice;
+      auto end = items.begin() + std::min(count, (s + 1) * slice);
+      if (static_cast<size_t>(end - begin) > k) {
+        std::nth_element(begin, begin + k, end, less);
+      }
+    });
+
+    // Gather every slice's best k at the front
+    size_t gathered = 0;
+    for (size_t s = 0; s < slice_count; ++s) {
+      size_t begin = s * slice;
+      size_t kept = std::min(k, std::min(count, begin + slice) - begin);
+      if (begin != gathered) {
+        std::move(items.begin() + begin, items.begin() + begin + kept,
+                  items.begin() + gathered);
+      }
+      gathered += kept;
+    }
+    count = gathered;
+  }
+
+  std::nth_element(items.begin(), items.begin() + k, items.begin() + count,
+                   less);
+  std::sort(items.begin(), items.begin() + k, less);
+  items.erase(items.begin() + k, items.end());
+}
+
+// Keeps the page [offset, offset + limit) of results in their current
+// order. A zero limit keeps everything from the offset on.
+template <typename T>
+void Paginate(std::vector<T>& results, size_t offset, size_t limit) {
+  if (offset >= results.size() && (offset > 0 || limit > 0)) {
+    results.clear();
+    return;
+  }
+  if (limit > 0 && limit < results.size() - offset) {
+    results.erase(results.begin() + offset + limit, results.end());
+  }
+  if (offset > 0) {
+    std::move(results.begin() + offset, results.end(), results.begin());
+    results.erase(results.end() - offset, results.end());
+  }
+}
+
+// Sorts results under `less` and keeps the page [offset, offset + limit).
+// A zero limit keeps everything from the offset on. When a limit is set only
+// the first offset + limit entries are ever fully ordered.
+template <typename T, typename Less>
+void SortAndPaginate(std::vector<T>& results, size_t offset, size_t limit,
+                     Less less, ThreadPool& pool) {
+  if (offset < results.size()) {
+    // A huge limit means everything; offset + limit must not wrap
+    size_t wanted = limit > 0 && limit < results.size() - offset
+                        ? offset + limit
+                        : results.size();
+    SelectTop(results, wanted, less, pool);
+  }
+  Paginate(results, offset, limit);
+}
+
+// Lowercased name filter, or an empty string when names are not filtered.
+inline std::string LowercaseNameFilter(const FilterCriteria& filter) {
+  if (!filter.active) return {};
+  std::string lower = filter.name_filter;
+  std::ranges::transform(lower, lower.begin(),
+                         [](unsigned char c) { return std::tolower(c); });
+  return lower;
+}
+
+// Elevation and azimuth predicate shared by every body type. Without an
+// active filter only objects above the horizon pass.
+inline bool PassesBand(const FilterCriteria& filter, double el, double az) {
+  if (filter.active) {
+    if (el < filter.min_elevation || el > filter.max_elevation) return false;
+    if (az < filter.min_azimuth || az > filter.max_azimuth) return false;
+    return true;
+  }
+  return el >= 0;
+}
+
+// Sort keys per result type. Columns a type does not carry compare equal and
+// fall through to catalog order.
+inline double SortKey(const CelestialResult& res, SortColumn column) {
+  switch (column) {
+    case SortColumn::ELEVATION:
+      return res.elevation;
+    case SortColumn::AZIMUTH:
+      return res.azimuth;
+    case SortColumn::MAGNITUDE:
+      return static_cast<double>(res.magnitude);
+    case SortColumn::ZENITH:
+      return res.zenith_dist;
+    case SortColumn::STATE:
+      return static_cast<double>(res.is_rising);
+    default:
+      return 0.0;
+  }
+}
+
+inline double SortKey(const SolarBody& res, SortColumn column) {
+  switch (column) {
+    case SortColumn::ELEVATION:
+      return res.elevation;
+    case SortColumn::AZIMUTH:
+      return res.azimuth;
+    case SortColumn::ZENITH:
+      return res.zenith_dist;
+    case SortColumn::DISTANCE:
+      return res.distance_au;
+    case SortColumn::STATE:
+      return static_cast<double>(res.is_rising);
+    default:
+      return 0.0;
+  }
+}
+
+// Strict total order for a SortCriteria: the sort column, then the position
+// in the catalog the result came from. Results without a value in the
+// column come after all others.
+template <typename T>
+auto ResultLess(const SortCriteria& sort) {
+  return [sort](const T& a, const T& b) {
+    if (sort.column == SortColumn::NAME && a.name != b.name) {
+      return sort.ascending ? (a.name < b.name) : (b.name < a.name);
+    }
+    double val_a = SortKey(a, sort.column);
+    double val_b = SortKey(b, sort.column);
+    // Missing keys, such as NaN magnitudes, go last in either direction
+    if (std::isnan(val_a) != std::isnan(val_b)) return std::isnan(val_b);
+    if (val_a != val_b && !std::isnan(val_a)) {
+      return sort.ascending ? (val_a < val_b) : (val_b < val_a);
+    }
+    return a.catalog_index < b.catalog_index;
+  };
+}
+
+// Sorts results of any type under `sort` and keeps one page of them.
+// SortColumn::NONE keeps catalog order, selecting only the page's prefix.
+template <typename T>
+void SortAndPaginate(std::vector<T>& results, const SortCriteria& sort,
+                     size_t offset, size_t limit, ThreadPool& pool) {
+  if (sort.column == SortColumn::NONE) {
+    auto in_catalog_order = [](const T& a, const T& b) {
+      return a.catalog_index < b.catalog_index;
+    };
+    SortAndPaginate(results, offset, limit, in_catalog_order, pool);
+    return;
+  }
+  SortAndPaginate(results, offset, limit, ResultLess<T>(sort), pool);
+}
+
+}  // namespace engine
+
+#endif  // ZENITH_FINDER_LIBENGINE_SRC_RESULT_PIPELINE_HPP_
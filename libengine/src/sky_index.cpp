@@ -0,0 +1,207 @@
+#include "sky_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "constants.hpp"
+
+namespace engine {
+
+namespace {
+// Spreads the low 16 bits of v to the even bit positions.
+uint32_t SpreadBits(uint32_t v) {
+  v &= 0x0000ffff;
+  v = (v | (v << 8)) & 0x00ff00ff;
+  v = (v | (v << 4)) & 0x0f0f0f0f;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+double AngleBetween(const SkyVector& a, const SkyVector& b) {
+  return std::acos(std::clamp(a.Dot(b), -1.0, 1.0));
+}
+}  // namespace
+
+SkyVector SkyVector::FromRaDec(double ra_deg, double dec_deg) {
+  double ra = ra_deg * kDegToRad;
+  double dec = dec_deg * kDegToRad;
+  return {std::cos(dec) * std::cos(ra), std::cos(dec) * std::sin(ra),
+          std::sin(dec)};
+}
+
+uint32_t SkyIndex::TileOf(const SkyVector& v, int depth) {
+  // HEALPix ang2pix in the nested scheme (Gorski et al. 2005).
+  const int32_t nside = 1 << depth;
+  double norm = std::sqrt(v.Dot(v));
+  double z = norm > 0.0 ? v.z / norm : 1.0;
+  double za = std::abs(z);
+  double phi = std::atan2(v.y, v.x);
+  if (phi < 0.0) phi += 2.0 * std::numbers::pi;
+  double tt = std::fmod(phi / (0.5 * std::numbers::pi), 4.0);  // [0, 4)
+
+  int32_t face, ix, iy;
+  if (za <= 2.0 / 3.0) {
+    // Equatorial region
+    double temp1 = nside * (0.5 + tt);
+    double temp2 = nside * (z * 0.75);
+    int32_t jp = static_cast<int32_t>(temp1 - temp2);  // Ascending edge
+    int32_t jm = static_cast<int32_t>(temp1 + temp2);  // Descending edge
+    int32_t ifp = jp >> depth;
+    int32_t ifm = jm >> depth;
+    face = (ifp == ifm) ? (ifp | 4) : ((ifp < ifm) ? ifp : (ifm + 8));
+    ix = jm & (nside - 1);
+    iy = nside - (jp & (nside - 1)) - 1;
+  } else {
+    // Polar caps
+    int32_t ntt = std::min(3, static_cast<int32_t>(tt));
+    double tp = tt - ntt;
+    double tmp = nside * std::sqrt(3.0 * (1.0 - za));
+    int32_t jp = std::min(static_cast<int32_t>(tp * tmp), nside - 1);
+    int32_t jm = std::min(static_cast<int32_t>((1.0 - tp) * tmp), nside - 1);
+    if (z >= 0) {
+      face = ntt;
+      ix = nside - jm - 1;
+      iy = nside - jp - 1;
+    } else {
+      face = ntt + 8;
+      ix = jp;
+      iy = jm;
+    }
+  }
+
+  return (static_cast<uint32_t>(face) << (2 * depth)) +
+         (SpreadBits(ix) | (SpreadBits(iy) << 1));
+}
+
+void SkyIndex::Build(std::span<const double> x, std::span<const double> y,
+                     std::span<const double> z, int depth) {
+  depth_ = std::clamp(depth, 0, kMaxDepth);
+  const size_t count = x.size();
+  const uint32_t leaf_count = TileCount(depth_);
+
+  // Counting sort of the members by leaf tile keeps the original order
+  // within each tile.
+  std::vector<uint32_t> tiles(count);
+  offsets_.assign(leaf_count + 1, 0);
+  for (size_t i = 0; i < count; ++i) {
+    tiles[i] = TileOf({x[i], y[i], z[i]}, depth_);
+    ++offsets_[tiles[i] + 1];
+  }
+  for (uint32_t t = 0; t < leaf_count; ++t) {
+    offsets_[t + 1] += offsets_[t];
+  }
+
+  order_.resize(count);
+  std::vector<uint32_t> cursor(offsets_.begin(), offsets_.end() - 1);
+  for (size_t i = 0; i < count; ++i) {
+    order_[cursor[tiles[i]]++] = static_cast<uint32_t>(i);
+  }
+
+  // Bounding caps at every level, centered on the members' mean direction.
+  caps_.assign(depth_ + 1, {});
+  for (int level = 0; level <= depth_; ++level) {
+    int shift = 2 * (depth_ - level);
+    auto& caps = caps_[level];
+    caps.resize(TileCount(level));
+
+    for (uint32_t tile = 0; tile < caps.size(); ++tile) {
+      uint32_t begin = offsets_[tile << shift];
+      uint32_t end = offsets_[(tile + 1) << shift];
+      if (begin == end) {
+        caps[tile] = SkyCap{{0.0, 0.0, 1.0}, -1.0};
+        continue;
+      }
+
+      SkyVector sum{0.0, 0.0, 0.0};
+      for (uint32_t k = begin; k < end; ++k) {
+        uint32_t i = order_[k];
+        sum.x += x[i];
+        sum.y += y[i];
+        sum.z += z[i];
+      }
+      double norm = std::sqrt(sum.Dot(sum));
+      SkyVector center = norm > 0.0
+                             ? SkyVector{sum.x / norm, sum.y / norm,
+                                         sum.z / norm}
+                             : SkyVector{x[order_[begin]], y[order_[begin]],
+                                         z[order_[begin]]};
+
+      double radius = 0.0;
+      for (uint32_t k = begin; k < end; ++k) {
+        uint32_t i = order_[k];
+        radius = std::max(radius, AngleBetween(center, {x[i], y[i], z[i]}));
+      }
+      caps[tile] = SkyCap{center, radius};
+    }
+  }
+}
+
+std::vector<SkyCap> SkyIndex::caps() const {
+  std::vector<SkyCap> all;
+  for (const auto& level : caps_) {
+    all.insert(all.end(), level.begin(), level.end());
+  }
+  return all;
+}
+
+bool SkyIndex::Restore(int depth, std::span<const uint32_t> order,
+                       std::span<const uint32_t> offsets,
+                       std::span<const SkyCap> caps) {
+  if (depth < 0 || depth > kMaxDepth) return false;
+  if (offsets.size() != TileCount(depth) + size_t{1} || offsets.front() != 0 ||
+      offsets.back() != order.size()) {
+    return false;
+  }
+  for (size_t t = 0; t + 1 < offsets.size(); ++t) {
+    if (offsets[t] > offsets[t + 1]) return false;
+  }
+  for (uint32_t i : order) {
+    if (i >= order.size()) return false;
+  }
+  size_t cap_count = 0;
+  for (int level = 0; level <= depth; ++level) cap_count += TileCount(level);
+  if (caps.size() != cap_count) return false;
+
+  depth_ = depth;
+  order_.assign(order.begin(), order.end());
+  offsets_.assign(offsets.begin(), offsets.end());
+  caps_.assign(depth + 1, {});
+  for (int level = 0; level <= depth; ++level) {
+    caps_[level].assign(caps.begin(), caps.begin() + TileCount(level));
+    caps = caps.subspan(TileCount(level));
+  }
+  return true;
+}
+
+void SkyIndex::QueryAnnulus(const SkyVector& axis, double min_angle,
+                            double max_angle,
+                            std::vector<SkyRange>& out) const {
+  QueryRegion(
+      [&](const SkyCap& cap) {
+        double distance = AngleBetween(axis, cap.center);
+        if (distance - cap.radius > max_angle ||
+            distance + cap.radius < min_angle) {
+          return SkyOverlap::NONE;
+        }
+        if (distance + cap.radius <= max_angle &&
+            distance - cap.radius >= min_angle) {
+          return SkyOverlap::FULL;
+        }
+        return SkyOverlap::PARTIAL;
+      },
+      out);
+}
+
+void SkyIndex::Append(uint32_t begin, uint32_t end,
+                      std::vector<SkyRange>& out) {
+  if (begin == end) return;
+  if (!out.empty() && out.back().end == begin) {
+    out.back().end = end;
+  } else {
+    out.push_back({begin, end});
+  }
+}
+
+}  // namespace engine
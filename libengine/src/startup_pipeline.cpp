@@ -0,0 +1,195 @@
+#include "startup_pipeline.hpp"
+
+#include <future>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+#include "binary_catalog.hpp"
+#include "catalog_loader.hpp"
+#include "ephemeris_preloader.hpp"
+
+namespace engine {
+
+namespace {
+
+// The opened ephemeris and, if enabled, its preloader.
+struct LoadedEphemeris {
+  std::shared_ptr<t_calcephbin> handle;
+  std::shared_ptr<EphemerisPreloader> preloader;
+};
+
+}  // namespace
+
+StartupPipeline::StartupPipeline(StartupOptions options,
+                                 PublishCallback publish)
+    : options_(std::move(options)),
+      publish_(std::move(publish)),
+      start_(std::chrono::steady_clock::now()) {
+  thread_ = std::thread(&StartupPipeline::Run, this);
+}
+
+StartupPipeline::~StartupPipeline() {
+  cancel_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void StartupPipeline::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_.wait(lock, [&] {
+    StartupStage stage = stage_.load();
+    return stage == StartupStage::COMPLETE || stage == StartupStage::FAILED;
+  });
+}
+
+StartupTimings StartupPipeline::timings() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return timings_;
+}
+
+std::shared_ptr<AstrometryEngine> StartupPipeline::MakeEngine() const {
+  auto engine = std::make_shared<AstrometryEngine>();
+  engine->SetThreadPool(options_.pool, options_.grain);
+  engine->SetCatalogStorage(options_.storage);
+  engine->SetSolarSystemMode(options_.solar_system);
+  engine->SetPlanetCacheWindow(options_.planet_cache_window);
+  return engine;
+}
+
+void StartupPipeline::Mark(double StartupTimings::*milestone) {
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start_;
+  std::lock_guard<std::mutex> lock(mutex_);
+  timings_.*milestone = elapsed.count();
+}
+
+void StartupPipeline::Publish(std::shared_ptr<const AstrometryEngine> engine,
+                              StartupStage stage) {
+  if (stage == StartupStage::BRIGHT_READY) {
+    Mark(&StartupTimings::bright_ready_ms);
+  } else if (stage == StartupStage::COMPLETE) {
+    Mark(&StartupTimings::complete_ms);
+  }
+
+  // The receiver has the engine by the time Wait returns
+  publish_(std::move(engine), stage);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage_ = stage;
+  }
+  finished_.notify_all();
+}
+
+void StartupPipeline::Run() {
+  ThreadPool& pool = options_.pool ? *options_.pool : ThreadPool::Default();
+
+  // 1. Open the ephemeris, and read the span around now, while the catalog
+  // loads
+  std::shared_future<LoadedEphemeris> ephemeris =
+      std::async(std::launch::async, [this] {
+        LoadedEphemeris ephemeris;
+        if (!options_.ephemeris_path.empty() &&
+            options_.solar_system == SolarSystemMode::EPHEMERIS) {
+          ephemeris.handle = CatalogLoader::LoadFromEphemeris(
+              options_.ephemeris_path, options_.prefetch_ephemeris);
+        }
+        if (ephemeris.handle && options_.ephemeris_preload.count() > 0) {
+          ephemeris.preloader = EphemerisPreloader::Open(
+              options_.ephemeris_path, options_.ephemeris_preload);
+          if (ephemeris.preloader) {
+            ephemeris.preloader->Preload(std::chrono::system_clock::now());
+          }
+        }
+        Mark(&StartupTimings::ephemeris_ready_ms);
+        return ephemeris;
+      }).share();
+
+  // The bright engine does not wait for the ephemeris: it gets one only if
+  // it is already open, and the complete engine always does.
+  auto publish = [&](std::shared_ptr<AstrometryEngine> engine,
+                     StartupStage stage) {
+    bool ready = stage == StartupStage::COMPLETE ||
+                 ephemeris.wait_for(std::chrono::seconds(0)) ==
+                     std::future_status::ready;
+    if (ready && ephemeris.get().handle) {
+      engine->SetEphemeris(ephemeris.get().handle);
+      engine->SetEphemerisPreloader(ephemeris.get().preloader);
+    }
+    Publish(std::move(engine), stage);
+  };
+
+  // 2. Restore the engine snapshot of this exact file, if still current
+  std::optional<uint64_t> catalog_key;
+  if (!options_.snapshot_path.empty() &&
+      options_.storage != CatalogStorage::MAPPED) {
+    catalog_key = CatalogLoader::HashCatalogFile(options_.catalog_path, pool);
+  }
+  if (catalog_key) {
+    auto engine = MakeEngine();
+    if (engine->LoadSnapshot(options_.snapshot_path, *catalog_key,
+                             options_.filter)) {
+      Mark(&StartupTimings::catalog_loaded_ms);
+      publish(std::move(engine), StartupStage::COMPLETE);
+      return;
+    }
+  }
+
+  // 3. Load the catalog. Engines copy what they need into their own arena,
+  // so the loaded stars only live as long as the pipeline's thread.
+  const auto& path = options_.catalog_path;
+  std::vector<Star> catalog;
+  std::shared_ptr<const BinaryCatalog> binary_catalog;
+  size_t star_count = 0;
+  if (path.extension() == ".zcat") {
+    binary_catalog = CatalogLoader::OpenBinaryCatalog(path);
+    star_count = binary_catalog ? binary_catalog->size() : 0;
+  } else if (path.extension() == ".json") {
+    catalog = CatalogLoader::LoadStarDataFromJSON(path, options_.filter);
+    star_count = catalog.size();
+  } else if (path.extension() == ".csv") {
+    catalog = CatalogLoader::LoadStarDataFromCSV(path, options_.filter,
+                                                 /*bad_rows=*/nullptr, pool);
+    star_count = catalog.size();
+  }
+
+  if (star_count == 0) {
+    std::cerr << "Error: Could not load catalog from " << path << std::endl;
+    Publish(nullptr, StartupStage::FAILED);
+    return;
+  }
+  Mark(&StartupTimings::catalog_loaded_ms);
+  if (cancel_) return;
+
+  auto build = [&](const CatalogFilter& filter) {
+    auto engine = MakeEngine();
+    if (binary_catalog) {
+      engine->SetCatalog(binary_catalog, filter);
+    } else {
+      // Already filtered; passing the filter records it in the snapshot
+      engine->SetCatalog(catalog, filter);
+    }
+    return engine;
+  };
+
+  // 4. Bright stars first. A mapped catalog builds nothing, so it has
+  // nothing to gain.
+  if (options_.storage != CatalogStorage::MAPPED &&
+      star_count >= options_.progressive_stars &&
+      options_.filter.max_magnitude > options_.bright_magnitude) {
+    CatalogFilter bright = options_.filter;
+    bright.max_magnitude = options_.bright_magnitude;
+    publish(build(bright), StartupStage::BRIGHT_READY);
+    if (cancel_) return;
+  }
+
+  // 5. The whole catalog
+  auto engine = build(options_.filter);
+  if (catalog_key) {
+    engine->SaveSnapshot(options_.snapshot_path, *catalog_key);
+  }
+  publish(std::move(engine), StartupStage::COMPLETE);
+}
+
+}  // namespace engine
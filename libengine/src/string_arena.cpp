@@ -0,0 +1,38 @@
+#include "string_arena.hpp"
+
+#include <algorithm>
+
+namespace engine {
+
+char* StringArena::Allocate(size_t size) {
+  bytes_ += size;
+  if (size > block_size_ / 4) {
+    // Large runs get their own block so the current one is not wasted
+    blocks_.push_back(std::make_unique_for_overwrite<char[]>(size));
+    return blocks_.back().get();
+  }
+  if (size > remaining_) {
+    blocks_.push_back(std::make_unique_for_overwrite<char[]>(block_size_));
+    cursor_ = blocks_.back().get();
+    remaining_ = block_size_;
+  }
+  char* start = cursor_;
+  cursor_ += size;
+  remaining_ -= size;
+  return start;
+}
+
+std::string_view StringArena::Store(std::string_view value) {
+  if (value.empty()) return {};
+  char* start = Allocate(value.size());
+  std::copy(value.begin(), value.end(), start);
+  return {start, value.size()};
+}
+
+std::string_view StringArena::Intern(std::string_view value) {
+  auto it = dictionary_.find(value);
+  if (it != dictionary_.end()) return *it;
+  return *dictionary_.insert(Store(value)).first;
+}
+
+}  // namespace engine
@@ -0,0 +1,182 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace engine {
+
+namespace {
+// Pool and queue of the current thread when it is a pool worker
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_queue = 0;
+
+bool PinThread(std::thread& thread, int cpu) {
+  if (cpu < 0) return false;
+#if defined(_WIN32)
+  if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) return false;
+  return SetThreadAffinityMask(thread.native_handle(),
+                               DWORD_PTR{1} << cpu) != 0;
+#elif defined(__linux__)
+  if (cpu >= CPU_SETSIZE) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) ==
+         0;
+#else
+  (void)thread;
+  return false;
+#endif
+}
+}  // namespace
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options) {
+  size_t threads = options.threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  queue_count_ = threads + 1;
+  queues_ = std::make_unique<Queue[]>(queue_count_);
+
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+    if (!options.cpus.empty()) {
+      int cpu = options.cpus[i % options.cpus.size()];
+      if (!PinThread(workers_.back(), cpu)) {
+        std::cerr << "Warning: Could not pin engine worker " << i
+                  << " to CPU " << cpu << std::endl;
+      }
+    }
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+ThreadPool& ThreadPool::Default() {
+  static ThreadPool pool;
+  return pool;
+}
+
+size_t ThreadPool::CallerQueue() const {
+  return tls_pool == this ? tls_queue : queue_count_ - 1;
+}
+
+void ThreadPool::Run(Job& job, size_t count) {
+  job.remaining.store(count, std::memory_order_relaxed);
+  size_t queue = CallerQueue();
+  Push(queue, {&job, 0, count});
+
+  // A worker keeps the pool busy while it waits, so nested loops cannot
+  // starve it. Anyone else just sleeps.
+  if (tls_pool == this) {
+    while (job.remaining.load(std::memory_order_acquire) != 0) {
+      if (!TryRunOne(queue)) std::this_thread::yield();
+    }
+  }
+
+  // Also wait for the last finisher to release the job
+  std::unique_lock<std::mutex> lock(job.mutex);
+  job.finished.wait(lock, [&] { return job.done; });
+}
+
+void ThreadPool::Push(size_t queue, const Task& task) {
+  {
+    std::lock_guard<std::mutex> lock(queues_[queue].mutex);
+    queues_[queue].tasks.push_back(task);
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+
+  // Taking the sleep mutex orders the push before any worker's predicate
+  // check, so the wake-up cannot be lost.
+  { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+  wake_.notify_one();
+}
+
+bool ThreadPool::TryRunOne(size_t index) {
+  std::optional<Task> task;
+
+  // Own queue first, newest task (most likely still in cache)
+  if (index < size()) {
+    std::lock_guard<std::mutex> lock(queues_[index].mutex);
+    auto& tasks = queues_[index].tasks;
+    if (!tasks.empty()) {
+      task = tasks.back();
+      tasks.pop_back();
+    }
+  }
+
+  // Then steal the oldest (largest) task from the others
+  for (size_t k = 1; !task && k <= queue_count_; ++k) {
+    size_t victim = (index + k) % queue_count_;
+    if (victim == index) continue;
+    std::lock_guard<std::mutex> lock(queues_[victim].mutex);
+    auto& tasks = queues_[victim].tasks;
+    if (!tasks.empty()) {
+      task = tasks.front();
+      tasks.pop_front();
+    }
+  }
+
+  if (!task) return false;
+  queued_.fetch_sub(1, std::memory_order_acq_rel);
+  Execute(*task, index);
+  return true;
+}
+
+void ThreadPool::Execute(Task task, size_t index) {
+  Job& job = *task.job;
+
+  // Split off upper halves for thieves until the range fits the grain
+  while (task.end - task.begin > job.grain) {
+    size_t mid = task.begin + (task.end - task.begin) / 2;
+    Push(index, {&job, mid, task.end});
+    task.end = mid;
+  }
+
+  job.run(job.context, task.begin, task.end);
+
+  size_t ran = task.end - task.begin;
+  if (job.remaining.fetch_sub(ran, std::memory_order_acq_rel) == ran) {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.done = true;
+    job.finished.notify_all();
+  }
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  tls_pool = this;
+  tls_queue = index;
+
+  while (true) {
+    if (TryRunOne(index)) continue;
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [&] {
+      return stop_ || queued_.load(std::memory_order_acquire) > 0;
+    });
+    if (stop_ && queued_.load(std::memory_order_acquire) == 0) return;
+  }
+}
+
+}  // namespace engine
@@ -1,11 +1,18 @@
+#include <algorithm>
 #include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <thread>
 #include <vector>
 
+#include "catalog_loader.hpp"
 #include "engine.hpp"
 
 using namespace engine;
@@ -53,6 +60,25 @@ std::vector<Star> GenerateMockCatalog(size_t count) {
   return catalog;
 }
 
+// Writes a SIMBAD-style JSON export with the given number of rows
+void WriteMockJSONCatalog(const std::filesystem::path& path, size_t count) {
+  std::mt19937 gen(42);  // Fixed seed
+  std::uniform_real_distribution<double> ra_dist(0.0, 360.0);
+  std::uniform_real_distribution<double> dec_dist(-90.0, 90.0);
+  std::uniform_real_distribution<float> mag_dist(-1.5f, 10.0f);
+
+  std::ofstream file(path);
+  file << std::setprecision(15) << "{\"data\": [\n";
+  for (size_t i = 0; i < count; ++i) {
+    file << (i ? ",\n" : "") << "[\"* mock " << i << "\", " << ra_dist(gen)
+         << ", " << dec_dist(gen) << ", \"A\", -546.01, -1223.07, \"A\", "
+         << "379.21, \"A\", -5.5, \"A\", " << mag_dist(gen)
+         << ", null, \"C\", \"NAME Mock " << i << "|HIP " << i
+         << "|HD " << i << "|TYC 5949-2777-1|2MASS J06450887-1642566\"]";
+  }
+  file << "\n]}\n";
+}
+
 struct BenchResult {
   size_t count;
   long long set_catalog_ms;
@@ -72,6 +98,10 @@ BenchResult RunBenchmark(AstrometryEngine& engine, ResultBuffer& buffer,
   engine.SetCatalog(catalog);
   auto end_set = std::chrono::high_resolution_clock::now();
 
+  // The first tick after a catalog change builds the visibility table and
+  // grows the buffer's scratch; measure the steady state that follows.
+  engine.CalculateZenithProximity(buffer, obs, {}, {}, time);
+
   // Reset allocation counters and start tracking
   g_alloc_count = 0;
   g_alloc_bytes = 0;
@@ -137,3 +167,117 @@ TEST_CASE("Engine Performance Benchmarking", "[.benchmark]") {
     std::cout << std::string(80, '=') << "\n" << std::endl;
   }
 }
+
+TEST_CASE("Catalog Loading Benchmarking", "[.benchmark]") {
+  const std::filesystem::path path = "benchmark_catalog.json";
+  std::vector<size_t> sizes = {10000, 100000, 500000};
+
+  std::cout << "\n" << std::string(80, '=') << "\n";
+  std::cout << " JSON CATALOG LOADING BENCHMARKS (STREAMING)\n";
+  std::cout << std::string(80, '-') << "\n";
+  std::cout << std::left << std::setw(10) << "Stars" << std::setw(12)
+            << "File (MB)" << std::setw(12) << "Load (ms)" << std::setw(12)
+            << "MB/s" << std::setw(12) << "Allocs" << std::setw(12)
+            << "Memory (MB)" << "\n";
+  std::cout << std::string(80, '-') << "\n";
+
+  for (size_t size : sizes) {
+    WriteMockJSONCatalog(path, size);
+    double file_mb = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+    g_alloc_count = 0;
+    g_alloc_bytes = 0;
+    g_track_allocs = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    auto catalog = CatalogLoader::LoadStarDataFromJSON(path);
+    auto end = std::chrono::high_resolution_clock::now();
+    g_track_allocs = false;
+
+    REQUIRE(catalog.size() == size);
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << std::left << std::setw(10) << size << std::setw(12)
+              << std::fixed << std::setprecision(1) << file_mb << std::setw(12)
+              << ms << std::setw(12) << file_mb / (ms / 1000.0)
+              << std::setw(12) << g_alloc_count.load() << std::setw(12)
+              << g_alloc_bytes.load() / (1024.0 * 1024.0) << "\n"
+              << std::defaultfloat;
+  }
+  std::filesystem::remove(path);
+
+  std::cout << "\n* Note: 'Memory' is the total allocated while loading, "
+               "not the peak.\n";
+  std::cout << std::string(80, '=') << "\n" << std::endl;
+}
+
+TEST_CASE("Solar System Scaling Benchmarking", "[.benchmark]") {
+  using namespace std::chrono;
+  Observer obs{37.7749, -122.4194, 0.0};  // San Francisco
+  auto start = system_clock::now();
+  constexpr int kTicks = 200;
+  constexpr int kFits = 20;
+
+  // A prefetched ephemeris if ZENITH_EPHEMERIS names one, else the analytic
+  // NOVAS models; both allow concurrent lookups
+  std::shared_ptr<t_calcephbin> ephemeris;
+  if (const char* path = std::getenv("ZENITH_EPHEMERIS")) {
+    ephemeris = CatalogLoader::LoadFromEphemeris(path, /*prefetch=*/true);
+  }
+
+  std::cout << "\n" << std::string(80, '=') << "\n";
+  std::cout << " SOLAR SYSTEM SCALING BENCHMARKS ("
+            << (ephemeris ? "prefetched ephemeris" : "no ephemeris") << ")\n";
+  std::cout << std::string(80, '-') << "\n";
+  std::cout << std::left << std::setw(10) << "Threads" << std::setw(15)
+            << "Tick (us)" << std::setw(15) << "Speedup" << std::setw(15)
+            << "Refit (ms)" << std::setw(15) << "Speedup" << "\n";
+  std::cout << std::string(80, '-') << "\n";
+
+  ResultBuffer buffer;
+  double base_tick_us = 0.0, base_fit_ms = 0.0;
+  size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= hardware; threads *= 2) {
+    auto pool = std::make_shared<ThreadPool>(
+        ThreadPoolOptions{.threads = threads});
+
+    // Every body evaluated on every tick
+    AstrometryEngine engine;
+    engine.SetThreadPool(pool);
+    if (ephemeris) engine.SetEphemeris(ephemeris);
+    engine.CalculateSolarSystem(buffer, obs, {}, {}, start);  // Warm up
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < kTicks; ++i) {
+      engine.CalculateSolarSystem(buffer, obs, {}, {}, start + seconds(i));
+    }
+    double tick_us =
+        duration<double, std::micro>(steady_clock::now() - t0).count() /
+        kTicks;
+
+    // Planet cache fits: every call lands in a new window, so each one
+    // samples all bodies at every node
+    AstrometryEngine cached;
+    cached.SetThreadPool(pool);
+    if (ephemeris) cached.SetEphemeris(ephemeris);
+    cached.SetPlanetCacheWindow(hours(1));
+    t0 = steady_clock::now();
+    for (int i = 0; i < kFits; ++i) {
+      cached.CalculateSolarSystem(buffer, obs, {}, {}, start + hours(2 * i));
+    }
+    double fit_ms =
+        duration<double, std::milli>(steady_clock::now() - t0).count() /
+        kFits;
+
+    if (threads == 1) {
+      base_tick_us = tick_us;
+      base_fit_ms = fit_ms;
+    }
+    std::cout << std::left << std::setw(10) << threads << std::fixed
+              << std::setprecision(1) << std::setw(15) << tick_us
+              << std::setw(15) << base_tick_us / tick_us << std::setw(15)
+              << std::setprecision(2) << fit_ms << std::setw(15)
+              << std::setprecision(1) << base_fit_ms / fit_ms << "\n"
+              << std::defaultfloat;
+  }
+  std::cout << "\n* 'Refit' is one planet cache window: 10 samples of "
+               "every body.\n";
+  std::cout << std::string(80, '=') << "\n" << std::endl;
+}
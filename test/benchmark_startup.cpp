@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "catalog_loader.hpp"
+#include "engine.hpp"
+#include "startup_pipeline.hpp"
+
+using namespace engine;
+
+namespace {
+
+// Writes a SIMBAD-style JSON export with the given number of rows
+void WriteMockJSONCatalog(const std::filesystem::path& path, size_t count) {
+  std::mt19937 gen(42);  // Fixed seed
+  std::uniform_real_distribution<double> ra_dist(0.0, 360.0);
+  std::uniform_real_distribution<double> dec_dist(-90.0, 90.0);
+  std::uniform_real_distribution<float> mag_dist(-1.5f, 12.0f);
+
+  std::ofstream file(path);
+  file << std::setprecision(15) << "{\"data\": [\n";
+  for (size_t i = 0; i < count; ++i) {
+    file << (i ? ",\n" : "") << "[\"* mock " << i << "\", " << ra_dist(gen)
+         << ", " << dec_dist(gen) << ", \"A\", -546.01, -1223.07, \"A\", "
+         << "379.21, \"A\", -5.5, \"A\", " << mag_dist(gen)
+         << ", null, \"C\", \"NAME Mock " << i << "|HIP " << i << "\"]";
+  }
+  file << "\n]}\n";
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+TEST_CASE("Startup Time-to-First-Result Benchmarking", "[.benchmark]") {
+  const std::filesystem::path path = "benchmark_startup.json";
+  Observer obs{37.7749, -122.4194, 0.0};  // San Francisco
+  auto now = std::chrono::system_clock::now();
+  std::vector<size_t> sizes = {100000, 500000, 1000000};
+
+  std::cout << "\n" << std::string(80, '=') << "\n";
+  std::cout << " STARTUP BENCHMARKS (TIME TO FIRST RESULT)\n";
+  std::cout << std::string(80, '-') << "\n";
+  std::cout << std::left << std::setw(10) << "Stars" << std::setw(14)
+            << "Blocking" << std::setw(14) << "Loaded" << std::setw(14)
+            << "First" << std::setw(14) << "Complete" << std::setw(14)
+            << "Bright" << "\n";
+  std::cout << std::string(80, '-') << "\n";
+
+  for (size_t size : sizes) {
+    WriteMockJSONCatalog(path, size);
+    ResultBuffer buffer;
+
+    // Previous startup: load, build everything, then calculate
+    auto start = std::chrono::steady_clock::now();
+    {
+      AstrometryEngine engine;
+      auto catalog = CatalogLoader::LoadStarDataFromJSON(path);
+      engine.SetCatalog(catalog);
+      engine.CalculateSky(buffer, obs, {}, now);
+    }
+    double blocking_ms = MillisecondsSince(start);
+
+    // Pipeline: calculate with whatever engine is published first
+    std::mutex mutex;
+    std::condition_variable published;
+    std::shared_ptr<const AstrometryEngine> first;
+    bool any_published = false;
+    size_t bright_count = 0;
+
+    start = std::chrono::steady_clock::now();
+    StartupPipeline pipeline(
+        {.catalog_path = path},
+        [&](std::shared_ptr<const AstrometryEngine> engine,
+            StartupStage stage) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!any_published) {
+            any_published = true;
+            first = std::move(engine);
+            if (first && stage == StartupStage::BRIGHT_READY) {
+              bright_count = first->GetStarCount();
+            }
+          }
+          published.notify_all();
+        });
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      published.wait(lock, [&] { return any_published; });
+    }
+    REQUIRE(first);
+    first->CalculateSky(buffer, obs, {}, now);
+    double first_ms = MillisecondsSince(start);
+    pipeline.Wait();
+
+    auto timings = pipeline.timings();
+    std::cout << std::left << std::setw(10) << size << std::fixed
+              << std::setprecision(1) << std::setw(14) << blocking_ms
+              << std::setw(14) << timings.catalog_loaded_ms << std::setw(14)
+              << first_ms << std::setw(14) << timings.complete_ms
+              << std::setw(14) << bright_count << "\n"
+              << std::defaultfloat;
+  }
+  std::cout << "\n* Times in ms. 'First' is the first CalculateSky on the "
+               "first published engine.\n";
+  std::cout << std::string(80, '=') << "\n" << std::endl;
+
+  std::filesystem::remove(path);
+}
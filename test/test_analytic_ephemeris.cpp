@@ -0,0 +1,220 @@
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "analytic_ephemeris.hpp"
+
+using namespace engine;
+
+namespace {
+
+constexpr double kDegree = std::numbers::pi / 180.0;
+constexpr double kAuKm = 149597870.7;
+
+struct Ecliptic {
+  double longitude;  // Degrees
+  double latitude;   // Degrees
+  double distance;   // AU
+};
+
+Ecliptic ToSpherical(double x, double y, double z) {
+  double longitude = std::atan2(y, x) / kDegree;
+  longitude -= 360.0 * std::floor(longitude / 360.0);
+  return {longitude, std::atan2(z, std::hypot(x, y)) / kDegree,
+          std::sqrt(x * x + y * y + z * z)};
+}
+
+// Ecliptic coordinates of an equatorial J2000 vector, referred to the mean
+// ecliptic and equinox of date: precessed to the mean equator of date with
+// the IAU 1976 angles, then turned by the mean obliquity of date.
+Ecliptic ToEclipticOfDate(const std::array<double, 3>& v, double jd_tdb) {
+  const double t = (jd_tdb - 2451545.0) / 36525.0;
+  const double arcsecond = kDegree / 3600.0;
+  const double zeta = (2306.2181 + (0.30188 + 0.017998 * t) * t) * t;
+  const double z = (2306.2181 + (1.09468 + 0.018203 * t) * t) * t;
+  const double theta = (2004.3109 - (0.42665 + 0.041833 * t) * t) * t;
+  const double eps =
+      84381.448 - (46.8150 + (0.00059 - 0.001813 * t) * t) * t;
+  const double cz = std::cos(zeta * arcsecond), sz = std::sin(zeta * arcsecond);
+  const double cZ = std::cos(z * arcsecond), sZ = std::sin(z * arcsecond);
+  const double ct = std::cos(theta * arcsecond);
+  const double st = std::sin(theta * arcsecond);
+  const double x = (cz * ct * cZ - sz * sZ) * v[0] -
+                   (sz * ct * cZ + cz * sZ) * v[1] - st * cZ * v[2];
+  const double y = (cz * ct * sZ + sz * cZ) * v[0] +
+                   (cz * cZ - sz * ct * sZ) * v[1] - st * sZ * v[2];
+  const double w = cz * st * v[0] - sz * st * v[1] + ct * v[2];
+  const double ce = std::cos(eps * arcsecond), se = std::sin(eps * arcsecond);
+  return ToSpherical(x, ce * y + se * w, ce * w - se * y);
+}
+
+// Ecliptic coordinates of an equatorial J2000 vector, referred to the
+// ecliptic and equinox of J2000.
+Ecliptic ToEclipticJ2000(const std::array<double, 3>& v) {
+  const double eps = 84381.448 / 3600.0 * kDegree;
+  return ToSpherical(v[0], std::cos(eps) * v[1] + std::sin(eps) * v[2],
+                     std::cos(eps) * v[2] - std::sin(eps) * v[1]);
+}
+
+// Angle between two longitudes, arcseconds
+double LongitudeError(double a, double b) {
+  return std::abs(std::remainder(a - b, 360.0)) * 3600.0;
+}
+
+BodyState StateAt(AnalyticBody body, double jd_tdb) {
+  BodyState state;
+  AnalyticStates(body, std::span<const double>(&jd_tdb, 1),
+                 std::span<BodyState>(&state, 1));
+  return state;
+}
+
+}  // namespace
+
+TEST_CASE("Analytic Moon matches Meeus example 47.a", "[engine][analytic]") {
+  // 1992 April 12, 0h TD
+  auto moon = AnalyticMoon(2448724.5);
+  CHECK(std::abs(moon.longitude - 133.162655) < 1e-6);
+  CHECK(std::abs(moon.latitude - -3.229126) < 1e-6);
+  CHECK(std::abs(moon.distance_km - 368409.7) < 0.1);
+
+  // The Earth and the Moon straddle their barycenter at that distance
+  auto earth = StateAt(AnalyticBody::EARTH, 2448724.5);
+  auto heliocentric = StateAt(AnalyticBody::MOON, 2448724.5);
+  double distance = 0.0;
+  for (size_t k = 0; k < 3; ++k) {
+    double d = heliocentric.position[k] - earth.position[k];
+    distance += d * d;
+  }
+  CHECK(std::abs(std::sqrt(distance) * kAuKm - 368409.7) < 1.0);
+}
+
+TEST_CASE("Analytic planets match VSOP87 at J2000", "[engine][analytic]") {
+  // The check values published with VSOP87D (full series), heliocentric
+  // and referred to the ecliptic and equinox of date, in radians and AU.
+  // Zero skips the radius.
+  struct Check {
+    AnalyticBody body;
+    double longitude, latitude, distance;
+    double tolerance;  // Arcseconds
+  };
+  constexpr Check kChecks[] = {
+      {AnalyticBody::MERCURY, 4.4293481036, -0.0527573409, 0.4664714751, 1.0},
+      {AnalyticBody::VENUS, 3.1870221833, 0.0569782849, 0.7202129253, 1.0},
+      {AnalyticBody::EARTH, 1.7519238681, -0.0000039656, 0.9833276819, 1.0},
+      {AnalyticBody::MARS, 6.2735389983, -0.0247779824, 1.3912076925, 4.0},
+      {AnalyticBody::JUPITER, 0.6334614186, -0.0205001039, 4.9653813154, 4.0},
+      {AnalyticBody::SATURN, 0.7980038761, -0.0401984149, 9.1838483568, 4.0},
+      {AnalyticBody::URANUS, 5.5225485803, -0.0119527838, 0.0, 4.0},
+      {AnalyticBody::NEPTUNE, 5.3045629252, 0.0042236789, 0.0, 4.0},
+  };
+  const double jd = 2451545.0;
+  for (const auto& check : kChecks) {
+    auto place = ToEclipticOfDate(StateAt(check.body, jd).position, jd);
+    INFO("Body " << static_cast<int>(check.body));
+    CHECK(LongitudeError(place.longitude, check.longitude / kDegree) <
+          check.tolerance);
+    CHECK(std::abs(place.latitude - check.latitude / kDegree) * 3600.0 <
+          check.tolerance);
+    if (check.distance > 0.0) {
+      // Meeus's truncation costs the giant planets ~1e-4 AU
+      CHECK(std::abs(place.distance - check.distance) <
+            (check.distance < 2.0 ? 1e-5 : 2e-4));
+    }
+  }
+
+  CHECK(StateAt(AnalyticBody::SUN, jd).position ==
+        std::array<double, 3>{0.0, 0.0, 0.0});
+}
+
+TEST_CASE("Analytic planets match Meeus's examples", "[engine][analytic]") {
+  // Example 25.b: the Earth on 1992 October 13, 0h TD, ecliptic of date
+  const double earth_jd = 2448908.5;
+  auto earth = ToEclipticOfDate(
+      StateAt(AnalyticBody::EARTH, earth_jd).position, earth_jd);
+  CHECK(LongitudeError(earth.longitude, 19.907372) < 1.0);
+  CHECK(std::abs(earth.latitude - -0.000179) * 3600.0 < 1.0);
+  CHECK(std::abs(earth.distance - 0.99760775) < 1e-6);
+
+  // Example 32.a: Venus on 1992 December 20, 0h TD, ecliptic of date
+  const double venus_jd = 2448976.5;
+  auto venus = ToEclipticOfDate(
+      StateAt(AnalyticBody::VENUS, venus_jd).position, venus_jd);
+  CHECK(LongitudeError(venus.longitude, 26.11428) < 1.0);
+  CHECK(std::abs(venus.latitude - -2.62070) * 3600.0 < 1.0);
+  CHECK(std::abs(venus.distance - 0.724603) < 1e-5);
+
+  // Example 37.a: Pluto on 1992 October 13, 0h TD, ecliptic of J2000. The
+  // example's printed values are rounded from a longer series.
+  auto pluto =
+      ToEclipticJ2000(StateAt(AnalyticBody::PLUTO, 2448908.5).position);
+  CHECK(LongitudeError(pluto.longitude, 232.74009) < 3.0);
+  CHECK(std::abs(pluto.latitude - 14.58782) * 3600.0 < 3.0);
+  CHECK(std::abs(pluto.distance - 29.711383) < 3e-4);
+}
+
+TEST_CASE("Analytic orbits stay in range over 1885-2099",
+          "[engine][analytic]") {
+  // Perihelion and aphelion distances, AU, with 1% to spare
+  struct Range {
+    AnalyticBody body;
+    double perihelion, aphelion;
+  };
+  constexpr Range kRanges[] = {
+      {AnalyticBody::MERCURY, 0.3075, 0.4667},
+      {AnalyticBody::VENUS, 0.7184, 0.7282},
+      {AnalyticBody::EARTH, 0.9833, 1.0167},
+      {AnalyticBody::MARS, 1.3814, 1.6660},
+      {AnalyticBody::JUPITER, 4.950, 5.457},
+      {AnalyticBody::SATURN, 9.041, 10.124},
+      {AnalyticBody::URANUS, 18.28, 20.10},
+      {AnalyticBody::NEPTUNE, 29.81, 30.33},
+      {AnalyticBody::PLUTO, 29.66, 49.31},
+  };
+  std::vector<double> times;
+  for (double jd = 2409543.5; jd < 2488069.5; jd += 97.3) times.push_back(jd);
+  std::vector<BodyState> states(times.size());
+  for (const auto& range : kRanges) {
+    AnalyticStates(range.body, times, states);
+    for (const auto& state : states) {
+      const double r = std::hypot(state.position[0], state.position[1],
+                                  state.position[2]);
+      INFO("Body " << static_cast<int>(range.body));
+      CHECK(r > 0.99 * range.perihelion);
+      CHECK(r < 1.01 * range.aphelion);
+    }
+  }
+}
+
+TEST_CASE("Analytic batches match single samples", "[engine][analytic]") {
+  // More samples than one block of the lunar series
+  std::vector<double> times;
+  for (int i = 0; i < 40; ++i) times.push_back(2460000.5 + 0.37 * i);
+
+  for (auto body : {AnalyticBody::MERCURY, AnalyticBody::EARTH,
+                    AnalyticBody::JUPITER, AnalyticBody::PLUTO,
+                    AnalyticBody::MOON}) {
+    std::vector<BodyState> states(times.size());
+    AnalyticStates(body, times, states);
+    for (size_t i = 0; i < times.size(); ++i) {
+      // Vectorized and scalar code may round differently
+      auto single = StateAt(body, times[i]);
+      for (size_t k = 0; k < 3; ++k) {
+        CHECK(std::abs(states[i].position[k] - single.position[k]) < 1e-12);
+      }
+
+      // Velocities are the derivative of the positions
+      auto before = StateAt(body, times[i] - 1e-3);
+      auto after = StateAt(body, times[i] + 1e-3);
+      double speed = 0.0, error = 0.0;
+      for (size_t k = 0; k < 3; ++k) {
+        double derivative = (after.position[k] - before.position[k]) / 2e-3;
+        speed += single.velocity[k] * single.velocity[k];
+        error += (derivative - single.velocity[k]) *
+                 (derivative - single.velocity[k]);
+      }
+      CHECK(std::sqrt(error) < 1e-4 * std::sqrt(speed));
+    }
+  }
+}
@@ -1,8 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
 
+#include "binary_catalog.hpp"
 #include "catalog_loader.hpp"
 #include "engine.hpp"
 
@@ -59,3 +64,387 @@ TEST_CASE("Catalog Loader JSON Parsing", "[engine][catalog]") {
   CHECK(star.flux_qual == 'C');
   CHECK(!star.ids.empty());
 }
+
+TEST_CASE("CSV loader parses every field", "[engine][catalog]") {
+  const std::string test_csv_path = "test_stars.csv";
+
+  SECTION("Full, short and quoted rows") {
+    std::ofstream(test_csv_path, std::ios::binary)
+        << "name,catalog,catalog_id,ra,dec,coo_qual,pmra,pmdec,pm_qual,"
+           "parallax,plx_qual,radial_velocity,rvz_qual,flux,flux_err,"
+           "flux_qual,ids\n"
+        << "\"Sirius, A\",HIP,32349,101.287,-16.716,A,-546.01,-1223.07,B,"
+           "379.21,C,-5.5,D,-1.46,0.01,E,\"NAME Sirius|HIP 32349\"\r\n"
+        << "Vega,HIP,91262,279.235,38.784\n"
+        << "\n"
+        << "\"Say \"\"hi\"\"\",,, 3 ,+4\n"
+        << "Last,HIP,7,5,6";
+
+    std::vector<CatalogRowError> bad_rows;
+    auto stars =
+        CatalogLoader::LoadStarDataFromCSV(test_csv_path, {}, &bad_rows);
+    std::filesystem::remove(test_csv_path);
+
+    CHECK(bad_rows.empty());
+    REQUIRE(stars.size() == 4);
+    const auto& sirius = stars[0];
+    CHECK(sirius.name == "Sirius, A");
+    CHECK(sirius.catalog == "HIP");
+    CHECK(sirius.catalog_id == 32349);
+    CHECK(sirius.ra == 101.287);
+    CHECK(sirius.dec == -16.716);
+    CHECK(sirius.coo_qual == 'A');
+    CHECK(sirius.pmra == -546.01);
+    CHECK(sirius.pmdec == -1223.07);
+    CHECK(sirius.pm_qual == 'B');
+    CHECK(sirius.parallax == 379.21);
+    CHECK(sirius.plx_qual == 'C');
+    CHECK(sirius.radial_velocity == -5.5);
+    CHECK(sirius.rvz_qual == 'D');
+    CHECK(sirius.flux == -1.46f);
+    CHECK(sirius.flux_err == 0.01f);
+    CHECK(sirius.flux_qual == 'E');
+    CHECK(sirius.ids == "NAME Sirius|HIP 32349");
+
+    CHECK(stars[1].name == "Vega");
+    CHECK(stars[1].dec == 38.784);
+    CHECK(stars[1].coo_qual == ' ');
+    CHECK(stars[1].ids.empty());
+
+    CHECK(stars[2].name == "Say \"hi\"");
+    CHECK(stars[2].catalog_id == 0);
+    CHECK(stars[2].ra == 3.0);
+    CHECK(stars[2].dec == 4.0);
+
+    CHECK(stars[3].name == "Last");
+  }
+
+  SECTION("Malformed rows are reported, not thrown") {
+    std::ofstream(test_csv_path) << "header\n"
+                                 << "Good,HIP,1,10,20\n"
+                                 << "Bad Id,HIP,x12,10,20\n"
+                                 << "Short,HIP,1\n"
+                                 << "\"Open,HIP,1,10,20\n"
+                                 << "Bad Ra,HIP,1,10.5.1,20\n"
+                                 << "Good Too,HIP,2,30,40\n";
+
+    std::vector<CatalogRowError> bad_rows;
+    auto stars =
+        CatalogLoader::LoadStarDataFromCSV(test_csv_path, {}, &bad_rows);
+    std::filesystem::remove(test_csv_path);
+
+    REQUIRE(stars.size() == 2);
+    CHECK(stars[1].name == "Good Too");
+    REQUIRE(bad_rows.size() == 4);
+    CHECK(bad_rows[0].line == 3);
+    CHECK(bad_rows[1].line == 4);
+    CHECK(bad_rows[2].line == 5);
+    CHECK(bad_rows[3].line == 6);
+    CHECK(bad_rows[3].reason.find("ra") != std::string::npos);
+  }
+
+  SECTION("Rows the filter rejects are dropped while parsing") {
+    std::ofstream(test_csv_path) << "header\n"
+                                 << "Bright,HIP,1,10,20,A,,,,,,,,1.5\n"
+                                 << "Faint,HIP,2,10,20,A,,,,,,,,9.5\n"
+                                 << "Poor,HIP,3,10,20,E,,,,,,,,1.5\n"
+                                 << "South,HIP,4,10,-70,A,,,,,,,,1.5\n";
+
+    CatalogFilter filter{
+        .max_magnitude = 6.0f, .min_dec = -60.0, .max_coo_qual = 'B'};
+    auto stars = CatalogLoader::LoadStarDataFromCSV(test_csv_path, filter);
+    std::filesystem::remove(test_csv_path);
+
+    REQUIRE(stars.size() == 1);
+    CHECK(stars[0].name == "Bright");
+  }
+
+  SECTION("Rows keep file order across parallel chunks") {
+    constexpr long kRows = 60000;  // Several parse chunks
+    {
+      std::ofstream file(test_csv_path);
+      file << "name,catalog,catalog_id,ra,dec\n";
+      for (long i = 0; i < kRows; ++i) {
+        file << "Star " << i << ",MOCK," << i << "," << i % 360 << ",0.5\n";
+      }
+    }
+
+    std::vector<CatalogRowError> bad_rows;
+    auto stars =
+        CatalogLoader::LoadStarDataFromCSV(test_csv_path, {}, &bad_rows);
+    std::filesystem::remove(test_csv_path);
+
+    CHECK(bad_rows.empty());
+    REQUIRE(stars.size() == kRows);
+    size_t out_of_order = 0;
+    for (long i = 0; i < kRows; ++i) {
+      if (stars[i].catalog_id != i) ++out_of_order;
+    }
+    CHECK(out_of_order == 0);
+  }
+}
+
+TEST_CASE("JSON loader streams only the data rows", "[engine][catalog]") {
+  const std::string test_json_path = "test_stream.json";
+
+  SECTION("Other keys, short rows and nested values are skipped") {
+    std::ofstream(test_json_path) << R"({
+    "metadata": [{"name": "main_id"}, {"name": "ra"}],
+    "data": [
+        ["HD 1", 10.5, -20.25, "B", 1, 2, "C", 3.5, "D", null, "E", 4.5,
+         0.1, "F", "HIP 17|NAME First"],
+        ["short row", 1.0, 2.0],
+        ["HD 2", 30, 40, "", {"nested": [1, 2]}, null, null, null, null,
+         null, null, null, null, null, null],
+        7
+    ],
+    "more": {"data": [["not", "a", "star"]]}
+})";
+    auto stars = CatalogLoader::LoadStarDataFromJSON(test_json_path);
+    std::filesystem::remove(test_json_path);
+
+    REQUIRE(stars.size() == 2);
+    CHECK(stars[0].name == "First");
+    CHECK(stars[0].catalog == "HIP");
+    CHECK(stars[0].catalog_id == 17);
+    CHECK(stars[0].ra == 10.5);
+    CHECK(stars[0].dec == -20.25);
+    CHECK(stars[0].pmra == 1.0);
+    CHECK(stars[0].plx_qual == 'D');
+    CHECK(stars[0].radial_velocity == 0.0);
+    CHECK(stars[0].flux_qual == 'F');
+
+    CHECK(stars[1].name == "HD 2");
+    CHECK(stars[1].catalog.empty());
+    CHECK(stars[1].catalog_id == 0);
+    CHECK(stars[1].ra == 30.0);
+    CHECK(stars[1].coo_qual == ' ');
+    CHECK(stars[1].pmra == 0.0);
+    CHECK(stars[1].ids.empty());
+  }
+
+  SECTION("A syntax error yields an empty catalog") {
+    std::ofstream(test_json_path) << R"({"data": [["HD 1", 10.5, )";
+    auto stars = CatalogLoader::LoadStarDataFromJSON(test_json_path);
+    std::filesystem::remove(test_json_path);
+    CHECK(stars.empty());
+  }
+}
+
+TEST_CASE("Binary catalog round trip", "[engine][catalog]") {
+  const std::string test_zcat_path = "test_stars.zcat";
+  std::vector<Star> stars = {
+      Star{.name = "Sirius A",
+           .catalog = "HIP",
+           .catalog_id = 32349,
+           .ra = 101.28715533333335,
+           .dec = -16.71611586111111,
+           .coo_qual = 'A',
+           .pmra = -546.01,
+           .pmdec = -1223.07,
+           .pm_qual = 'B',
+           .parallax = 379.21,
+           .plx_qual = 'C',
+           .radial_velocity = -5.5,
+           .rvz_qual = 'D',
+           .flux = -1.46f,
+           .flux_err = 0.01f,
+           .flux_qual = 'E',
+           .ids = "NAME Sirius|HIP 32349"},
+      Star{.name = "", .ra = 279.235, .dec = 38.784},
+      Star{.name = "Polaris", .catalog = "HIP", .ra = 37.95, .dec = 89.26}};
+
+  SECTION("Every field survives a write and open") {
+    REQUIRE(BinaryCatalog::Write(test_zcat_path, stars));
+    auto catalog = BinaryCatalog::Open(test_zcat_path);
+    REQUIRE(catalog);
+    REQUIRE(catalog->size() == stars.size());
+
+    for (size_t i = 0; i < stars.size(); ++i) {
+      Star star = catalog->GetStar(i);
+      CHECK(star.name == stars[i].name);
+      CHECK(star.catalog == stars[i].catalog);
+      CHECK(star.catalog_id == stars[i].catalog_id);
+      CHECK(star.ra == stars[i].ra);
+      CHECK(star.dec == stars[i].dec);
+      CHECK(star.coo_qual == stars[i].coo_qual);
+      CHECK(star.pmra == stars[i].pmra);
+      CHECK(star.pmdec == stars[i].pmdec);
+      CHECK(star.pm_qual == stars[i].pm_qual);
+      CHECK(star.parallax == stars[i].parallax);
+      CHECK(star.plx_qual == stars[i].plx_qual);
+      CHECK(star.radial_velocity == stars[i].radial_velocity);
+      CHECK(star.rvz_qual == stars[i].rvz_qual);
+      CHECK(star.flux == stars[i].flux);
+      CHECK(star.flux_err == stars[i].flux_err);
+      CHECK(star.flux_qual == stars[i].flux_qual);
+      CHECK(star.ids == stars[i].ids);
+    }
+    catalog.reset();
+    std::filesystem::remove(test_zcat_path);
+  }
+
+  SECTION("Truncated or foreign files are rejected") {
+    REQUIRE(BinaryCatalog::Write(test_zcat_path, stars));
+    auto size = std::filesystem::file_size(test_zcat_path);
+    std::filesystem::resize_file(test_zcat_path, size - 1);
+    CHECK_FALSE(BinaryCatalog::Open(test_zcat_path));
+
+    std::ofstream(test_zcat_path, std::ios::binary) << "not a catalog";
+    CHECK_FALSE(BinaryCatalog::Open(test_zcat_path));
+    std::filesystem::remove(test_zcat_path);
+    CHECK_FALSE(BinaryCatalog::Open(test_zcat_path));
+  }
+
+  SECTION("Engine results match the in-memory catalog") {
+    REQUIRE(BinaryCatalog::Write(test_zcat_path, stars));
+    auto catalog = BinaryCatalog::Open(test_zcat_path);
+    REQUIRE(catalog);
+
+    AstrometryEngine from_stars;
+    from_stars.SetCatalog(stars);
+    AstrometryEngine from_file;
+    from_file.SetCatalog(catalog);
+
+    Observer obs{37.7749, -122.4194, 0.0};
+    auto now = std::chrono::system_clock::now();
+    FilterCriteria filter{.active = true};
+    auto expected = from_stars.CalculateZenithProximity(obs, filter, {}, now);
+    auto actual = from_file.CalculateZenithProximity(obs, filter, {}, now);
+
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+      CHECK(actual[i].name == expected[i].name);
+      CHECK(actual[i].catalog_index == expected[i].catalog_index);
+      CHECK(actual[i].elevation == expected[i].elevation);
+      CHECK(actual[i].azimuth == expected[i].azimuth);
+    }
+
+    // Names are views into the mapping, which the engine keeps alive
+    catalog.reset();
+    auto again = from_file.CalculateZenithProximity(obs, filter, {}, now);
+    REQUIRE(again.size() == expected.size());
+    CHECK(again.front().name == expected.front().name);
+    std::filesystem::remove(test_zcat_path);
+  }
+}
+
+TEST_CASE("Tiled binary catalog", "[engine][catalog]") {
+  const std::string test_zcat_path = "test_tiled.zcat";
+  std::vector<Star> stars;
+  for (int ra = 0; ra < 360; ra += 6) {
+    for (int dec = -87; dec <= 87; dec += 6) {
+      size_t n = stars.size();
+      stars.push_back(Star{.name = "Star " + std::to_string(n),
+                           .catalog = "HIP",
+                           .catalog_id = static_cast<long>(n),
+                           .ra = ra + 0.25,
+                           .dec = dec + 0.5,
+                           .pmra = n % 5 == 0 ? 800.0 : 0.0,
+                           .pmdec = n % 5 == 0 ? -400.0 : 0.0,
+                           .flux = static_cast<float>((n * 37) % 130) / 10.0f,
+                           .ids = "HIP " + std::to_string(n)});
+    }
+  }
+  REQUIRE(BinaryCatalog::Write(test_zcat_path, stars, true));
+  auto catalog = BinaryCatalog::Open(test_zcat_path);
+  REQUIRE(catalog);
+  REQUIRE(catalog->tiled());
+  REQUIRE(catalog->size() == stars.size());
+
+  SECTION("Tiles cover every star, brightest first") {
+    auto offsets = catalog->tile_offsets();
+    auto caps = catalog->tile_caps();
+    REQUIRE(caps.size() == SkyIndex::TileCount(catalog->tile_depth()));
+    REQUIRE(offsets.back() == stars.size());
+
+    size_t unsorted = 0, outside = 0;
+    for (size_t tile = 0; tile < caps.size(); ++tile) {
+      for (size_t i = offsets[tile]; i < offsets[tile + 1]; ++i) {
+        auto v = SkyVector::FromRaDec(catalog->ra()[i], catalog->dec()[i]);
+        if (v.Dot(caps[tile].center) < std::cos(caps[tile].radius) - 1e-12) {
+          ++outside;
+        }
+        if (i > offsets[tile] && catalog->flux()[i - 1] > catalog->flux()[i]) {
+          ++unsorted;
+        }
+      }
+    }
+    CHECK(unsorted == 0);
+    CHECK(outside == 0);
+  }
+
+  SECTION("Mapped storage matches the catalog loaded into memory") {
+    AstrometryEngine loaded;
+    loaded.SetCatalog(catalog);
+    AstrometryEngine mapped;
+    mapped.SetCatalogStorage(CatalogStorage::MAPPED);
+    mapped.SetCatalog(catalog);
+    CHECK(mapped.GetSkyIndex()->size() == 0);
+
+    Observer obs{51.4769, -0.0005, 0.0};
+    auto now = std::chrono::system_clock::now();
+    for (auto mode : {AccuracyMode::PRECISE, AccuracyMode::FAST}) {
+      loaded.SetAccuracyMode(mode);
+      mapped.SetAccuracyMode(mode);
+      for (float limit : {std::numeric_limits<float>::infinity(), 4.0f}) {
+        FilterCriteria filter{.min_elevation = 10.0f, .max_magnitude = limit,
+                              .active = true};
+        auto expected = loaded.CalculateZenithProximity(obs, filter, {}, now);
+        auto actual = mapped.CalculateZenithProximity(obs, filter, {}, now);
+        REQUIRE(!expected.empty());
+        REQUIRE(actual.size() == expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+          CHECK(actual[i].name == expected[i].name);
+          CHECK(actual[i].catalog_index == expected[i].catalog_index);
+          CHECK_THAT(actual[i].elevation,
+                     Catch::Matchers::WithinAbs(expected[i].elevation, 1e-9));
+          CHECK_THAT(actual[i].azimuth,
+                     Catch::Matchers::WithinAbs(expected[i].azimuth, 1e-9));
+          CHECK(actual[i].magnitude <= limit);
+        }
+      }
+    }
+
+    CHECK(mapped.ConeSearch(120.0, 30.0, 10.0) ==
+          loaded.ConeSearch(120.0, 30.0, 10.0));
+    size_t index = mapped.ConeSearch(120.0, 30.0, 10.0).front();
+    CHECK(*mapped.GetIdentifiers(index) == *loaded.GetIdentifiers(index));
+  }
+
+  SECTION("The load-time filter applies to mapped stars") {
+    AstrometryEngine mapped;
+    mapped.SetCatalogStorage(CatalogStorage::MAPPED);
+    mapped.SetCatalog(catalog, CatalogFilter{.max_magnitude = 2.0f});
+
+    Observer obs{-30.0, 70.0, 0.0};
+    auto results = mapped.CalculateZenithProximity(
+        obs, {}, {}, std::chrono::system_clock::now());
+    REQUIRE(!results.empty());
+    for (const auto& result : results) CHECK(result.magnitude <= 2.0f);
+  }
+
+  catalog.reset();
+  std::filesystem::remove(test_zcat_path);
+}
+
+TEST_CASE("Catalog file hash tracks the contents", "[engine][catalog]") {
+  const std::string path = "test_hash.csv";
+  std::string text = "name,catalog,catalog_id,ra,dec\n";
+  for (int i = 0; i < 100000; ++i) {
+    text += "Star " + std::to_string(i) + ",HIP," + std::to_string(i) +
+            ",10.5,20.5\n";
+  }
+  std::ofstream(path, std::ios::binary) << text;
+  auto first = CatalogLoader::HashCatalogFile(path);
+  REQUIRE(first);
+  CHECK(CatalogLoader::HashCatalogFile(path) == first);
+
+  // One changed byte past the first chunk
+  text[text.size() - 3] = '6';
+  std::ofstream(path, std::ios::binary) << text;
+  CHECK(CatalogLoader::HashCatalogFile(path) != first);
+
+  std::filesystem::remove(path);
+  CHECK_FALSE(CatalogLoader::HashCatalogFile(path));
+}
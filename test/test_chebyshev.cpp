@@ -0,0 +1,47 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
+
+#include "chebyshev.hpp"
+
+using namespace engine;
+
+namespace {
+
+ChebyshevSeries FitFunction(double (*f)(double), size_t count, double start,
+                            double end) {
+  std::vector<double> samples(count);
+  for (size_t k = 0; k < count; ++k) {
+    samples[k] = f(ChebyshevSeries::Node(k, count, start, end));
+  }
+  return ChebyshevSeries::Fit(samples, start, end);
+}
+
+}  // namespace
+
+TEST_CASE("Chebyshev nodes lie inside the interval", "[engine][chebyshev]") {
+  for (size_t k = 0; k < 10; ++k) {
+    double t = ChebyshevSeries::Node(k, 10, 100.0, 3700.0);
+    CHECK(t > 100.0);
+    CHECK(t < 3700.0);
+  }
+}
+
+TEST_CASE("Chebyshev series reproduce smooth functions",
+          "[engine][chebyshev]") {
+  auto sine = FitFunction([](double t) { return std::sin(t); }, 10, 0.0, 1.0);
+  auto exp = FitFunction([](double t) { return std::exp(t); }, 12, -1.0, 1.0);
+  for (int i = 0; i <= 100; ++i) {
+    double t = i / 100.0;
+    CHECK(std::abs(sine(t) - std::sin(t)) < 1e-11);
+    CHECK(std::abs(exp(2.0 * t - 1.0) - std::exp(2.0 * t - 1.0)) < 1e-9);
+  }
+}
+
+TEST_CASE("Chebyshev series of a polynomial is exact", "[engine][chebyshev]") {
+  auto cubic = FitFunction([](double t) { return 3.0 * t * t * t - t + 2.0; },
+                           4, -5.0, 5.0);
+  for (double t : {-5.0, -2.5, 0.0, 1.0, 5.0}) {
+    CHECK(std::abs(cubic(t) - (3.0 * t * t * t - t + 2.0)) < 1e-9);
+  }
+}
@@ -1,9 +1,25 @@
+#include <algorithm>
+#include <array>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+extern "C" {
+#include <novas.h>
+}
+
+#include "constants.hpp"
 #include "engine.hpp"
+#include "julian.hpp"
 
 using namespace engine;
 
@@ -57,6 +73,26 @@ TEST_CASE("Zenith Proximity Calculation Sanity Check", "[engine]") {
     }
   }
 
+  SECTION("Elevation rate matches the change in elevation") {
+    AstrometryEngine engine;
+    engine.SetCatalog(mock_catalog);
+    auto res = engine.CalculateZenithProximity(obs, {}, {}, now);
+    auto res_future = engine.CalculateZenithProximity(
+        obs, {}, {}, now + std::chrono::minutes(1));
+
+    for (const auto& r : res) {
+      REQUIRE(r.is_rising == (r.elevation_rate > 0.0));
+      if (r.elevation < 20.0) continue;  // Keep refraction out of the way
+      auto it = std::find_if(
+          res_future.begin(), res_future.end(),
+          [&](const CelestialResult& f) { return f.name == r.name; });
+      if (it != res_future.end()) {
+        REQUIRE_THAT(it->elevation - r.elevation,
+                     Catch::Matchers::WithinAbs(r.elevation_rate, 0.005));
+      }
+    }
+  }
+
   SECTION("Filtering in engine") {
     AstrometryEngine engine;
     engine.SetCatalog(mock_catalog);
@@ -115,6 +151,101 @@ TEST_CASE("Zenith Proximity Calculation Sanity Check", "[engine]") {
       auto results = engine.CalculateZenithProximity(obs, filter, {}, now);
       REQUIRE(results.empty());
     }
+
+    SECTION("Huge limit keeps everything from the offset") {
+      filter.star_offset = 2;
+      filter.star_limit = std::numeric_limits<size_t>::max();
+      auto results = engine.CalculateZenithProximity(obs, filter, {}, now);
+      REQUIRE(results.size() == 8);
+      REQUIRE(results[0].name == "Star 2");
+
+      SortCriteria by_name{SortColumn::NAME, false};
+      auto sorted = engine.CalculateZenithProximity(obs, filter, by_name, now);
+      REQUIRE(sorted.size() == 8);
+      REQUIRE(sorted[0].name == "Star 7");
+    }
+  }
+
+  SECTION("Paginated top-K matches the fully sorted result") {
+    AstrometryEngine engine;
+    std::vector<Star> many_stars;
+    for (int i = 0; i < 2000; ++i) {
+      many_stars.push_back(Star{.name = "Star " + std::to_string(i),
+                                .ra = (i * 37) % 360 + 0.25,
+                                .dec = (i * 53) % 170 - 85.0,
+                                .flux = static_cast<float>(i % 7)});
+    }
+    engine.SetCatalog(many_stars);
+
+    FilterCriteria filter;
+    filter.active = true;
+    SortCriteria sort{SortColumn::MAGNITUDE, false};
+    auto full = engine.CalculateZenithProximity(obs, filter, sort, now);
+    REQUIRE(full.size() == many_stars.size());
+
+    filter.star_offset = 120;
+    filter.star_limit = 50;
+    auto page = engine.CalculateZenithProximity(obs, filter, sort, now);
+    REQUIRE(page.size() == 50);
+    for (size_t i = 0; i < page.size(); ++i) {
+      // Equal magnitudes are broken by catalog order
+      REQUIRE(page[i].catalog_index == full[120 + i].catalog_index);
+    }
+  }
+
+  SECTION("Cached frames are keyed by observer and time") {
+    AstrometryEngine engine;
+    engine.SetCatalog(mock_catalog);
+    FilterCriteria whole_sky;
+    whole_sky.active = true;
+    Observer sydney{-33.8688, 151.2093, 0.0};
+
+    auto first = engine.CalculateZenithProximity(obs, whole_sky, {}, now);
+    auto other = engine.CalculateZenithProximity(sydney, whole_sky, {}, now);
+    auto again = engine.CalculateZenithProximity(obs, whole_sky, {}, now);
+    auto later = engine.CalculateZenithProximity(
+        obs, whole_sky, {}, now + std::chrono::hours(1));
+
+    REQUIRE(first.size() == 2);
+    REQUIRE(again.size() == 2);
+    REQUIRE(later.size() == 2);
+    REQUIRE(other.size() == 2);
+    for (size_t i = 0; i < first.size(); ++i) {
+      REQUIRE(again[i].elevation == first[i].elevation);
+      REQUIRE(again[i].azimuth == first[i].azimuth);
+      REQUIRE(other[i].elevation != first[i].elevation);
+      REQUIRE(later[i].elevation != first[i].elevation);
+    }
+  }
+
+  SECTION("Reused buffer matches a fresh one") {
+    AstrometryEngine engine;
+    std::vector<Star> many_stars;
+    for (int i = 0; i < 3000; ++i) {
+      many_stars.push_back(Star{.name = "Star " + std::to_string(i),
+                                .ra = (i * 41) % 360 + 0.5,
+                                .dec = (i * 29) % 170 - 85.0});
+    }
+    engine.SetCatalog(many_stars);
+
+    // Fill the scratch from a whole-sky query, then shrink the band
+    ResultBuffer reused;
+    FilterCriteria filter;
+    filter.active = true;
+    engine.CalculateZenithProximity(reused, obs, filter, {}, now);
+    REQUIRE(reused.star_results.size() == many_stars.size());
+
+    filter.min_elevation = 30.0f;
+    filter.min_azimuth = 90.0f;
+    filter.max_azimuth = 270.0f;
+    engine.CalculateZenithProximity(reused, obs, filter, {}, now);
+    auto fresh = engine.CalculateZenithProximity(obs, filter, {}, now);
+
+    REQUIRE(reused.star_results.size() == fresh.size());
+    for (size_t i = 0; i < fresh.size(); ++i) {
+      REQUIRE(reused.star_results[i].catalog_index == fresh[i].catalog_index);
+      REQUIRE(reused.star_results[i].elevation == fresh[i].elevation);
+    }
   }
 
   SECTION("Sorting in engine") {
@@ -142,6 +273,217 @@ TEST_CASE("Zenith Proximity Calculation Sanity Check", "[engine]") {
   }
 }
 
+TEST_CASE("Visibility culling respects the elevation band", "[engine]") {
+  Observer london{51.5074, -0.1278, 0.0};
+  auto now = std::chrono::system_clock::now();
+  std::vector<Star> catalog = {
+      Star{.name = "Never Rises", .ra = 120.0, .dec = -60.0},
+      Star{.name = "Circumpolar", .ra = 240.0, .dec = 80.0}};
+
+  auto has = [](const std::vector<CelestialResult>& results,
+                std::string_view name) {
+    return std::any_of(
+        results.begin(), results.end(),
+        [&](const CelestialResult& r) { return r.name == name; });
+  };
+
+  for (auto mode : {AccuracyMode::PRECISE, AccuracyMode::FAST}) {
+    AstrometryEngine engine;
+    engine.SetAccuracyMode(mode);
+    engine.SetCatalog(catalog);
+
+    auto visible = engine.CalculateZenithProximity(london, {}, {}, now);
+    CHECK_FALSE(has(visible, "Never Rises"));
+    CHECK(has(visible, "Circumpolar"));
+
+    // Stars below the horizon are still returned when the band asks for them
+    FilterCriteria whole_sky;
+    whole_sky.active = true;
+    auto all = engine.CalculateZenithProximity(london, whole_sky, {}, now);
+    REQUIRE(all.size() == 2);
+
+    // The circumpolar star never drops below ~41.5 degrees here
+    FilterCriteria low_band;
+    low_band.active = true;
+    low_band.max_elevation = 20.0f;
+    auto low = engine.CalculateZenithProximity(london, low_band, {}, now);
+    CHECK_FALSE(has(low, "Circumpolar"));
+
+    // Moving the observer far south rebuilds the classification
+    Observer sydney{-33.8688, 151.2093, 0.0};
+    auto south = engine.CalculateZenithProximity(sydney, whole_sky, {}, now);
+    REQUIRE(south.size() == 2);
+    for (const auto& r : south) {
+      if (r.name == "Circumpolar") CHECK(r.elevation < 0.0);
+    }
+  }
+}
+
+TEST_CASE("Fast accuracy mode error bound", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{37.7749, -122.4194, 0.0};
+  system_clock::time_point time = sys_days{March / 20 / 2025} + 6h;
+
+  // Grid over the whole sky, alternating between a stationary star and one
+  // with Sirius-like proper motion and parallax.
+  std::vector<Star> catalog;
+  for (int ra = 0; ra < 360; ra += 15) {
+    for (int dec = -80; dec <= 80; dec += 10) {
+      bool moving = catalog.size() % 2 == 1;
+      catalog.push_back(Star{.name = "Grid " + std::to_string(catalog.size()),
+                             .ra = ra + 0.5,
+                             .dec = dec + 0.5,
+                             .pmra = moving ? -546.01 : 0.0,
+                             .pmdec = moving ? -1223.07 : 0.0,
+                             .parallax = moving ? 379.21 : 0.0,
+                             .radial_velocity = moving ? -5.5 : 0.0});
+    }
+  }
+
+  FilterCriteria filter;
+  filter.active = true;
+  filter.min_elevation = 5.0f;
+
+  AstrometryEngine engine;
+  engine.SetCatalog(catalog);
+  auto precise = engine.CalculateZenithProximity(obs, filter, {}, time);
+  engine.SetAccuracyMode(AccuracyMode::FAST);
+  REQUIRE(engine.GetAccuracyMode() == AccuracyMode::FAST);
+  auto fast = engine.CalculateZenithProximity(obs, filter, {}, time);
+
+  // Light deflection is ignored in fast mode, so stay clear of the Sun.
+  FilterCriteria all_sky;
+  all_sky.active = true;
+  auto bodies = engine.CalculateSolarSystem(obs, all_sky, {}, time);
+  auto sun = std::find_if(bodies.begin(), bodies.end(),
+                          [](const SolarBody& b) { return b.name == "SUN"; });
+  REQUIRE(sun != bodies.end());
+
+  auto to_vector = [](double az, double el) {
+    double a = az * std::numbers::pi / 180.0;
+    double e = el * std::numbers::pi / 180.0;
+    return std::array<double, 3>{std::cos(e) * std::cos(a),
+                                 std::cos(e) * std::sin(a), std::sin(e)};
+  };
+  auto separation_arcsec = [](const std::array<double, 3>& u,
+                              const std::array<double, 3>& v) {
+    double dx = u[0] - v[0], dy = u[1] - v[1], dz = u[2] - v[2];
+    return 2.0 * std::asin(std::sqrt(dx * dx + dy * dy + dz * dz) / 2.0) *
+           180.0 / std::numbers::pi * 3600.0;
+  };
+  auto sun_vector = to_vector(sun->azimuth, sun->elevation);
+
+  std::map<std::string_view, const CelestialResult*> precise_by_name;
+  for (const auto& res : precise) precise_by_name[res.name] = &res;
+
+  size_t compared = 0;
+  for (const auto& res : fast) {
+    auto it = precise_by_name.find(res.name);
+    if (it == precise_by_name.end()) continue;
+    auto fast_vector = to_vector(res.azimuth, res.elevation);
+    if (separation_arcsec(fast_vector, sun_vector) < 2.0 * 3600.0) continue;
+
+    auto error = separation_arcsec(
+        fast_vector, to_vector(it->second->azimuth, it->second->elevation));
+    CHECK(error < 3.0);
+    ++compared;
+  }
+  REQUIRE(compared > 50);
+}
+
+TEST_CASE("Compact storage matches full storage", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{-33.8688, 151.2093, 0.0};
+  system_clock::time_point time = sys_days{July / 4 / 2026} + 12h;
+
+  std::vector<Star> catalog;
+  for (int ra = 0; ra < 360; ra += 20) {
+    for (int dec = -85; dec <= 85; dec += 10) {
+      bool moving = catalog.size() % 3 == 0;
+      catalog.push_back(Star{.name = "Grid " + std::to_string(catalog.size()),
+                             .ra = ra + 0.123456789,
+                             .dec = dec + 0.987654321,
+                             .pmra = moving ? 3577.0 : 0.0,
+                             .pmdec = moving ? 10328.0 : 0.0,
+                             .parallax = moving ? 548.31 : 0.0,
+                             .radial_velocity = moving ? -110.51 : 0.0,
+                             .flux = 4.5f + 0.001f * catalog.size()});
+    }
+  }
+  // Stars without a magnitude pass the magnitude cut in every storage, but
+  // are never the brightest
+  for (size_t i = 0; i < catalog.size(); i += 7) {
+    catalog[i].flux = std::numeric_limits<float>::quiet_NaN();
+  }
+
+  FilterCriteria filter;
+  filter.active = true;
+  filter.min_elevation = 1.0f;
+
+  // atan2 of the cross and dot products keeps its precision at small
+  // angles, where acos of the dot product cannot resolve a few mas
+  auto separation_mas = [](const CelestialResult& a, const CelestialResult& b) {
+    double d = std::numbers::pi / 180.0;
+    auto unit = [d](const CelestialResult& r) {
+      return std::array<double, 3>{
+          std::cos(r.elevation * d) * std::cos(r.azimuth * d),
+          std::cos(r.elevation * d) * std::sin(r.azimuth * d),
+          std::sin(r.elevation * d)};
+    };
+    auto u = unit(a), v = unit(b);
+    double cross = std::hypot(u[1] * v[2] - u[2] * v[1],
+                              u[2] * v[0] - u[0] * v[2],
+                              u[0] * v[1] - u[1] * v[0]);
+    double dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+    return std::atan2(cross, dot) / d * 3600.0e3;
+  };
+
+  for (auto mode : {AccuracyMode::PRECISE, AccuracyMode::FAST}) {
+    AstrometryEngine full;
+    full.SetAccuracyMode(mode);
+    full.SetCatalog(catalog);
+
+    AstrometryEngine compact;
+    compact.SetAccuracyMode(mode);
+    compact.SetCatalogStorage(CatalogStorage::COMPACT);
+    REQUIRE(compact.GetCatalogStorage() == CatalogStorage::COMPACT);
+    compact.SetCatalog(catalog);
+
+    auto expected = full.CalculateZenithProximity(obs, filter, {}, time);
+    auto actual = compact.CalculateZenithProximity(obs, filter, {}, time);
+    REQUIRE(expected.size() > 100);
+    REQUIRE(actual.size() == expected.size());
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+      REQUIRE(actual[i].catalog_index == expected[i].catalog_index);
+      CHECK(actual[i].name == expected[i].name);
+      CHECK(separation_mas(actual[i], expected[i]) <= 0.25);
+      if (std::isnan(expected[i].magnitude)) {
+        CHECK(std::isnan(actual[i].magnitude));
+      } else {
+        CHECK(std::abs(actual[i].magnitude - expected[i].magnitude) < 1e-3f);
+      }
+    }
+
+    // A magnitude cut keeps them, and they sort after every magnitude
+    FilterCriteria faint = filter;
+    faint.max_magnitude = 4.6f;
+    SortCriteria brightest{SortColumn::MAGNITUDE, true};
+    auto expected_faint =
+        full.CalculateZenithProximity(obs, faint, brightest, time);
+    auto actual_faint =
+        compact.CalculateZenithProximity(obs, faint, brightest, time);
+    REQUIRE(actual_faint.size() == expected_faint.size());
+    REQUIRE(std::isnan(actual_faint.back().magnitude));
+    for (size_t i = 0; i < expected_faint.size(); ++i) {
+      CHECK(actual_faint[i].catalog_index == expected_faint[i].catalog_index);
+    }
+
+    CHECK(compact.ConeSearch(100.0, 5.0, 15.0) ==
+          full.ConeSearch(100.0, 5.0, 15.0));
+  }
+}
+
 TEST_CASE("Solar System Calculation", "[engine]") {
   Observer obs{0.0, 0.0, 0.0};
   auto now = std::chrono::system_clock::now();
@@ -159,3 +501,521 @@ TEST_CASE("Solar System Calculation", "[engine]") {
     }
   }
 }
+
+TEST_CASE("Planet cache matches exact positions", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{37.7749, -122.4194, 0.0};
+  system_clock::time_point start = sys_days{March / 20 / 2025} + 6h;
+  FilterCriteria all_sky;
+  all_sky.active = true;
+
+  constexpr double kMas = 1.0 / 3.6e6;  // Degrees
+
+  AstrometryEngine exact;
+  AstrometryEngine cached;
+  cached.SetPlanetCacheWindow(hours(1));
+
+  // Across the first window, into its background refit and past it
+  for (auto offset : {0min, 20min, 50min, 59min, 70min, 150min}) {
+    auto time = start + offset;
+    auto expected = exact.CalculateSolarSystem(obs, all_sky, {}, time);
+    auto actual = cached.CalculateSolarSystem(obs, all_sky, {}, time);
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      REQUIRE(actual[i].name == expected[i].name);
+      double cos_el = std::cos(expected[i].elevation * std::numbers::pi / 180);
+      double daz = std::remainder(actual[i].azimuth - expected[i].azimuth, 360);
+      CHECK(std::abs(actual[i].elevation - expected[i].elevation) < kMas);
+      CHECK(std::abs(daz) * cos_el < kMas);
+      CHECK(std::abs(actual[i].distance_au - expected[i].distance_au) < 1e-9);
+    }
+    // The fit started at 50 minutes serves 70 minutes, even if it was
+    // still running, so only 150 minutes needs another fit
+    if (offset == 70min) CHECK(cached.GetPlanetFitCount() == 2);
+  }
+  CHECK(cached.GetPlanetFitCount() == 3);
+
+  // Windows beyond the longest are clamped
+  cached.SetPlanetCacheWindow(hours(48));
+  auto far = start + hours(30);
+  auto clamped = cached.CalculateSolarSystem(obs, all_sky, {}, far);
+  auto exact_far = exact.CalculateSolarSystem(obs, all_sky, {}, far);
+  REQUIRE(clamped.size() == exact_far.size());
+  for (size_t i = 0; i < clamped.size(); ++i) {
+    CHECK(std::abs(clamped[i].elevation - exact_far[i].elevation) < kMas);
+  }
+
+  // Turning the cache off goes back to exact evaluation
+  cached.SetPlanetCacheWindow(milliseconds(0));
+  auto time = start + 30min;
+  auto expected = exact.CalculateSolarSystem(obs, all_sky, {}, time);
+  auto actual = cached.CalculateSolarSystem(obs, all_sky, {}, time);
+  REQUIRE(actual.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    CHECK(actual[i].elevation == expected[i].elevation);
+  }
+}
+
+TEST_CASE("Warm-started light time matches a cold start", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{51.5074, -0.1278, 35.0};
+  system_clock::time_point time = sys_days{December / 1 / 2025} + 22h;
+  FilterCriteria all_sky;
+  all_sky.active = true;
+
+  // `warm` starts each body from a solution a day, then a second, away
+  AstrometryEngine cold;
+  AstrometryEngine warm;
+  ResultBuffer buffer;
+  warm.CalculateSolarSystem(buffer, obs, all_sky, {}, time - days(1));
+  warm.CalculateSolarSystem(buffer, obs, all_sky, {}, time - seconds(1));
+
+  auto expected = cold.CalculateSolarSystem(obs, all_sky, {}, time);
+  auto actual = warm.CalculateSolarSystem(obs, all_sky, {}, time);
+  REQUIRE(!expected.empty());
+  REQUIRE(actual.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    CHECK(actual[i].name == expected[i].name);
+    CHECK(std::abs(actual[i].elevation - expected[i].elevation) < 1e-8);
+    CHECK(std::abs(std::remainder(actual[i].azimuth - expected[i].azimuth,
+                                  360.0)) < 1e-8);
+    CHECK(std::abs(actual[i].distance_au - expected[i].distance_au) < 1e-12);
+  }
+}
+
+TEST_CASE("Solar system matches novas_sky_pos", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{-33.8688, 151.2093, 58.0};
+  FilterCriteria all_sky;
+  all_sky.active = true;
+  constexpr double kMas = 1.0 / 3.6e6;  // Degrees
+  const std::map<std::string_view, novas_planet> kBodies = {
+      {"SUN", NOVAS_SUN},         {"MERCURY", NOVAS_MERCURY},
+      {"VENUS", NOVAS_VENUS},     {"MARS", NOVAS_MARS},
+      {"JUPITER", NOVAS_JUPITER}, {"SATURN", NOVAS_SATURN},
+      {"URANUS", NOVAS_URANUS},   {"NEPTUNE", NOVAS_NEPTUNE},
+      {"PLUTO", NOVAS_PLUTO},     {"MOON", NOVAS_MOON}};
+
+  // Analytic mode has every body without an ephemeris file. The provider
+  // it installs is process-wide, so the reference below reads it too and
+  // only the light-time solution and the frame handling are compared.
+  AstrometryEngine engine;
+  engine.SetSolarSystemMode(SolarSystemMode::ANALYTIC);
+
+  // One engine across all dates, so most start from a distant solution
+  for (system_clock::time_point time :
+       {sys_days{January / 1 / 2000} + 12h, sys_days{March / 20 / 2025} + 6h,
+        sys_days{August / 12 / 2031} + 21h, sys_days{May / 3 / 2044} + 3h}) {
+    auto bodies = engine.CalculateSolarSystem(obs, all_sky, {}, time);
+
+    observer location;
+    make_gps_observer(obs.latitude, obs.longitude, obs.altitude, &location);
+    novas_timespec time_spec;
+    auto jd = GetJulianDayParts(time_point_cast<milliseconds>(time));
+    novas_set_split_time(NOVAS_UTC, jd.day_number, jd.fraction, kLeapSeconds,
+                         kDUT1, &time_spec);
+    novas_frame frame;
+    REQUIRE(novas_make_frame(NOVAS_REDUCED_ACCURACY, &location, &time_spec,
+                             kPolarOffsetX, kPolarOffsetY, &frame) == 0);
+
+    size_t compared = 0;
+    for (const auto& body : bodies) {
+      CAPTURE(body.name);
+      auto id = kBodies.find(body.name);
+      if (id == kBodies.end()) continue;  // The Earth, seen from itself
+      ++compared;
+      object planet;
+      make_planet(id->second, &planet);
+      sky_pos position;
+      REQUIRE(novas_sky_pos(&planet, &frame, NOVAS_CIRS, &position) == 0);
+      double az = 0.0, el = 0.0;
+      novas_app_to_hor(&frame, NOVAS_CIRS, position.ra, position.dec,
+                       novas_standard_refraction, &az, &el);
+
+      // Horizon coordinates are a rotation of RA and Dec; atan2 keeps the
+      // separation exact at small angles
+      double d = std::numbers::pi / 180.0;
+      auto unit = [d](double elevation, double azimuth) {
+        return std::array<double, 3>{
+            std::cos(elevation * d) * std::cos(azimuth * d),
+            std::cos(elevation * d) * std::sin(azimuth * d),
+            std::sin(elevation * d)};
+      };
+      auto u = unit(body.elevation, body.azimuth), v = unit(el, az);
+      double cross = std::hypot(u[1] * v[2] - u[2] * v[1],
+                                u[2] * v[0] - u[0] * v[2],
+                                u[0] * v[1] - u[1] * v[0]);
+      double dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+      CHECK(std::atan2(cross, dot) / d < kMas);
+      CHECK(std::abs(body.distance_au - position.dis) < 1e-10);
+    }
+    CHECK(compared == kBodies.size());
+  }
+}
+
+TEST_CASE("Ephemeris reads include the frame's", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{51.5074, -0.1278, 35.0};
+  system_clock::time_point time = sys_days{December / 1 / 2025} + 22h;
+
+  // No body passes the name filter, so every read is novas_make_frame's
+  AstrometryEngine engine;
+  FilterCriteria none{.name_filter = "no such body", .active = true};
+  CHECK(engine.CalculateSolarSystem(obs, none, {}, time).empty());
+  auto reads = engine.TakeEphemerisReadStats();
+  CHECK(reads.reads > 0);
+  CHECK(reads.max_us >= reads.mean_us);
+
+  // Taking the stats resets them
+  reads = engine.TakeEphemerisReadStats();
+  CHECK(reads.reads == 0);
+  CHECK(reads.mean_us == 0.0);
+  CHECK(reads.max_us == 0.0);
+}
+
+TEST_CASE("Solar system is the same on any number of threads", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{-33.8688, 151.2093, 58.0};
+  system_clock::time_point time = sys_days{June / 21 / 2025} + 12h;
+  FilterCriteria all_sky;
+  all_sky.active = true;
+
+  // Without an ephemeris every body may run on its own worker
+  AstrometryEngine serial;
+  serial.SetThreadPool(
+      std::make_shared<ThreadPool>(ThreadPoolOptions{.threads = 1}));
+  AstrometryEngine parallel;
+  parallel.SetThreadPool(
+      std::make_shared<ThreadPool>(ThreadPoolOptions{.threads = 4}));
+
+  for (auto window : {hours(0), hours(1)}) {
+    serial.SetPlanetCacheWindow(window);
+    parallel.SetPlanetCacheWindow(window);
+    auto expected = serial.CalculateSolarSystem(obs, all_sky, {}, time);
+    auto actual = parallel.CalculateSolarSystem(obs, all_sky, {}, time);
+    REQUIRE(!expected.empty());
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      CHECK(actual[i].name == expected[i].name);
+      CHECK(actual[i].elevation == expected[i].elevation);
+      CHECK(actual[i].azimuth == expected[i].azimuth);
+      CHECK(actual[i].distance_au == expected[i].distance_au);
+    }
+  }
+}
+
+TEST_CASE("Analytic solar system needs no ephemeris", "[engine]") {
+  using namespace std::chrono;
+  Observer obs{48.8566, 2.3522, 35.0};
+  system_clock::time_point time = sys_days{September / 7 / 2025} + 12h;
+  FilterCriteria all_sky;
+  all_sky.active = true;
+
+  // The planet provider is process-wide: each engine installs its own on
+  // its first calculation, so they are used one after the other
+  AstrometryEngine analytic;
+  analytic.SetSolarSystemMode(SolarSystemMode::ANALYTIC);
+  auto bodies = analytic.CalculateSolarSystem(obs, all_sky, {}, time);
+  std::map<std::string, SolarBody> by_name;
+  for (const auto& body : bodies) by_name[std::string(body.name)] = body;
+  for (const char* name : {"SUN", "MERCURY", "VENUS", "MARS", "JUPITER",
+                           "SATURN", "URANUS", "NEPTUNE", "PLUTO", "MOON"}) {
+    CHECK(by_name.contains(name));
+  }
+  REQUIRE(by_name.contains("MOON"));
+  CHECK(by_name["MOON"].distance_au > 0.0023);
+  CHECK(by_name["MOON"].distance_au < 0.0028);
+
+  // NOVAS's built-in Sun (earth_sun_calc) is a low-precision model, so the
+  // two are only compared to about a minute of arc; the theory itself is
+  // checked to arcseconds in test_analytic_ephemeris.cpp
+  AstrometryEngine standard;
+  auto reference = standard.CalculateSolarSystem(obs, all_sky, {}, time);
+  auto sun = std::ranges::find_if(
+      reference, [](const auto& body) { return body.name == "SUN"; });
+  REQUIRE(sun != reference.end());
+  REQUIRE(by_name.contains("SUN"));
+  CHECK(std::abs(by_name["SUN"].elevation - sun->elevation) < 0.02);
+  CHECK(std::abs(std::remainder(by_name["SUN"].azimuth - sun->azimuth,
+                                360.0)) < 0.02);
+  CHECK(std::abs(by_name["SUN"].distance_au - sun->distance_au) < 1e-4);
+}
+
+TEST_CASE("Sky calculation matches the separate calls", "[engine]") {
+  Observer obs{37.7749, -122.4194, 0.0};
+  auto now = std::chrono::system_clock::now();
+  std::vector<Star> catalog;
+  for (int i = 0; i < 500; ++i) {
+    catalog.push_back(Star{.name = "Star " + std::to_string(i),
+                           .ra = (i * 37) % 360 + 0.25,
+                           .dec = (i * 53) % 170 - 85.0,
+                           .flux = static_cast<float>(i % 5)});
+  }
+
+  AstrometryEngine engine;
+  engine.SetCatalog(catalog);
+
+  SkyQuery query;
+  query.filter.active = true;
+  query.filter.min_elevation = -30.0f;
+  query.filter.star_offset = 10;
+  query.filter.star_limit = 25;
+  query.star_sort = {SortColumn::MAGNITUDE, true};
+  query.solar_sort = {SortColumn::DISTANCE, false};
+
+  ResultBuffer buffer;
+  engine.CalculateSky(buffer, obs, query, now);
+  auto stars = engine.CalculateZenithProximity(obs, query.filter,
+                                               query.star_sort, now);
+  auto bodies = engine.CalculateSolarSystem(obs, query.filter,
+                                            query.solar_sort, now);
+
+  REQUIRE(buffer.star_results.size() == stars.size());
+  for (size_t i = 0; i < stars.size(); ++i) {
+    REQUIRE(buffer.star_results[i].catalog_index == stars[i].catalog_index);
+  }
+
+  REQUIRE(buffer.solar_results.size() == bodies.size());
+  for (size_t i = 0; i < bodies.size(); ++i) {
+    REQUIRE(buffer.solar_results[i].name == bodies[i].name);
+    if (i > 0) {
+      REQUIRE(bodies[i - 1].distance_au >= bodies[i].distance_au);
+    }
+  }
+}
+
+TEST_CASE("Catalog filter drops stars before the build", "[engine]") {
+  Observer obs{37.7749, -122.4194, 0.0};
+  auto now = std::chrono::system_clock::now();
+  std::vector<Star> catalog;
+  for (int i = 0; i < 3000; ++i) {
+    catalog.push_back(Star{.name = "Star " + std::to_string(i),
+                           .ra = (i * 37) % 360 + 0.25,
+                           .dec = (i * 53) % 170 - 85.0,
+                           .coo_qual = static_cast<char>('A' + i % 5),
+                           .flux = static_cast<float>(i % 10)});
+  }
+
+  CatalogFilter filter{.max_magnitude = 6.0f,
+                       .min_dec = -20.0,
+                       .max_dec = 60.0,
+                       .max_coo_qual = 'C'};
+  std::vector<size_t> expected;
+  for (size_t i = 0; i < catalog.size(); ++i) {
+    const auto& star = catalog[i];
+    if (star.flux <= 6.0f && star.dec >= -20.0 && star.dec <= 60.0 &&
+        star.coo_qual <= 'C') {
+      expected.push_back(i);
+    }
+  }
+  REQUIRE(!expected.empty());
+
+  AstrometryEngine engine;
+  // Small grain so the build is split over many tasks
+  engine.SetThreadPool(
+      std::make_shared<ThreadPool>(ThreadPoolOptions{.threads = 4}), 64);
+  engine.SetCatalog(catalog, filter);
+
+  SECTION("Only accepted stars are indexed, under their catalog position") {
+    REQUIRE(engine.GetSkyIndex()->size() == expected.size());
+    CHECK(engine.ConeSearch(0.0, 90.0, 180.0) == expected);
+  }
+
+  SECTION("Results match a catalog filtered beforehand") {
+    std::vector<Star> kept;
+    for (size_t i : expected) kept.push_back(catalog[i]);
+    AstrometryEngine reference;
+    reference.SetCatalog(kept);
+
+    FilterCriteria all{.active = true};
+    auto results = engine.CalculateZenithProximity(obs, all, {}, now);
+    auto reference_results =
+        reference.CalculateZenithProximity(obs, all, {}, now);
+
+    REQUIRE(results.size() == reference_results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      CHECK(results[i].name == reference_results[i].name);
+      CHECK(results[i].catalog_index ==
+            expected[reference_results[i].catalog_index]);
+      CHECK(results[i].elevation == reference_results[i].elevation);
+      CHECK(results[i].elevation_rate == reference_results[i].elevation_rate);
+    }
+  }
+
+  SECTION("Quality limits reject ungraded stars") {
+    std::vector<Star> ungraded = {
+        Star{.name = "Graded", .ra = 10.0, .dec = 10.0, .coo_qual = 'B'},
+        Star{.name = "Ungraded", .ra = 20.0, .dec = 10.0, .coo_qual = ' '}};
+    AstrometryEngine graded;
+    graded.SetCatalog(ungraded, CatalogFilter{.max_coo_qual = 'E'});
+    CHECK(graded.GetSkyIndex()->size() == 1);
+    graded.SetCatalog(ungraded);
+    CHECK(graded.GetSkyIndex()->size() == 2);
+  }
+}
+
+TEST_CASE("Engine owns its star strings", "[engine]") {
+  Observer obs{37.7749, -122.4194, 0.0};
+  auto now = std::chrono::system_clock::now();
+
+  AstrometryEngine engine;
+  {
+    std::vector<Star> catalog = {
+        Star{.name = "Vega",
+             .catalog = "HIP",
+             .ra = 279.235,
+             .dec = 38.784,
+             .ids = "NAME Vega|HIP 91262|* alf Lyr"},
+        Star{.name = "Faint", .catalog = "HIP", .ra = 10.0, .dec = 10.0,
+             .flux = 12.0f, .ids = "HIP 1"},
+        Star{.name = "Polaris", .catalog = "FK5", .ra = 37.95, .dec = 89.26}};
+    engine.SetCatalog(catalog, CatalogFilter{.max_magnitude = 6.0f});
+  }  // The loaded stars are gone; names and ids must not dangle
+
+  SECTION("Names and catalog codes survive the source catalog") {
+    FilterCriteria all{.active = true};
+    auto results = engine.CalculateZenithProximity(obs, all, {}, now);
+    REQUIRE(results.size() == 2);
+    CHECK(results[0].name == "Vega");
+    CHECK(results[1].name == "Polaris");
+  }
+
+  SECTION("Identifiers are split on demand") {
+    auto vega = engine.GetIdentifiers(0);
+    REQUIRE(vega->size() == 3);
+    CHECK((*vega)[0] == "NAME Vega");
+    CHECK((*vega)[1] == "HIP 91262");
+    CHECK((*vega)[2] == "* alf Lyr");
+
+    CHECK(engine.GetIdentifiers(1)->empty());  // Filtered out
+    CHECK(engine.GetIdentifiers(2)->empty());  // No ids
+    CHECK(engine.GetIdentifiers(99)->empty());
+
+    // The views outlive the catalog they were split from
+    engine.SetCatalog(std::span<const Star>{});
+    CHECK((*vega)[1] == "HIP 91262");
+  }
+}
+
+TEST_CASE("Catalog swaps are safe during calculations", "[engine]") {
+  Observer obs{37.7749, -122.4194, 0.0};
+  auto now = std::chrono::system_clock::now();
+  FilterCriteria all{.active = true};
+
+  auto make_catalog = [](const std::string& prefix, int count) {
+    std::vector<Star> catalog;
+    for (int i = 0; i < count; ++i) {
+      catalog.push_back(Star{.name = prefix + std::to_string(i),
+                             .ra = i * 360.0 / count,
+                             .dec = (i % 170) - 85.0});
+    }
+    return catalog;
+  };
+  auto first = make_catalog("First ", 200);
+  auto second = make_catalog("Second ", 300);
+
+  AstrometryEngine engine;
+  engine.SetCatalog(first);
+
+  SECTION("Results keep the catalog they were computed from") {
+    ResultBuffer buffer;
+    engine.CalculateZenithProximity(buffer, obs, all, {}, now);
+    REQUIRE(buffer.star_results.size() == 200);
+
+    engine.SetCatalog(second);
+    for (const auto& result : buffer.star_results) {
+      REQUIRE(result.name.starts_with("First "));
+    }
+    CHECK(engine.CalculateZenithProximity(obs, all, {}, now).size() == 300);
+  }
+
+  SECTION("Every calculation sees one whole catalog") {
+    std::thread swapper([&] {
+      for (int i = 0; i < 20; ++i) {
+        engine.SetCatalog(i % 2 == 0 ? second : first);
+      }
+    });
+
+    ResultBuffer buffer;
+    for (int i = 0; i < 50; ++i) {
+      engine.CalculateZenithProximity(buffer, obs, all, {}, now);
+      size_t count = buffer.star_results.size();
+      REQUIRE((count == 200 || count == 300));
+      std::string prefix = count == 200 ? "First " : "Second ";
+      for (const auto& result : buffer.star_results) {
+        REQUIRE(result.name.starts_with(prefix));
+      }
+    }
+    swapper.join();
+  }
+}
+
+TEST_CASE("Engine snapshot restores the built catalog", "[engine]") {
+  const std::string snapshot_path = "test_engine.snapshot";
+  Observer obs{48.8566, 2.3522, 0.0};
+  auto now = std::chrono::system_clock::now();
+
+  std::vector<Star> catalog;
+  for (int i = 0; i < 3000; ++i) {
+    catalog.push_back(Star{.name = "Star " + std::to_string(i),
+                           .catalog = i % 2 ? "HIP" : "TYC",
+                           .catalog_id = i,
+                           .ra = std::fmod(i * 7.31, 360.0),
+                           .dec = -85.0 + (i * 0.0567),
+                           .pmra = i % 7 ? 0.0 : 250.0,
+                           .parallax = i % 11 ? 0.0 : 90.0,
+                           .flux = static_cast<float>(i % 12),
+                           .ids = "ID " + std::to_string(i)});
+  }
+  CatalogFilter filter{.max_magnitude = 9.0f};
+  constexpr uint64_t kKey = 0x5EED;
+
+  for (auto storage : {CatalogStorage::FULL, CatalogStorage::COMPACT}) {
+    AstrometryEngine built;
+    built.SetCatalogStorage(storage);
+    built.SetCatalog(catalog, filter);
+    REQUIRE(built.SaveSnapshot(snapshot_path, kKey));
+
+    AstrometryEngine restored;
+    restored.SetCatalogStorage(storage);
+    REQUIRE(restored.LoadSnapshot(snapshot_path, kKey, filter));
+
+    FilterCriteria all{.active = true};
+    auto expected = built.CalculateZenithProximity(obs, all, {}, now);
+    auto actual = restored.CalculateZenithProximity(obs, all, {}, now);
+    REQUIRE(!expected.empty());
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+      CHECK(actual[i].name == expected[i].name);
+      CHECK(actual[i].catalog_index == expected[i].catalog_index);
+      CHECK(actual[i].elevation == expected[i].elevation);
+      CHECK(actual[i].azimuth == expected[i].azimuth);
+    }
+    CHECK(restored.GetSkyIndex()->size() == built.GetSkyIndex()->size());
+    CHECK(restored.ConeSearch(45.0, 20.0, 30.0) ==
+          built.ConeSearch(45.0, 20.0, 30.0));
+    CHECK(*restored.GetIdentifiers(expected.front().catalog_index) ==
+          *built.GetIdentifiers(expected.front().catalog_index));
+  }
+
+  SECTION("Any mismatch keeps the current catalog") {
+    AstrometryEngine engine;
+    engine.SetCatalog(catalog, filter);
+    REQUIRE(engine.SaveSnapshot(snapshot_path, kKey));
+    size_t indexed = engine.GetSkyIndex()->size();
+
+    CHECK_FALSE(engine.LoadSnapshot(snapshot_path, kKey + 1, filter));
+    CHECK_FALSE(engine.LoadSnapshot(snapshot_path, kKey, CatalogFilter{}));
+    engine.SetCatalogStorage(CatalogStorage::COMPACT);
+    CHECK_FALSE(engine.LoadSnapshot(snapshot_path, kKey, filter));
+    engine.SetCatalogStorage(CatalogStorage::FULL);
+    CHECK_FALSE(engine.LoadSnapshot("missing.snapshot", kKey, filter));
+
+    auto size = std::filesystem::file_size(snapshot_path);
+    std::filesystem::resize_file(snapshot_path, size - 1);
+    CHECK_FALSE(engine.LoadSnapshot(snapshot_path, kKey, filter));
+    CHECK(engine.GetSkyIndex()->size() == indexed);
+  }
+
+  std::filesystem::remove(snapshot_path);
+}
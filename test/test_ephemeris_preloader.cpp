@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "ephemeris_preloader.hpp"
+
+using namespace engine;
+
+namespace {
+
+constexpr size_t kRecordWords = 128;  // 1024-byte DAF records
+constexpr double kInterval = 4.0 * 86400.0;
+constexpr uint64_t kRecords = 100;
+constexpr uint64_t kRecordSize = 35;  // Words per Chebyshev record
+constexpr uint64_t kOtherWords = 10;
+
+double ToEphemerisTime(std::chrono::system_clock::time_point time) {
+  return std::chrono::duration<double>(time.time_since_epoch()).count() -
+         946728000.0 + 37.0 + 32.184;
+}
+
+// Writes a little-endian SPK file with a type 2 segment of kRecords records
+// of kInterval seconds centered on `center_et`, and a small type 9 segment
+// covering all time.
+void WriteMockSpk(const std::filesystem::path& path, double center_et) {
+  const uint64_t type2_begin = 3 * kRecordWords + 1;
+  const uint64_t type2_end = type2_begin + kRecords * kRecordSize + 4 - 1;
+  const uint64_t other_begin = type2_end + 1;
+  const uint64_t other_end = other_begin + kOtherWords - 1;
+  std::vector<double> words(other_end, 0.0);
+
+  auto put_int = [&](size_t word, size_t half, int32_t value) {
+    std::memcpy(reinterpret_cast<char*>(&words[word]) + 4 * half, &value, 4);
+  };
+  auto put_text = [&](size_t byte, const char* text) {
+    std::memcpy(reinterpret_cast<char*>(words.data()) + byte, text,
+                std::strlen(text));
+  };
+
+  // File record: ND, NI, first and last summary record, format
+  put_text(0, "DAF/SPK ");
+  put_int(1, 0, 2);
+  put_int(1, 1, 6);
+  put_int(9, 1, 2);   // FWARD at byte 76
+  put_int(10, 0, 2);  // BWARD at byte 80
+  put_text(88, "LTL-IEEE");
+
+  // Summary record: next, previous, count, then 5 words per segment
+  double* summary = &words[kRecordWords];
+  summary[2] = 2.0;
+  const double init = center_et - kInterval * (kRecords / 2);
+  summary[3] = init;
+  summary[4] = init + kInterval * kRecords;
+  put_int(kRecordWords + 5, 0, 301);  // Target, center
+  put_int(kRecordWords + 5, 1, 3);
+  put_int(kRecordWords + 6, 0, 1);  // Frame, type
+  put_int(kRecordWords + 6, 1, 2);
+  put_int(kRecordWords + 7, 0, static_cast<int32_t>(type2_begin));
+  put_int(kRecordWords + 7, 1, static_cast<int32_t>(type2_end));
+  summary[8] = -1e12;
+  summary[9] = 1e12;
+  put_int(kRecordWords + 10, 0, 1000);
+  put_int(kRecordWords + 10, 1, 0);
+  put_int(kRecordWords + 11, 0, 1);
+  put_int(kRecordWords + 11, 1, 9);
+  put_int(kRecordWords + 12, 0, static_cast<int32_t>(other_begin));
+  put_int(kRecordWords + 12, 1, static_cast<int32_t>(other_end));
+
+  // Type 2 trailer: INIT, INTLEN, RSIZE, N
+  double* trailer = &words[type2_end - 4];
+  trailer[0] = init;
+  trailer[1] = kInterval;
+  trailer[2] = static_cast<double>(kRecordSize);
+  trailer[3] = static_cast<double>(kRecords);
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(words.data()),
+             static_cast<std::streamsize>(words.size() * sizeof(double)));
+}
+
+}  // namespace
+
+TEST_CASE("Ephemeris preloader reads the records around the time",
+          "[engine][ephemeris]") {
+  using namespace std::chrono;
+  const std::filesystem::path path = "test_preload.bsp";
+  system_clock::time_point time = sys_days{March / 20 / 2025} + 6h;
+  // Put the time a quarter into record 50, so spans are easy to count
+  WriteMockSpk(path, ToEphemerisTime(time) - kInterval / 4.0);
+
+  {
+    // Eight days: two records either side of the one holding `time`
+    auto preloader = EphemerisPreloader::Open(path, hours(8 * 24));
+    REQUIRE(preloader);
+    CHECK(preloader->segment_count() == 2);
+
+    preloader->Preload(time);
+    auto stats = preloader->stats();
+    CHECK(stats.loads == 1);
+    CHECK(stats.bytes == (3 * kRecordSize + kOtherWords) * 8);
+    CHECK_FALSE(stats.stalled);
+
+    // Inside the span nothing is read
+    preloader->Advance(time + hours(24));
+    CHECK(preloader->stats().loads == 1);
+
+    // The last quarter starts the next span in the background
+    preloader->Advance(time + hours(3 * 24 + 12));
+    for (int i = 0; i < 200 && preloader->stats().loads < 2; ++i) {
+      std::this_thread::sleep_for(milliseconds(5));
+      preloader->Advance(time + hours(3 * 24 + 12));
+    }
+    CHECK(preloader->stats().loads == 2);
+    CHECK_FALSE(preloader->stats().stalled);
+    CHECK(preloader->stats().resident_bytes > stats.bytes);
+
+    // Inside the extended span nothing more is read
+    preloader->Advance(time + hours(6 * 24));
+    CHECK_FALSE(preloader->stats().stalled);
+
+    // A jump is read before it is used, and releases the old spans
+    preloader->Advance(time + hours(100 * 24));
+    CHECK(preloader->stats().stalled);
+    CHECK(preloader->stats().resident_bytes == preloader->stats().bytes);
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Ephemeris preloader rejects other files", "[engine][ephemeris]") {
+  const std::filesystem::path path = "test_preload.txt";
+  {
+    std::ofstream file(path);
+    file << std::string(2048, 'x');
+  }
+  CHECK_FALSE(EphemerisPreloader::Open(path, std::chrono::hours(24)));
+  CHECK_FALSE(
+      EphemerisPreloader::Open("missing.bsp", std::chrono::hours(24)));
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "engine.hpp"
+#include "sky_index.hpp"
+
+using namespace engine;
+
+namespace {
+
+struct Points {
+  std::vector<double> x, y, z;
+};
+
+Points RandomPoints(size_t count) {
+  std::mt19937 gen(7);
+  std::normal_distribution<double> dist;
+  Points p;
+  for (size_t i = 0; i < count; ++i) {
+    double a = dist(gen), b = dist(gen), c = dist(gen);
+    double r = std::sqrt(a * a + b * b + c * c);
+    p.x.push_back(a / r);
+    p.y.push_back(b / r);
+    p.z.push_back(c / r);
+  }
+  return p;
+}
+
+}  // namespace
+
+TEST_CASE("Sky tiles are nested and equal-area", "[engine][sky_index]") {
+  auto points = RandomPoints(48000);
+
+  SECTION("Parent of a tile is the tile one level up") {
+    for (size_t i = 0; i < points.x.size(); ++i) {
+      SkyVector v{points.x[i], points.y[i], points.z[i]};
+      for (int depth = 1; depth <= 8; ++depth) {
+        auto tile = SkyIndex::TileOf(v, depth);
+        REQUIRE(tile < SkyIndex::TileCount(depth));
+        REQUIRE((tile >> 2) == SkyIndex::TileOf(v, depth - 1));
+      }
+    }
+  }
+
+  SECTION("Uniform points fill the base tiles evenly") {
+    std::vector<size_t> counts(SkyIndex::TileCount(1));
+    for (size_t i = 0; i < points.x.size(); ++i) {
+      ++counts[SkyIndex::TileOf({points.x[i], points.y[i], points.z[i]}, 1)];
+    }
+    // 1000 expected per tile; 5 sigma is ~160
+    for (auto count : counts) {
+      REQUIRE(count > 840);
+      REQUIRE(count < 1160);
+    }
+  }
+
+  SECTION("Members are a permutation grouped by tile") {
+    SkyIndex index;
+    index.Build(points.x, points.y, points.z, 3);
+    REQUIRE(index.size() == points.x.size());
+
+    std::vector<bool> seen(points.x.size(), false);
+    for (uint32_t tile = 0; tile < SkyIndex::TileCount(3); ++tile) {
+      auto members = index.Members(tile);
+      for (uint32_t k = members.begin; k < members.end; ++k) {
+        auto i = index.order()[k];
+        REQUIRE_FALSE(seen[i]);
+        seen[i] = true;
+        REQUIRE(SkyIndex::TileOf({points.x[i], points.y[i], points.z[i]},
+                                 3) == tile);
+      }
+    }
+  }
+}
+
+TEST_CASE("Sky index region queries are complete", "[engine][sky_index]") {
+  auto points = RandomPoints(20000);
+  SkyIndex index;
+  index.Build(points.x, points.y, points.z);
+
+  auto axis = SkyVector::FromRaDec(30.0, 40.0);
+  for (double max_angle : {0.05, 0.3, 1.0, 2.5}) {
+    double min_angle = max_angle / 2.0;
+    std::vector<SkyRange> ranges;
+    index.QueryAnnulus(axis, min_angle, max_angle, ranges);
+
+    std::vector<bool> returned(points.x.size(), false);
+    size_t scanned = 0;
+    for (const auto& range : ranges) {
+      for (uint32_t k = range.begin; k < range.end; ++k) {
+        returned[index.order()[k]] = true;
+        ++scanned;
+      }
+    }
+
+    for (size_t i = 0; i < points.x.size(); ++i) {
+      double angle = std::acos(std::clamp(
+          axis.Dot({points.x[i], points.y[i], points.z[i]}), -1.0, 1.0));
+      if (angle >= min_angle && angle <= max_angle) {
+        REQUIRE(returned[i]);
+      }
+    }
+    if (max_angle < 1.0) {
+      REQUIRE(scanned < points.x.size() / 2);
+    }
+  }
+}
+
+TEST_CASE("Engine cone search", "[engine][sky_index]") {
+  std::vector<Star> catalog = {
+      Star{.name = "Vega", .ra = 279.235, .dec = 38.784},
+      Star{.name = "Sirius", .ra = 101.287, .dec = -16.716},
+      Star{.name = "Near Vega", .ra = 280.0, .dec = 39.5},
+      Star{.name = "Polaris", .ra = 37.954, .dec = 89.264}};
+
+  AstrometryEngine engine;
+  engine.SetCatalog(catalog);
+  REQUIRE(engine.GetSkyIndex()->size() == catalog.size());
+
+  auto around_vega = engine.ConeSearch(279.235, 38.784, 2.0);
+  REQUIRE(around_vega == std::vector<size_t>{0, 2});
+
+  auto around_pole = engine.ConeSearch(0.0, 90.0, 1.0);
+  REQUIRE(around_pole == std::vector<size_t>{3});
+}
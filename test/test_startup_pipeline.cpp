@@ -0,0 +1,100 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "startup_pipeline.hpp"
+
+using namespace engine;
+
+namespace {
+
+// Writes a CSV catalog whose i-th star has magnitude i % 10
+void WriteCatalog(const std::filesystem::path& path, int count) {
+  std::ofstream file(path, std::ios::binary);
+  file << "name,catalog,catalog_id,ra,dec,coo_qual,pmra,pmdec,pm_qual,"
+          "parallax,plx_qual,radial_velocity,rvz_qual,flux\n";
+  for (int i = 0; i < count; ++i) {
+    file << "Star " << i << ",HIP," << i << "," << (i * 7) % 360 << ","
+         << (i * 13) % 180 - 90 << ",A,0,0,A,0,A,0,A," << i % 10 << "\n";
+  }
+}
+
+struct Publication {
+  std::shared_ptr<const AstrometryEngine> engine;
+  StartupStage stage;
+};
+
+}  // namespace
+
+TEST_CASE("Startup pipeline publishes bright stars first",
+          "[engine][startup]") {
+  const std::filesystem::path path = "test_startup.csv";
+  WriteCatalog(path, 1000);
+
+  std::mutex mutex;
+  std::vector<Publication> published;
+  auto record = [&](std::shared_ptr<const AstrometryEngine> engine,
+                    StartupStage stage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    published.push_back({std::move(engine), stage});
+  };
+
+  SECTION("Large catalogs in two stages") {
+    StartupPipeline pipeline(
+        {.catalog_path = path, .bright_magnitude = 4.5f,
+         .progressive_stars = 100},
+        record);
+    pipeline.Wait();
+    CHECK(pipeline.stage() == StartupStage::COMPLETE);
+
+    REQUIRE(published.size() == 2);
+    CHECK(published[0].stage == StartupStage::BRIGHT_READY);
+    CHECK(published[0].engine->GetStarCount() == 500);  // Magnitudes 0-4
+    CHECK(published[1].stage == StartupStage::COMPLETE);
+    CHECK(published[1].engine->GetStarCount() == 1000);
+
+    auto timings = pipeline.timings();
+    CHECK(timings.catalog_loaded_ms >= 0.0);
+    CHECK(timings.ephemeris_ready_ms >= 0.0);
+    CHECK(timings.bright_ready_ms >= timings.catalog_loaded_ms);
+    CHECK(timings.complete_ms >= timings.bright_ready_ms);
+  }
+
+  SECTION("Small catalogs at once") {
+    StartupPipeline pipeline({.catalog_path = path}, record);
+    pipeline.Wait();
+
+    REQUIRE(published.size() == 1);
+    CHECK(published[0].stage == StartupStage::COMPLETE);
+    CHECK(published[0].engine->GetStarCount() == 1000);
+    CHECK(pipeline.timings().bright_ready_ms < 0.0);
+  }
+
+  SECTION("A load-time filter at least as strict skips the bright stage") {
+    CatalogFilter filter;
+    filter.max_magnitude = 2.5f;
+    StartupPipeline pipeline(
+        {.catalog_path = path, .filter = filter, .progressive_stars = 100},
+        record);
+    pipeline.Wait();
+
+    REQUIRE(published.size() == 1);
+    CHECK(published[0].engine->GetStarCount() == 300);
+  }
+
+  SECTION("Missing catalogs fail") {
+    StartupPipeline pipeline({.catalog_path = "missing_startup.csv"}, record);
+    pipeline.Wait();
+
+    CHECK(pipeline.stage() == StartupStage::FAILED);
+    REQUIRE(published.size() == 1);
+    CHECK(published[0].stage == StartupStage::FAILED);
+    CHECK_FALSE(published[0].engine);
+  }
+
+  std::filesystem::remove(path);
+}
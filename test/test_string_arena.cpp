@@ -0,0 +1,48 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_arena.hpp"
+
+using namespace engine;
+
+TEST_CASE("String arena keeps views stable", "[engine][arena]") {
+  StringArena arena(64);
+
+  std::vector<std::string> originals;
+  std::vector<std::string_view> views;
+  for (int i = 0; i < 1000; ++i) {
+    originals.push_back("Star " + std::to_string(i));
+    views.push_back(arena.Store(originals.back()));
+  }
+  // Larger than a block, so it gets one of its own
+  std::string long_ids(500, 'x');
+  auto long_view = arena.Store(long_ids);
+
+  for (size_t i = 0; i < originals.size(); ++i) {
+    REQUIRE(views[i] == originals[i]);
+    REQUIRE(views[i].data() != originals[i].data());
+  }
+  CHECK(long_view == long_ids);
+  CHECK(arena.Store("").empty());
+
+  size_t expected_bytes = long_ids.size();
+  for (const auto& s : originals) expected_bytes += s.size();
+  CHECK(arena.bytes() == expected_bytes);
+}
+
+TEST_CASE("String arena interns repeated strings", "[engine][arena]") {
+  StringArena arena;
+
+  std::string hip = "HIP";
+  auto first = arena.Intern(hip);
+  hip[0] = 'X';  // The arena holds its own copy
+  auto second = arena.Intern(std::string("HIP"));
+  auto other = arena.Intern("FK5");
+
+  CHECK(first == "HIP");
+  CHECK(first.data() == second.data());
+  CHECK(other == "FK5");
+  CHECK(arena.interned() == 2);
+}
@@ -0,0 +1,90 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine.hpp"
+#include "thread_pool.hpp"
+
+using namespace engine;
+
+TEST_CASE("Thread pool runs every index once", "[engine][thread_pool]") {
+  for (size_t threads : {1, 3, 8}) {
+    ThreadPool pool({.threads = threads});
+    REQUIRE(pool.size() == threads);
+
+    for (size_t grain : {1, 7, 100000}) {
+      std::vector<int> hits(10007, 0);
+      pool.ParallelFor(hits.size(), grain, [&](size_t i) { ++hits[i]; });
+      for (int h : hits) {
+        REQUIRE(h == 1);
+      }
+    }
+  }
+}
+
+TEST_CASE("Thread pool nesting and outside callers", "[engine][thread_pool]") {
+  ThreadPool pool({.threads = 4});
+
+  SECTION("Nested loops complete on the workers") {
+    std::atomic<size_t> total{0};
+    pool.ParallelFor(16, 1, [&](size_t) {
+      pool.ParallelFor(100, 3, [&](size_t) { ++total; });
+    });
+    REQUIRE(total == 1600);
+  }
+
+  SECTION("Invoke runs both callables") {
+    int a = 0, b = 0;
+    pool.Invoke([&] { a = 1; }, [&] { b = 2; });
+    REQUIRE(a == 1);
+    REQUIRE(b == 2);
+  }
+
+  SECTION("Several threads share one pool") {
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t) {
+      callers.emplace_back([&] {
+        for (int r = 0; r < 50; ++r) {
+          pool.ParallelFor(1000, 16, [&](size_t) { ++total; });
+        }
+      });
+    }
+    for (auto& caller : callers) caller.join();
+    REQUIRE(total == 4 * 50 * 1000);
+  }
+}
+
+TEST_CASE("Engine results do not depend on the pool", "[engine][thread_pool]") {
+  Observer obs{37.7749, -122.4194, 0.0};
+  auto now = std::chrono::system_clock::now();
+  std::vector<Star> catalog;
+  for (int i = 0; i < 5000; ++i) {
+    catalog.push_back(Star{.name = "Star " + std::to_string(i),
+                           .ra = (i * 37) % 360 + 0.25,
+                           .dec = (i * 53) % 170 - 85.0,
+                           .flux = static_cast<float>(i % 9)});
+  }
+
+  FilterCriteria filter;
+  filter.active = true;
+  SortCriteria sort{SortColumn::MAGNITUDE, true};
+
+  AstrometryEngine engine;
+  engine.SetCatalog(catalog);
+  auto expected = engine.CalculateZenithProximity(obs, filter, sort, now);
+
+  engine.SetThreadPool(std::make_shared<ThreadPool>(
+                           ThreadPoolOptions{.threads = 2, .cpus = {0}}),
+                       512);
+  auto pinned = engine.CalculateZenithProximity(obs, filter, sort, now);
+
+  REQUIRE(pinned.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    REQUIRE(pinned[i].catalog_index == expected[i].catalog_index);
+  }
+}